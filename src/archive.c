@@ -0,0 +1,556 @@
+/**
+ * @file archive.c
+ * @brief Data files packed into a single memory-mapped archive
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: archive.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "archive.h"
+#include "log_recorder.h"
+#include <sys/mman.h>
+
+/*
+ * The archive is made of a header, a hash table of the names
+ * (open addressing, linear probing), the entries, the names,
+ * then the content of the files aligned on 16 bytes.
+ * The values are stored in the byte order of the machine
+ * which packed it.
+ */
+
+#define ARCHIVE_MAGIC "MDARCHV1"
+#define ARCHIVE_ALIGN(size) (((size) + 15) & ~15U)
+
+typedef struct archive_header
+{
+  /** "MDARCHV1" */
+  char magic[8];
+  /** Number of files */
+  Uint32 num_of_entries;
+  /** Size of the hash table, a power of 2 */
+  Uint32 num_of_buckets;
+  /** Offset of the hash table */
+  Uint32 buckets_offset;
+  /** Offset of the entries table */
+  Uint32 entries_offset;
+  /** Size of the whole archive in bytes */
+  Uint32 size;
+} archive_header;
+
+typedef struct archive_entry
+{
+  /** FNV-1a hash of the name */
+  Uint32 hash;
+  /** Offset of the name, ie "graphics/sprites/all_enemies.spr" */
+  Uint32 name_offset;
+  /** Offset of the file content */
+  Uint32 offset;
+  /** Size of the file in bytes */
+  Uint32 size;
+} archive_entry;
+
+/** The data directories packed into the archive */
+static const char *archive_directories[] =
+  { "data", "graphics", "sounds", "texts", NULL };
+/** File used to locate the data directory */
+#define ARCHIVE_PROBE_FILE "graphics/256_colors_palette.bin"
+
+/** Archive mapped read-only, NULL if none */
+static char *archive = NULL;
+static Uint32 archive_size = 0;
+static const Uint32 *archive_buckets = NULL;
+static const archive_entry *archive_entries = NULL;
+static Uint32 archive_num_of_buckets = 0;
+/** Time of last modification of the archive file */
+static Uint32 archive_time = 0;
+
+/** List of the files to pack */
+static char **pack_names = NULL;
+static Uint32 pack_num_of_names = 0;
+static Uint32 pack_max_of_names = 0;
+
+static bool archive_scan (const char *root, const char *dir);
+static void archive_pack_free (void);
+
+/**
+ * Map an archive read-only, all the data files are then read from it.
+ * The whole archive is read ahead in a single sequential read
+ * @param filename Filename of the archive built with --packarchive
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+archive_open (const char *filename)
+{
+  int fd, flags;
+  Uint32 i;
+  struct stat sb;
+  void *map;
+  const archive_header *header;
+  const archive_entry *entry;
+  const Uint32 *bucket;
+  fd = open (filename, O_RDONLY);
+  if (fd < 0)
+    {
+      LOG_ERR ("can't open archive %s (%s)", filename, strerror (errno));
+      return FALSE;
+    }
+  if (fstat (fd, &sb) || sb.st_size < (off_t) sizeof (archive_header))
+    {
+      close (fd);
+      LOG_ERR ("%s is not a valid archive", filename);
+      return FALSE;
+    }
+  flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  flags |= MAP_POPULATE;
+#endif
+  map = mmap (NULL, sb.st_size, PROT_READ, flags, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      LOG_ERR ("mmap(%s) failed: %s", filename, strerror (errno));
+      return FALSE;
+    }
+  header = (const archive_header *) map;
+  if (memcmp (header->magic, ARCHIVE_MAGIC, sizeof (header->magic))
+      || header->size != (Uint32) sb.st_size
+      || header->num_of_buckets == 0
+      || (header->num_of_buckets & (header->num_of_buckets - 1))
+      || header->buckets_offset > header->size
+      || header->num_of_buckets >
+      (header->size - header->buckets_offset) / sizeof (Uint32)
+      || header->entries_offset > header->size
+      || header->num_of_entries >
+      (header->size - header->entries_offset) / sizeof (archive_entry)
+      || header->num_of_entries >= header->num_of_buckets)
+    {
+      munmap (map, sb.st_size);
+      LOG_ERR ("%s is not a valid archive", filename);
+      return FALSE;
+    }
+  entry = (const archive_entry *) ((char *) map + header->entries_offset);
+  for (i = 0; i < header->num_of_entries; i++, entry++)
+    {
+      if (entry->name_offset >= header->size
+          || entry->offset > header->size
+          || entry->size > header->size - entry->offset
+          || memchr ((char *) map + entry->name_offset, '\0',
+                     header->size - entry->name_offset) == NULL)
+        {
+          munmap (map, sb.st_size);
+          LOG_ERR ("%s is corrupted", filename);
+          return FALSE;
+        }
+    }
+  /* archive_find() reads the entries of the buckets unchecked, and
+   * stops its probing at an empty bucket: there is at least one */
+  bucket = (const Uint32 *) ((char *) map + header->buckets_offset);
+  for (i = 0; i < header->num_of_buckets; i++, bucket++)
+    {
+      if (*bucket > header->num_of_entries)
+        {
+          munmap (map, sb.st_size);
+          LOG_ERR ("%s is corrupted", filename);
+          return FALSE;
+        }
+    }
+  archive = (char *) map;
+  archive_size = header->size;
+  archive_buckets = (const Uint32 *) (archive + header->buckets_offset);
+  archive_entries =
+    (const archive_entry *) (archive + header->entries_offset);
+  archive_num_of_buckets = header->num_of_buckets;
+  archive_time = (Uint32) sb.st_mtime;
+  LOG_INF ("%i files mapped from %s (%i bytes)", header->num_of_entries,
+           filename, archive_size);
+  return TRUE;
+}
+
+/**
+ * Search a file in the archive
+ * @param name Name of file relative to data directory
+ * @param size Pointer receiving the size of the file in bytes
+ * @return Pointer to the read-only file content, NULL if not found
+ */
+char *
+archive_find (const char *name, Uint32 * size)
+{
+  Uint32 hash, index, i;
+  const archive_entry *entry;
+  if (archive == NULL)
+    {
+      return NULL;
+    }
+  hash = hash_fnv1a (HASH_FNV1A_INIT, name, strlen (name));
+  i = hash & (archive_num_of_buckets - 1);
+  while ((index = archive_buckets[i]) != 0)
+    {
+      entry = &archive_entries[index - 1];
+      if (entry->hash == hash && !strcmp (archive + entry->name_offset, name))
+        {
+          *size = entry->size;
+          return archive + entry->offset;
+        }
+      i = (i + 1) & (archive_num_of_buckets - 1);
+    }
+  return NULL;
+}
+
+/**
+ * Check if a buffer belongs to the archive mapping
+ * @param data Pointer to a buffer
+ * @return TRUE if the data is read from the archive
+ */
+bool
+archive_contains (const void *data)
+{
+  return archive != NULL && (const char *) data >= archive
+    && (const char *) data < archive + archive_size;
+}
+
+/**
+ * Return the time of last modification of the archive, the one of
+ * the files read from it
+ * @return Time in seconds since the Epoch, 0 if no archive is mapped
+ */
+Uint32
+archive_mtime (void)
+{
+  return archive == NULL ? 0 : archive_time;
+}
+
+/**
+ * Unmap the archive
+ */
+void
+archive_close (void)
+{
+  if (archive != NULL)
+    {
+      munmap (archive, archive_size);
+      archive = NULL;
+      archive_size = 0;
+      archive_buckets = NULL;
+      archive_entries = NULL;
+      archive_num_of_buckets = 0;
+    }
+}
+
+/**
+ * Compare two names, used by qsort()
+ */
+static int
+archive_compare_names (const void *a, const void *b)
+{
+  return strcmp (*(char *const *) a, *(char *const *) b);
+}
+
+/**
+ * Pack all the data files into an archive
+ * @param filename Filename of the archive to build
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+archive_pack (const char *filename)
+{
+  Uint32 i, j, hash, names_size, data_offset, filesize;
+  Uint32 *buckets = NULL;
+  archive_entry *entries = NULL;
+  archive_header header;
+  char *pathname, *root = NULL, *content;
+  FILE *fstream = NULL;
+  bool is_packed = FALSE;
+
+  /* the data directory is the one where the palette is found */
+  pathname = locate_data_file (ARCHIVE_PROBE_FILE);
+  if (pathname == NULL)
+    {
+      LOG_ERR ("can't locate the data directory");
+      return FALSE;
+    }
+  root = string_duplicate (pathname);
+  free_memory (pathname);
+  if (root == NULL)
+    {
+      return FALSE;
+    }
+  root[strlen (root) - strlen (ARCHIVE_PROBE_FILE)] = '\0';
+  for (i = 0; archive_directories[i] != NULL; i++)
+    {
+      if (!archive_scan (root, archive_directories[i]))
+        {
+          goto end;
+        }
+    }
+  qsort (pack_names, pack_num_of_names, sizeof (char *),
+         archive_compare_names);
+
+  /* hash table at most half full */
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, ARCHIVE_MAGIC, sizeof (header.magic));
+  header.num_of_entries = pack_num_of_names;
+  header.num_of_buckets = 16;
+  while (header.num_of_buckets < pack_num_of_names * 2)
+    {
+      header.num_of_buckets *= 2;
+    }
+  buckets =
+    (Uint32 *) memory_allocation (header.num_of_buckets * sizeof (Uint32));
+  entries =
+    (archive_entry *) memory_allocation (pack_num_of_names *
+                                         sizeof (archive_entry) + 1);
+  if (buckets == NULL || entries == NULL)
+    {
+      LOG_ERR ("not enough memory to index %i files", pack_num_of_names);
+      goto end;
+    }
+  memset (buckets, 0, header.num_of_buckets * sizeof (Uint32));
+  header.buckets_offset = ARCHIVE_ALIGN (sizeof (archive_header));
+  header.entries_offset =
+    header.buckets_offset + header.num_of_buckets * sizeof (Uint32);
+  names_size = header.entries_offset + pack_num_of_names *
+    sizeof (archive_entry);
+  for (i = 0; i < pack_num_of_names; i++)
+    {
+      hash = hash_fnv1a (HASH_FNV1A_INIT, pack_names[i],
+                         strlen (pack_names[i]));
+      entries[i].hash = hash;
+      entries[i].name_offset = names_size;
+      names_size += strlen (pack_names[i]) + 1;
+      j = hash & (header.num_of_buckets - 1);
+      while (buckets[j] != 0)
+        {
+          j = (j + 1) & (header.num_of_buckets - 1);
+        }
+      buckets[j] = i + 1;
+    }
+
+  fstream = fopen (filename, "wb");
+  if (fstream == NULL)
+    {
+      LOG_ERR ("can't create %s (%s)", filename, strerror (errno));
+      goto end;
+    }
+
+  /* write the content of the files */
+  data_offset = ARCHIVE_ALIGN (names_size);
+  for (i = 0; i < pack_num_of_names; i++)
+    {
+      pathname = memory_allocation (strlen (root) + strlen (pack_names[i]) + 1);
+      if (pathname == NULL)
+        {
+          LOG_ERR ("not enough memory");
+          goto end;
+        }
+      strcpy (pathname, root);
+      strcat (pathname, pack_names[i]);
+      content = load_absolute_file (pathname, &filesize);
+      free_memory (pathname);
+      if (content == NULL)
+        {
+          goto end;
+        }
+      entries[i].offset = data_offset;
+      entries[i].size = filesize;
+      if (fseek (fstream, data_offset, SEEK_SET)
+          || fwrite (content, 1, filesize, fstream) != filesize)
+        {
+          free_memory (content);
+          LOG_ERR ("write to %s failed: %s", filename, strerror (errno));
+          goto end;
+        }
+      free_memory (content);
+      data_offset = ARCHIVE_ALIGN (data_offset + filesize);
+    }
+  header.size = data_offset;
+
+  /* write the header, the index and the names */
+  if (fseek (fstream, 0, SEEK_SET)
+      || fwrite (&header, sizeof (header), 1, fstream) != 1
+      || fseek (fstream, header.buckets_offset, SEEK_SET)
+      || fwrite (buckets, sizeof (Uint32), header.num_of_buckets,
+                 fstream) != header.num_of_buckets
+      || fwrite (entries, sizeof (archive_entry), pack_num_of_names,
+                 fstream) != pack_num_of_names)
+    {
+      LOG_ERR ("write to %s failed: %s", filename, strerror (errno));
+      goto end;
+    }
+  for (i = 0; i < pack_num_of_names; i++)
+    {
+      if (fwrite (pack_names[i], strlen (pack_names[i]) + 1, 1, fstream) != 1)
+        {
+          LOG_ERR ("write to %s failed: %s", filename, strerror (errno));
+          goto end;
+        }
+    }
+  /* the last file may end before the alignment */
+  if (ftruncate (fileno (fstream), header.size))
+    {
+      LOG_ERR ("ftruncate(%s) failed: %s", filename, strerror (errno));
+      goto end;
+    }
+  is_packed = TRUE;
+  LOG_INF ("%i files packed into %s (%i bytes)", pack_num_of_names,
+           filename, header.size);
+
+end:
+  if (fstream != NULL && fclose (fstream) && is_packed)
+    {
+      LOG_ERR ("fclose(%s) failed: %s", filename, strerror (errno));
+      is_packed = FALSE;
+    }
+  if (buckets != NULL)
+    {
+      free_memory ((char *) buckets);
+    }
+  if (entries != NULL)
+    {
+      free_memory ((char *) entries);
+    }
+  if (root != NULL)
+    {
+      free_memory (root);
+    }
+  archive_pack_free ();
+  return is_packed;
+}
+
+/**
+ * Add recursively the files of a data directory to the list of the
+ * files to pack, the Makefiles and the hidden files are skipped
+ * @param root Data directory ending with a slash
+ * @param dir Directory relative to the data directory
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+archive_scan (const char *root, const char *dir)
+{
+  DIR *dirp;
+  struct dirent *dp;
+  struct stat sb;
+  char *pathname, *name = NULL, **names;
+  pathname = memory_allocation (strlen (root) + strlen (dir) + 1);
+  if (pathname == NULL)
+    {
+      LOG_ERR ("not enough memory");
+      return FALSE;
+    }
+  strcpy (pathname, root);
+  strcat (pathname, dir);
+  dirp = opendir (pathname);
+  free_memory (pathname);
+  if (dirp == NULL)
+    {
+      LOG_ERR ("opendir(%s%s) failed: %s", root, dir, strerror (errno));
+      return FALSE;
+    }
+  while ((dp = readdir (dirp)) != NULL)
+    {
+      if (dp->d_name[0] == '.' || !strncmp (dp->d_name, "Makefile", 8))
+        {
+          continue;
+        }
+      name = memory_allocation (strlen (dir) + 1 + strlen (dp->d_name) + 1);
+      pathname = memory_allocation (strlen (root) + strlen (dir) + 1 +
+                                    strlen (dp->d_name) + 1);
+      if (name == NULL || pathname == NULL)
+        {
+          LOG_ERR ("not enough memory");
+          break;
+        }
+      sprintf (name, "%s/%s", dir, dp->d_name);
+      sprintf (pathname, "%s%s", root, name);
+      if (stat (pathname, &sb))
+        {
+          LOG_ERR ("stat(%s) failed: %s", pathname, strerror (errno));
+          break;
+        }
+      free_memory (pathname);
+      pathname = NULL;
+      if (S_ISDIR (sb.st_mode))
+        {
+          if (!archive_scan (root, name))
+            {
+              break;
+            }
+          free_memory (name);
+          continue;
+        }
+      if (pack_num_of_names >= pack_max_of_names)
+        {
+          pack_max_of_names = pack_max_of_names == 0 ? 256
+            : pack_max_of_names * 2;
+          names =
+            (char **) memory_allocation (pack_max_of_names * sizeof (char *));
+          if (names == NULL)
+            {
+              LOG_ERR ("not enough memory");
+              break;
+            }
+          if (pack_names != NULL)
+            {
+              memcpy (names, pack_names, pack_num_of_names * sizeof (char *));
+              free_memory ((char *) pack_names);
+            }
+          pack_names = names;
+        }
+      pack_names[pack_num_of_names++] = name;
+    }
+  if (dp != NULL)
+    {
+      if (name != NULL)
+        {
+          free_memory (name);
+        }
+      if (pathname != NULL)
+        {
+          free_memory (pathname);
+        }
+      closedir (dirp);
+      return FALSE;
+    }
+  closedir (dirp);
+  return TRUE;
+}
+
+/**
+ * Release the list of the files to pack
+ */
+static void
+archive_pack_free (void)
+{
+  Uint32 i;
+  if (pack_names == NULL)
+    {
+      return;
+    }
+  for (i = 0; i < pack_num_of_names; i++)
+    {
+      free_memory (pack_names[i]);
+    }
+  free_memory ((char *) pack_names);
+  pack_names = NULL;
+  pack_num_of_names = 0;
+  pack_max_of_names = 0;
+}
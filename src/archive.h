@@ -0,0 +1,45 @@
+/**
+ * @file archive.h
+ * @brief Data files packed into a single memory-mapped archive
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: archive.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __ARCHIVE__
+#define __ARCHIVE__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  bool archive_open (const char *filename);
+  char *archive_find (const char *name, Uint32 * size);
+  bool archive_contains (const void *data);
+  Uint32 archive_mtime (void);
+  void archive_close (void);
+  bool archive_pack (const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file arena.c
+ * @brief Bump allocators released in one go
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: arena.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "log_recorder.h"
+#include "arena.h"
+
+arena frame_arena = { "frame", NULL, 0, 0, 0 };
+
+/**
+ * Allocate the memory of an arena
+ * @param scope Pointer to the arena
+ * @param name Name of the arena for the statistics
+ * @param size Size of the arena in bytes
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+arena_create (arena * scope, const char *name, Uint32 size)
+{
+  scope->name = name;
+  scope->size = ARENA_SIZE (size);
+  scope->used = 0;
+  scope->max_used = 0;
+  scope->base = memory_allocation (scope->size);
+  if (scope->base == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate the %s arena (%i bytes)",
+               name, scope->size);
+      scope->size = 0;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/**
+ * Release the memory of an arena, and all the blocks it holds
+ * @param scope Pointer to the arena
+ */
+void
+arena_destroy (arena * scope)
+{
+  if (scope->base == NULL)
+    {
+      return;
+    }
+  LOG_DBG ("%s arena: %i bytes used of %i", scope->name, scope->max_used,
+           scope->size);
+  free_memory (scope->base);
+  scope->base = NULL;
+  scope->size = 0;
+  scope->used = 0;
+}
+
+/**
+ * Take a block from an arena, the memory is cleared
+ * @param scope Pointer to the arena
+ * @param size Size in bytes of the block
+ * @return Pointer to the block or NULL if the arena is full
+ */
+char *
+arena_alloc (arena * scope, Uint32 size)
+{
+  char *addr;
+  Uint32 block_size = ARENA_SIZE (size);
+  if (block_size > scope->size - scope->used)
+    {
+      LOG_ERR ("%s arena is full; size request %i bytes;"
+               " %i bytes used of %i", scope->name, size, scope->used,
+               scope->size);
+      return NULL;
+    }
+  addr = scope->base + scope->used;
+  scope->used += block_size;
+  if (scope->used > scope->max_used)
+    {
+      scope->max_used = scope->used;
+    }
+  memset (addr, 0, size);
+  return addr;
+}
+
+/**
+ * Return the current position in an arena
+ * @param scope Pointer to the arena
+ * @return Mark to give to arena_release()
+ */
+Uint32
+arena_mark (const arena * scope)
+{
+  return scope->used;
+}
+
+/**
+ * Release all the blocks taken since a mark
+ * @param scope Pointer to the arena
+ * @param mark Value returned by arena_mark()
+ */
+void
+arena_release (arena * scope, Uint32 mark)
+{
+  if (mark > scope->used)
+    {
+      LOG_ERR ("%s arena: mark %i is beyond %i bytes used", scope->name,
+               mark, scope->used);
+      return;
+    }
+  scope->used = mark;
+}
+
+/**
+ * Release all the blocks of an arena
+ * @param scope Pointer to the arena
+ */
+void
+arena_reset (arena * scope)
+{
+  scope->used = 0;
+}
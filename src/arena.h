@@ -0,0 +1,74 @@
+/**
+ * @file arena.h
+ * @brief Bump allocators released in one go
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: arena.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __ARENA__
+#define __ARENA__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Alignment in bytes of the blocks returned by arena_alloc() */
+#define ARENA_ALIGNMENT 16
+/** Size taken in an arena by a block of the given size */
+#define ARENA_SIZE(size) \
+  (((size) + ARENA_ALIGNMENT - 1) & ~(Uint32) (ARENA_ALIGNMENT - 1))
+
+/**
+ * A memory area allocated once, the blocks are taken one after the
+ * other and are all released together, or back to a mark
+ */
+  typedef struct arena
+  {
+    /** Name of the arena for the statistics */
+    const char *name;
+    /** Memory of the arena */
+    char *base;
+    /** Size of the arena in bytes */
+    Uint32 size;
+    /** Number of bytes in use */
+    Uint32 used;
+    /** Maximum number of bytes which were in use */
+    Uint32 max_used;
+  } arena;
+
+/** Size of the frame arena, the largest level file is a 133 KB meteor */
+#define FRAME_ARENA_SIZE (256 * 1024)
+  /** Scratch memory of the game thread, released at each frame */
+  extern arena frame_arena;
+
+  bool arena_create (arena * scope, const char *name, Uint32 size);
+  void arena_destroy (arena * scope);
+  char *arena_alloc (arena * scope, Uint32 size);
+  Uint32 arena_mark (const arena * scope);
+  void arena_release (arena * scope, Uint32 mark);
+  void arena_reset (arena * scope);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
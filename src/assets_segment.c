@@ -0,0 +1,779 @@
+/**
+ * @file assets_segment.c
+ * @brief Converted images shared read-only between several instances
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: assets_segment.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "display.h"
+#include "config_file.h"
+#include "archive.h"
+#include "assets_segment.h"
+#include "log_recorder.h"
+#include <sys/mman.h>
+
+/*
+ * The segment file is made of a header, the converted data blocks
+ * aligned on 8 bytes, the table of the entries sorted by keys, then
+ * the table of the source files sorted by the hashes of their names.
+ * The keys are the hash of the name of the *.spr file and the offset
+ * of the 8-bit source data in it, so the images find their converted
+ * data whatever the order in which they are loaded. The data of a
+ * file are used only if its size and its time of last modification
+ * are the ones it had when the segment was built.
+ */
+
+#define ASSETS_MAGIC "MDASSEG2"
+#define ASSETS_ALIGN(size) (((size) + 7) & ~7U)
+/** Maximum number of source files in a segment */
+#define ASSETS_MAX_FILES 1024
+/** Number of loaded source files whose buffers are tracked */
+#define ASSETS_MAX_SOURCES 64
+
+typedef struct assets_header
+{
+  /** "MDASSEG1" */
+  char magic[8];
+  /** Screen depth the data were converted to */
+  Uint32 bytes_per_pixel;
+  /** Hash of the palette the pixels were converted with */
+  Uint32 palette_hash;
+  /** Number of entries in the table */
+  Uint32 num_of_entries;
+  /** Offset of the entries table from the start of the file */
+  Uint32 entries_offset;
+  /** Number of source files in the table */
+  Uint32 num_of_files;
+  /** Offset of the source files table from the start of the file */
+  Uint32 files_offset;
+  /** Size of the whole file in bytes */
+  Uint32 size;
+} assets_header;
+
+typedef struct assets_entry
+{
+  /** Hash of the name of the source file */
+  Uint32 key1;
+  /** Offset of the source data in the file, times 2, plus the type */
+  Uint32 key2;
+  /** Size of the converted data in bytes */
+  Uint32 size;
+  /** Offset of the converted data from the start of the file */
+  Uint32 offset;
+} assets_entry;
+
+/** A source file whose data were converted */
+typedef struct assets_file
+{
+  /** Hash of the name, ie "graphics/sprites/all_enemies.spr" */
+  Uint32 name_hash;
+  /** Size of the file in bytes */
+  Uint32 size;
+  /** Time of last modification of the file, or of the archive */
+  Uint32 mtime;
+} assets_file;
+
+/** A source file loaded in memory, its data are being converted */
+typedef struct assets_source
+{
+  /** File content, NULL if the slot is free */
+  const char *data;
+  Uint32 size;
+  Uint32 name_hash;
+  /** TRUE if the segment holds the data of this version of the file */
+  bool is_valid;
+} assets_source;
+
+/** Filename of the segment */
+static const char *segment_filename = NULL;
+/** Filename of the cache in the configuration directory, NULL if none */
+static char *cache_filename = NULL;
+/** Number of images not found in the mapped segment */
+static Uint32 segment_misses = 0;
+/** Segment mapped read-only, NULL if none */
+static char *segment = NULL;
+static Uint32 segment_size = 0;
+static const assets_entry *segment_entries = NULL;
+static Uint32 segment_num_of_entries = 0;
+static const assets_file *segment_files = NULL;
+static Uint32 segment_num_of_files = 0;
+/** The source files loaded last, the oldest one is replaced */
+static assets_source sources[ASSETS_MAX_SOURCES];
+static Uint32 sources_next = 0;
+/** Serializes the additions, the images may be loaded by several threads */
+static SDL_mutex *segment_mutex = NULL;
+
+/** Temporary file written when the segment is built, NULL if none */
+static FILE *build_file = NULL;
+static char *build_filename = NULL;
+static assets_entry *build_entries = NULL;
+static Uint32 build_num_of_entries = 0;
+static Uint32 build_max_of_entries = 0;
+static Uint32 build_offset = 0;
+static assets_file build_files[ASSETS_MAX_FILES];
+static Uint32 build_num_of_files = 0;
+
+static bool assets_build_start (void);
+static void assets_build_append (Uint32 type, const char *source,
+                                 const char *data, Uint32 size);
+static void assets_build_abort (void);
+
+/**
+ * Return a hash of the palette used to convert the pixels
+ * @return The hash value
+ */
+static Uint32
+assets_palette_hash (void)
+{
+  Uint32 hash = HASH_FNV1A_INIT;
+  hash = hash_fnv1a (hash, &bytes_per_pixel, sizeof (bytes_per_pixel));
+  if (bytes_per_pixel == 2 && pal16 != NULL)
+    {
+      hash = hash_fnv1a (hash, pal16, 256 * sizeof (Uint16));
+    }
+  else if (bytes_per_pixel > 2 && pal32 != NULL)
+    {
+      hash = hash_fnv1a (hash, pal32, 256 * sizeof (Uint32));
+    }
+  return hash;
+}
+
+/**
+ * Compute the keys of a source data block from the loaded file which
+ * contains it, called with the mutex locked
+ * @param entry Pointer to the entry which receives the keys
+ * @param type ASSETS_PIXELS or ASSETS_COMPRESS
+ * @param source Pointer to the 8-bit source data
+ * @param size Size of the converted data in bytes
+ * @return The loaded file, NULL if the data don't belong to one
+ */
+static const assets_source *
+assets_keys (assets_entry * entry, Uint32 type, const char *source,
+             Uint32 size)
+{
+  Uint32 i;
+  const assets_source *file;
+  for (i = 0; i < ASSETS_MAX_SOURCES; i++)
+    {
+      file = &sources[i];
+      if (file->data != NULL && source >= file->data
+          && source < file->data + file->size)
+        {
+          entry->key1 = file->name_hash;
+          entry->key2 = (Uint32) (source - file->data) * 2 + type;
+          entry->size = size;
+          return file;
+        }
+    }
+  return NULL;
+}
+
+/**
+ * Compare the names hashes of two source files, used by qsort()
+ * and bsearch()
+ */
+static int
+assets_compare_files (const void *a, const void *b)
+{
+  const assets_file *f1 = (const assets_file *) a;
+  const assets_file *f2 = (const assets_file *) b;
+  if (f1->name_hash != f2->name_hash)
+    {
+      return f1->name_hash < f2->name_hash ? -1 : 1;
+    }
+  return 0;
+}
+
+/**
+ * Compare the keys of two entries, used by qsort() and bsearch()
+ */
+static int
+assets_compare (const void *a, const void *b)
+{
+  const assets_entry *e1 = (const assets_entry *) a;
+  const assets_entry *e2 = (const assets_entry *) b;
+  if (e1->key1 != e2->key1)
+    {
+      return e1->key1 < e2->key1 ? -1 : 1;
+    }
+  if (e1->key2 != e2->key2)
+    {
+      return e1->key2 < e2->key2 ? -1 : 1;
+    }
+  if (e1->size != e2->size)
+    {
+      return e1->size < e2->size ? -1 : 1;
+    }
+  return 0;
+}
+
+/**
+ * Map the segment file read-only, or start to build it if it does not
+ * exist or if it was built for another screen depth or palette.
+ * Must be called once the display is initialized
+ * @param filename Filename of the segment, ie "/dev/shm/mangadualist.seg"
+ * @param rebuild TRUE to build the segment even if it is valid
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+assets_segment_open (const char *filename, bool rebuild)
+{
+  int fd;
+  struct stat sb;
+  void *map;
+  const assets_header *header;
+  segment_filename = filename;
+  segment_misses = 0;
+  if (segment_mutex == NULL)
+    {
+      segment_mutex = SDL_CreateMutex ();
+      if (segment_mutex == NULL)
+        {
+          LOG_ERR ("SDL_CreateMutex() failed: %s", SDL_GetError ());
+          return FALSE;
+        }
+    }
+  if (rebuild)
+    {
+      LOG_INF ("%s will be rebuilt", filename);
+      return assets_build_start ();
+    }
+  fd = open (filename, O_RDONLY);
+  if (fd < 0)
+    {
+      LOG_INF ("%s not found, it will be built", filename);
+      return assets_build_start ();
+    }
+  if (fstat (fd, &sb) || sb.st_size < (off_t) sizeof (assets_header))
+    {
+      close (fd);
+      LOG_WARN ("%s is invalid, it will be rebuilt", filename);
+      return assets_build_start ();
+    }
+  map = mmap (NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      LOG_ERR ("mmap(%s) failed: %s", filename, strerror (errno));
+      return FALSE;
+    }
+  header = (const assets_header *) map;
+  if (memcmp (header->magic, ASSETS_MAGIC, sizeof (header->magic))
+      || header->size != (Uint32) sb.st_size
+      || header->entries_offset > header->size
+      || header->num_of_entries >
+      (header->size - header->entries_offset) / sizeof (assets_entry)
+      || header->files_offset > header->size
+      || header->num_of_files >
+      (header->size - header->files_offset) / sizeof (assets_file))
+    {
+      munmap (map, sb.st_size);
+      LOG_WARN ("%s is invalid, it will be rebuilt", filename);
+      return assets_build_start ();
+    }
+  if (header->bytes_per_pixel != bytes_per_pixel
+      || header->palette_hash != assets_palette_hash ())
+    {
+      munmap (map, sb.st_size);
+      LOG_WARN ("%s was built for another display, it will be rebuilt",
+                filename);
+      return assets_build_start ();
+    }
+  segment = (char *) map;
+  segment_size = header->size;
+  segment_entries = (const assets_entry *) (segment + header->entries_offset);
+  segment_num_of_entries = header->num_of_entries;
+  segment_files = (const assets_file *) (segment + header->files_offset);
+  segment_num_of_files = header->num_of_files;
+  LOG_INF ("%i converted blocks shared from %s (%i bytes)",
+           segment_num_of_entries, filename, segment_size);
+  return TRUE;
+}
+
+/**
+ * Map the cache of the converted images from the configuration
+ * directory, one cache file per screen depth
+ * @param rebuild TRUE to build the cache even if it is valid
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+assets_segment_open_cache (bool rebuild)
+{
+  const char *dir = configfile_get_dir ();
+  if (dir == NULL)
+    {
+      return FALSE;
+    }
+  cache_filename = memory_allocation (strlen (dir) + 32);
+  if (cache_filename == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes",
+               (Uint32) (strlen (dir) + 32));
+      return FALSE;
+    }
+  sprintf (cache_filename, "%s/sprites-%ibpp.cache", dir,
+           bytes_per_pixel * 8);
+  return assets_segment_open (cache_filename, rebuild);
+}
+
+/**
+ * Check if the segment is being built by this instance
+ * @return TRUE if the segment is being built
+ */
+bool
+assets_segment_is_building (void)
+{
+  return build_file != NULL;
+}
+
+/**
+ * Copy converted data into private memory if it belongs to the shared
+ * segment, for the images whose data are modified once loaded
+ * @param data Pointer to the pointer of the converted data
+ * @param size Size of the converted data in bytes
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+assets_make_private (char **data, Uint32 size)
+{
+  char *copy;
+  if (segment == NULL || *data < segment || *data >= segment + segment_size)
+    {
+      return TRUE;
+    }
+  copy = memory_allocation (size);
+  if (copy == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes", size);
+      return FALSE;
+    }
+  memcpy (copy, *data, size);
+  *data = copy;
+  return TRUE;
+}
+
+/**
+ * Track a *.spr file just loaded, the converted data of the blocks
+ * it contains are searched by the name of the file and their offset
+ * @param name Name of the file relative to the data directory
+ * @param pathname Pathname of the file, NULL if read from the archive
+ * @param data Content of the file
+ * @param size Size of the file in bytes
+ */
+void
+assets_segment_source (const char *name, const char *pathname,
+                       const char *data, Uint32 size)
+{
+  Uint32 i, len = strlen (name);
+  struct stat sb;
+  assets_file file;
+  assets_source *source;
+  const assets_file *found = NULL;
+  if ((segment == NULL && build_file == NULL) || len < 4
+      || strcmp (name + len - 4, ".spr"))
+    {
+      return;
+    }
+  file.name_hash = hash_fnv1a (HASH_FNV1A_INIT, name, len);
+  file.size = size;
+  file.mtime = 0;
+  if (pathname == NULL)
+    {
+      file.mtime = archive_mtime ();
+    }
+  else if (!stat (pathname, &sb))
+    {
+      file.mtime = (Uint32) sb.st_mtime;
+    }
+  if (segment != NULL)
+    {
+      found =
+        bsearch (&file, segment_files, segment_num_of_files,
+                 sizeof (assets_file), assets_compare_files);
+    }
+  SDL_LockMutex (segment_mutex);
+  /* the buffer may reuse the memory of files released since */
+  for (i = 0; i < ASSETS_MAX_SOURCES; i++)
+    {
+      source = &sources[i];
+      if (source->data != NULL && source->data < data + size
+          && data < source->data + source->size)
+        {
+          source->data = NULL;
+        }
+    }
+  source = &sources[sources_next++ % ASSETS_MAX_SOURCES];
+  source->data = data;
+  source->size = size;
+  source->name_hash = file.name_hash;
+  source->is_valid = found != NULL && found->size == file.size
+    && found->mtime == file.mtime;
+  if (build_file != NULL)
+    {
+      for (i = 0; i < build_num_of_files; i++)
+        {
+          if (build_files[i].name_hash == file.name_hash)
+            {
+              break;
+            }
+        }
+      if (i == build_num_of_files)
+        {
+          if (build_num_of_files < ASSETS_MAX_FILES)
+            {
+              build_files[build_num_of_files++] = file;
+            }
+          else
+            {
+              LOG_ERR ("more than %i source files", ASSETS_MAX_FILES);
+              assets_build_abort ();
+            }
+        }
+    }
+  SDL_UnlockMutex (segment_mutex);
+}
+
+/**
+ * Search the converted data of a source data block in the segment
+ * @param type ASSETS_PIXELS or ASSETS_COMPRESS
+ * @param source Pointer to the 8-bit source data
+ * @param size Size of the converted data in bytes
+ * @return Pointer to the read-only converted data, NULL if not found
+ */
+char *
+assets_segment_find (Uint32 type, const char *source, Uint32 size)
+{
+  assets_entry key;
+  const assets_entry *entry = NULL;
+  const assets_source *file;
+  if (segment == NULL)
+    {
+      return NULL;
+    }
+  SDL_LockMutex (segment_mutex);
+  file = assets_keys (&key, type, source, size);
+  if (file != NULL && file->is_valid)
+    {
+      entry =
+        bsearch (&key, segment_entries, segment_num_of_entries,
+                 sizeof (assets_entry), assets_compare);
+    }
+  if (file != NULL
+      && (entry == NULL || entry->offset + entry->size > segment_size))
+    {
+      /* the source file changed since the segment was built */
+      segment_misses++;
+      entry = NULL;
+    }
+  SDL_UnlockMutex (segment_mutex);
+  if (entry == NULL)
+    {
+      return NULL;
+    }
+  return segment + entry->offset;
+}
+
+/**
+ * Append converted data to the segment being built
+ * @param type ASSETS_PIXELS or ASSETS_COMPRESS
+ * @param source Pointer to the 8-bit source data
+ * @param data Pointer to the converted data
+ * @param size Size of the converted data in bytes
+ */
+void
+assets_segment_add (Uint32 type, const char *source, const char *data,
+                    Uint32 size)
+{
+  if (build_file == NULL)
+    {
+      return;
+    }
+  SDL_LockMutex (segment_mutex);
+  assets_build_append (type, source, data, size);
+  SDL_UnlockMutex (segment_mutex);
+}
+
+/**
+ * Finish the segment being built: write the entries table and the
+ * header, then rename the temporary file. The instances started later
+ * will map it, this instance keeps its own converted data.
+ * If the mapped segment missed some images, the data files changed
+ * since it was built: it is removed to be rebuilt at next launch
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+assets_segment_seal (void)
+{
+  Uint32 i, num_of_entries = 0;
+  assets_header header;
+  if (build_file == NULL)
+    {
+      if (segment != NULL && segment_misses > 0)
+        {
+          LOG_WARN ("%i images not found in %s, it will be rebuilt",
+                    segment_misses, segment_filename);
+          unlink (segment_filename);
+        }
+      return TRUE;
+    }
+
+  /* sort the entries and drop the duplicates of an identical data */
+  qsort (build_entries, build_num_of_entries, sizeof (assets_entry),
+         assets_compare);
+  for (i = 0; i < build_num_of_entries; i++)
+    {
+      if (num_of_entries > 0
+          && !assets_compare (&build_entries[num_of_entries - 1],
+                              &build_entries[i]))
+        {
+          continue;
+        }
+      build_entries[num_of_entries++] = build_entries[i];
+    }
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, ASSETS_MAGIC, sizeof (header.magic));
+  header.bytes_per_pixel = bytes_per_pixel;
+  header.palette_hash = assets_palette_hash ();
+  header.num_of_entries = num_of_entries;
+  header.entries_offset = build_offset;
+  header.num_of_files = build_num_of_files;
+  header.files_offset =
+    build_offset + num_of_entries * sizeof (assets_entry);
+  header.size =
+    header.files_offset + build_num_of_files * sizeof (assets_file);
+  qsort (build_files, build_num_of_files, sizeof (assets_file),
+         assets_compare_files);
+  if (fseek (build_file, build_offset, SEEK_SET)
+      || fwrite (build_entries, sizeof (assets_entry), num_of_entries,
+                 build_file) != num_of_entries
+      || fwrite (build_files, sizeof (assets_file), build_num_of_files,
+                 build_file) != build_num_of_files
+      || fseek (build_file, 0, SEEK_SET)
+      || fwrite (&header, sizeof (header), 1, build_file) != 1)
+    {
+      LOG_ERR ("write to %s failed: %s", build_filename, strerror (errno));
+      assets_build_abort ();
+      return FALSE;
+    }
+  if (fclose (build_file))
+    {
+      build_file = NULL;
+      LOG_ERR ("fclose(%s) failed: %s", build_filename, strerror (errno));
+      assets_build_abort ();
+      return FALSE;
+    }
+  build_file = NULL;
+  if (rename (build_filename, segment_filename))
+    {
+      LOG_ERR ("rename(%s, %s) failed: %s", build_filename,
+               segment_filename, strerror (errno));
+      assets_build_abort ();
+      return FALSE;
+    }
+  LOG_INF ("%s built: %i converted blocks (%i bytes)", segment_filename,
+           num_of_entries, header.size);
+  /* the temporary name may be reused by another instance from now */
+  free_memory (build_filename);
+  build_filename = NULL;
+  assets_build_abort ();
+  return TRUE;
+}
+
+/**
+ * Unmap the segment and remove an unfinished build
+ */
+void
+assets_segment_close (void)
+{
+  assets_build_abort ();
+  if (segment != NULL)
+    {
+      munmap (segment, segment_size);
+      segment = NULL;
+      segment_size = 0;
+      segment_entries = NULL;
+      segment_num_of_entries = 0;
+      segment_files = NULL;
+      segment_num_of_files = 0;
+    }
+  memset (sources, 0, sizeof (sources));
+  if (cache_filename != NULL)
+    {
+      free_memory (cache_filename);
+      cache_filename = NULL;
+    }
+  if (segment_mutex != NULL)
+    {
+      SDL_DestroyMutex (segment_mutex);
+      segment_mutex = NULL;
+    }
+}
+
+/**
+ * Release converted data, unless it belongs to the shared segment
+ * @param data Pointer to the converted data
+ */
+void
+assets_free (char *data)
+{
+  if (segment != NULL && data >= segment && data < segment + segment_size)
+    {
+      return;
+    }
+  free_memory (data);
+}
+
+/**
+ * Create the temporary file which receives the segment being built,
+ * it is renamed only once complete so that the other instances never
+ * map an unfinished file
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+assets_build_start (void)
+{
+  int fd;
+  build_filename = memory_allocation (strlen (segment_filename) + 8);
+  if (build_filename == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes",
+               (Uint32) (strlen (segment_filename) + 8));
+      return FALSE;
+    }
+  sprintf (build_filename, "%s.XXXXXX", segment_filename);
+  fd = mkstemp (build_filename);
+  if (fd < 0)
+    {
+      LOG_ERR ("mkstemp(%s) failed: %s", build_filename, strerror (errno));
+      free_memory (build_filename);
+      build_filename = NULL;
+      return FALSE;
+    }
+  fchmod (fd, 0644);
+  build_file = fdopen (fd, "wb");
+  if (build_file == NULL)
+    {
+      LOG_ERR ("fdopen(%s) failed: %s", build_filename, strerror (errno));
+      close (fd);
+      assets_build_abort ();
+      return FALSE;
+    }
+  build_max_of_entries = 1024;
+  build_num_of_entries = 0;
+  build_entries =
+    (assets_entry *) memory_allocation (sizeof (assets_entry) *
+                                        build_max_of_entries);
+  if (build_entries == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i entries",
+               build_max_of_entries);
+      assets_build_abort ();
+      return FALSE;
+    }
+  build_offset = ASSETS_ALIGN (sizeof (assets_header));
+  return TRUE;
+}
+
+/**
+ * Write converted data to the temporary file and add its entry,
+ * called with the mutex locked
+ * @param type ASSETS_PIXELS or ASSETS_COMPRESS
+ * @param source Pointer to the 8-bit source data
+ * @param data Pointer to the converted data
+ * @param size Size of the converted data in bytes
+ */
+static void
+assets_build_append (Uint32 type, const char *source, const char *data,
+                     Uint32 size)
+{
+  assets_entry key;
+  assets_entry *entries;
+  if (build_file == NULL)
+    {
+      /* the build was aborted by another thread */
+      return;
+    }
+  if (assets_keys (&key, type, source, size) == NULL)
+    {
+      /* not read from a *.spr file: converted at each launch */
+      return;
+    }
+  if (build_num_of_entries >= build_max_of_entries)
+    {
+      entries =
+        (assets_entry *) memory_allocation (sizeof (assets_entry) *
+                                            build_max_of_entries * 2);
+      if (entries == NULL)
+        {
+          LOG_ERR ("not enough memory to allocate %i entries",
+                   build_max_of_entries * 2);
+          assets_build_abort ();
+          return;
+        }
+      memcpy (entries, build_entries,
+              sizeof (assets_entry) * build_num_of_entries);
+      free_memory ((char *) build_entries);
+      build_entries = entries;
+      build_max_of_entries *= 2;
+    }
+  if (fseek (build_file, build_offset, SEEK_SET)
+      || fwrite (data, 1, size, build_file) != size)
+    {
+      LOG_ERR ("write to %s failed: %s", build_filename, strerror (errno));
+      assets_build_abort ();
+      return;
+    }
+  key.offset = build_offset;
+  build_entries[build_num_of_entries++] = key;
+  build_offset = ASSETS_ALIGN (build_offset + size);
+}
+
+/**
+ * Stop building the segment, the temporary file is removed if it
+ * was not renamed yet
+ */
+static void
+assets_build_abort (void)
+{
+  if (build_file != NULL)
+    {
+      fclose (build_file);
+      build_file = NULL;
+    }
+  if (build_filename != NULL)
+    {
+      unlink (build_filename);
+      free_memory (build_filename);
+      build_filename = NULL;
+    }
+  if (build_entries != NULL)
+    {
+      free_memory ((char *) build_entries);
+      build_entries = NULL;
+    }
+  build_num_of_entries = 0;
+  build_max_of_entries = 0;
+  build_num_of_files = 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file assets_segment.h
+ * @brief Converted images shared read-only between several instances
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: assets_segment.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __ASSETS_SEGMENT__
+#define __ASSETS_SEGMENT__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /** Kinds of converted data stored in the segment */
+  typedef enum
+  {
+    /** Pixels converted to the screen depth */
+    ASSETS_PIXELS,
+    /** Offsets and repeat values table */
+    ASSETS_COMPRESS
+  } ASSETS_TYPES;
+
+  bool assets_segment_open (const char *filename, bool rebuild);
+  bool assets_segment_open_cache (bool rebuild);
+  bool assets_segment_is_building (void);
+  bool assets_make_private (char **data, Uint32 size);
+  void assets_segment_source (const char *name, const char *pathname,
+                              const char *data, Uint32 size);
+  char *assets_segment_find (Uint32 type, const char *source, Uint32 size);
+  void assets_segment_add (Uint32 type, const char *source,
+                           const char *data, Uint32 size);
+  bool assets_segment_seal (void);
+  void assets_segment_close (void);
+  void assets_free (char *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
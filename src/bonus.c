@@ -334,6 +334,27 @@ bonus_handle (void)
     }
 }
 
+/**
+ * Fold the state of all gems on the screen into a hash
+ * @param hash Current hash value
+ * @return The updated hash value
+ */
+Uint32
+bonus_hash (Uint32 hash)
+{
+  Sint32 i;
+  gem_str *gem = gem_first;
+  for (i = 0; i < num_of_gems && gem != NULL; i++, gem = gem->next)
+    {
+      hash = hash_fnv1a (hash, &gem->type, sizeof (gem->type));
+      hash = hash_fnv1a (hash, &gem->current_image,
+                         sizeof (gem->current_image));
+      hash = hash_fnv1a (hash, &gem->xcoord, sizeof (gem->xcoord));
+      hash = hash_fnv1a (hash, &gem->ycoord, sizeof (gem->ycoord));
+    }
+  return hash;
+}
+
 /** 
  * Collision between a gem and the spaceship 
  * @param gem_str pointer to a gem structure
@@ -42,6 +42,7 @@ extern "C"
   void bonus_free (void);
   void bonus_disable_all (void);
   void bonus_handle (void);
+  Uint32 bonus_hash (Uint32 hash);
   void bonus_add (const enemy * const pve);
   void bonus_meteor_add (const enemy * const pve);
   extern image bonus[GEM_NUMOF_TYPES][GEM_NUMOF_IMAGES];
@@ -33,6 +33,9 @@
 
 #define CONFIG_DIR_NAME "alphadelusion"
 #define CONFIG_FILE_NAME "mangadualist.conf"
+/** 512 samples at 44.1 kHz are 11.6 ms of audio buffer */
+#define AUDIO_RATE_DEFAULT 44100
+#define AUDIO_BUFFER_DEFAULT 512
 
 config_file *power_conf = NULL;
 static const char *lang_to_text[MAX_OF_LANGUAGES] = { "en", "fr", "it" };
@@ -74,6 +77,23 @@ configfile_reset_values ()
       power_conf->lang = EN_LANG;
     }
   power_conf->extract_to_png = FALSE;
+  power_conf->norender = FALSE;
+  power_conf->hash_frames = 0;
+  power_conf->fork_server = FALSE;
+  power_conf->assets_segment = NULL;
+  power_conf->nocache = FALSE;
+  power_conf->rebuild_cache = FALSE;
+  power_conf->archive = NULL;
+  power_conf->pack_archive = NULL;
+  power_conf->record_movie = NULL;
+  power_conf->frame_times = NULL;
+  power_conf->strict_allocations = FALSE;
+  power_conf->profiler_trace = NULL;
+  power_conf->perf_counters = FALSE;
+  power_conf->vsync = FALSE;
+  power_conf->audio_rate = AUDIO_RATE_DEFAULT;
+  power_conf->audio_buffer = AUDIO_BUFFER_DEFAULT;
+  power_conf->music_cache = FALSE;
   power_conf->joy_x_axis = 0;
   power_conf->joy_y_axis = 1;
   power_conf->joy_fire = 0;
@@ -262,6 +282,22 @@ configfile_load (void)
     {
       power_conf->verbose = 0;
     }
+  if (!lisp_read_int (lst, "audio_rate", &power_conf->audio_rate)
+      || power_conf->audio_rate < 11025 || power_conf->audio_rate > 96000)
+    {
+      power_conf->audio_rate = AUDIO_RATE_DEFAULT;
+    }
+  /* SDL wants a power of two */
+  if (!lisp_read_int (lst, "audio_buffer", &power_conf->audio_buffer)
+      || power_conf->audio_buffer < 128 || power_conf->audio_buffer > 8192
+      || (power_conf->audio_buffer & (power_conf->audio_buffer - 1)))
+    {
+      power_conf->audio_buffer = AUDIO_BUFFER_DEFAULT;
+    }
+  if (!lisp_read_bool (lst, "music_cache", &power_conf->music_cache))
+    {
+      power_conf->music_cache = FALSE;
+    }
   sub = search_for (lst, "joy_config");
   if (sub)
     sub = lisp_car_int (sub, &power_conf->joy_x_axis);
@@ -307,6 +343,15 @@ configfile_save (void)
            power_conf->fullscreen ? "#t" : "#f");
   fprintf (config, "\t(nosound %s)\n", power_conf->nosound ? "#t" : "#f");
   fprintf (config, "\t(nosync %s)\n", power_conf->nosync ? "#t" : "#f");
+
+  fprintf (config,
+           "\n\t;; audio output rate in Hz and buffer size in samples\n");
+  fprintf (config, "\t(audio_rate %d)\n", power_conf->audio_rate);
+  fprintf (config, "\t(audio_buffer %d)\n", power_conf->audio_buffer);
+  fprintf (config,
+           "\t;; play the musics from PCM files rendered once (#t or #f)\n");
+  fprintf (config, "\t(music_cache %s)\n",
+           power_conf->music_cache ? "#t" : "#f");
   
   fprintf (config,
            "\n\t;; joy_config x_axis y_axis fire_button option_button start_button):\n");
@@ -401,7 +446,40 @@ configfile_scan_arguments (Sint32 arg_count, char **arg_values)
 #endif
                    "--nosound      disable sound and musics\n"
                    "--sound        enable sound and musics\n"
+                   "--musiccache   play the musics from PCM files rendered once\n"
                    "--nosync       disable timer\n"
+                   "--vsync        present the frames at the refresh rate of\n"
+                   "               the display, the sprites are interpolated\n"
+                   "--norender     skip all the drawing, run the game logic only\n"
+                   "--framehash n  run n frames with the fire button held, print\n"
+                   "               a hash of the game state and exit\n"
+                   "--forkserver   load the assets once, then fork an episode for\n"
+                   "               each \"run [frames]\" line read on standard input\n"
+                   "               (implies --norender and --nosound)\n"
+                   "--sharedassets file\n"
+                   "               map the converted images from a file shared\n"
+                   "               by all the instances, build it if needed\n"
+                   "--nocache      don't keep the converted images in a cache\n"
+                   "--rebuild-cache\n"
+                   "               convert again the images and rebuild the cache\n"
+                   "--archive file read the data files from an archive\n"
+                   "--packarchive file\n"
+                   "               pack all the data files into an archive\n"
+                   "--record file  record the game into a movie file\n"
+                   "--frametimes file\n"
+                   "               write the histograms of the durations of\n"
+                   "               the frames into a JSON file at exit\n"
+#if defined (USE_MALLOC_WRAPPER)
+                   "--strictalloc  abort when a frame allocates memory after\n"
+                   "               the level started\n"
+#endif
+#if defined (USE_PROFILER)
+                   "--profiletrace file\n"
+                   "               write the last frames profiled into a\n"
+                   "               Chrome trace file at exit\n"
+                   "--perfcounters print the instructions per cycle and the\n"
+                   "               misses of the profiled regions at exit\n"
+#endif
                    "--easy         easy bonuses\n"
                    "--hard         hard bonuses\n"
                    "--------------------------------------------------------------\n"
@@ -417,6 +495,10 @@ configfile_scan_arguments (Sint32 arg_count, char **arg_values)
 #ifdef MANGADUALIST_SDL
           fprintf (stdout,
                    "F              switch between full screen and windowed mode\n");
+#endif
+#if defined (USE_PROFILER)
+          fprintf (stdout,
+                   "[Ctrl]+[F]     show/hide the frame profiler\n");
 #endif
           return FALSE;
 
@@ -507,6 +589,144 @@ configfile_scan_arguments (Sint32 arg_count, char **arg_values)
           continue;
         }
 
+      /* wait for the vertical retrace, the game still runs at 70 Hz */
+      if (!strcmp (arg_values[i], "--vsync"))
+        {
+          power_conf->vsync = TRUE;
+          continue;
+        }
+
+      /* skip all the drawing */
+      if (!strcmp (arg_values[i], "--norender"))
+        {
+          power_conf->norender = TRUE;
+          continue;
+        }
+
+      /* run a number of frames and print the game state hash */
+      if (!strcmp (arg_values[i], "--framehash"))
+        {
+          if (i + 1 >= arg_count
+              || sscanf (arg_values[++i], "%d", &power_conf->hash_frames) != 1
+              || power_conf->hash_frames < 1)
+            {
+              LOG_ERR ("--framehash expects a number of frames");
+              return FALSE;
+            }
+          continue;
+        }
+
+      /* load the assets once and fork a process per episode */
+      if (!strcmp (arg_values[i], "--forkserver"))
+        {
+          power_conf->fork_server = TRUE;
+          continue;
+        }
+
+      /* converted images shared between the instances */
+      if (!strcmp (arg_values[i], "--sharedassets"))
+        {
+          if (i + 1 >= arg_count)
+            {
+              LOG_ERR ("--sharedassets expects a filename");
+              return FALSE;
+            }
+          power_conf->assets_segment = arg_values[++i];
+          continue;
+        }
+
+      /* musics rendered into PCM files */
+      if (!strcmp (arg_values[i], "--musiccache"))
+        {
+          power_conf->music_cache = TRUE;
+          continue;
+        }
+
+      /* cache of the converted images */
+      if (!strcmp (arg_values[i], "--nocache"))
+        {
+          power_conf->nocache = TRUE;
+          continue;
+        }
+      if (!strcmp (arg_values[i], "--rebuild-cache"))
+        {
+          power_conf->rebuild_cache = TRUE;
+          continue;
+        }
+
+      /* data files archive */
+      if (!strcmp (arg_values[i], "--archive")
+          || !strcmp (arg_values[i], "--packarchive"))
+        {
+          if (i + 1 >= arg_count)
+            {
+              LOG_ERR ("%s expects a filename", arg_values[i]);
+              return FALSE;
+            }
+          if (!strcmp (arg_values[i], "--archive"))
+            {
+              power_conf->archive = arg_values[++i];
+            }
+          else
+            {
+              power_conf->pack_archive = arg_values[++i];
+            }
+          continue;
+        }
+
+      /* record the game into a movie file */
+      if (!strcmp (arg_values[i], "--record"))
+        {
+          if (i + 1 >= arg_count)
+            {
+              LOG_ERR ("%s expects a filename", arg_values[i]);
+              return FALSE;
+            }
+          power_conf->record_movie = arg_values[++i];
+          continue;
+        }
+
+      /* write the histograms of the frames at exit */
+      if (!strcmp (arg_values[i], "--frametimes"))
+        {
+          if (i + 1 >= arg_count)
+            {
+              LOG_ERR ("%s expects a filename", arg_values[i]);
+              return FALSE;
+            }
+          power_conf->frame_times = arg_values[++i];
+          continue;
+        }
+
+#if defined (USE_MALLOC_WRAPPER)
+      /* abort when a frame allocates after the level started */
+      if (!strcmp (arg_values[i], "--strictalloc"))
+        {
+          power_conf->strict_allocations = TRUE;
+          continue;
+        }
+#endif
+
+#if defined (USE_PROFILER)
+      /* write the trace of the last frames at exit */
+      if (!strcmp (arg_values[i], "--profiletrace"))
+        {
+          if (i + 1 >= arg_count)
+            {
+              LOG_ERR ("%s expects a filename", arg_values[i]);
+              return FALSE;
+            }
+          power_conf->profiler_trace = arg_values[++i];
+          continue;
+        }
+      /* read the hardware counters in the profiled regions */
+      if (!strcmp (arg_values[i], "--perfcounters"))
+        {
+          power_conf->perf_counters = TRUE;
+          continue;
+        }
+#endif
+
       /* difficulty: easy or hard (normal bu default) */
       if (!strcmp (arg_values[i], "--easy"))
         {
@@ -522,6 +742,16 @@ configfile_scan_arguments (Sint32 arg_count, char **arg_values)
   return TRUE;
 }
 
+/**
+ * Return the configuration directory
+ * @return The directory, ie "~/.config/alphadelusion", NULL if unavailable
+ */
+const char *
+configfile_get_dir (void)
+{
+  return config_dir;
+}
+
 /**
  * Return current language
  * @return current language 'en' or 'fr'
@@ -53,6 +53,12 @@ extern "C"
     Sint32 joy_fire;
     Sint32 joy_option;
     Sint32 joy_start;
+    /** Sampling rate of the audio output in Hz */
+    Sint32 audio_rate;
+    /** Size of the audio buffer in samples, the lower the latency */
+    Sint32 audio_buffer;
+    /** TRUE if play the musics from PCM files rendered once */
+    bool music_cache;
     /** verbose mode leve 1 or 2 if more messages */
     Sint32 verbose;
     /** 0 = easy, 1 = normal or 2 = hard */
@@ -61,6 +67,38 @@ extern "C"
     Sint32 lang;
     /** True if extract sprites to PNG format */
     bool extract_to_png;
+    /** TRUE if skip all the drawing, only the game logic runs */
+    bool norender;
+    /** Number of frames to run before printing the game state hash,
+     * 0 if disabled */
+    Sint32 hash_frames;
+    /** TRUE if load the assets once, then fork a process per episode */
+    bool fork_server;
+    /** Filename of the converted images shared between the instances,
+     * NULL if disabled */
+    const char *assets_segment;
+    /** TRUE if don't keep the converted images in a cache file */
+    bool nocache;
+    /** TRUE if rebuild the cache file of the converted images */
+    bool rebuild_cache;
+    /** Filename of the data files archive, NULL if disabled */
+    const char *archive;
+    /** Filename of the archive to build, NULL if disabled */
+    const char *pack_archive;
+    /** Filename of the movie the game is recorded into, NULL if disabled */
+    const char *record_movie;
+    /** Filename of the histograms of the frames written at exit,
+     * NULL if disabled */
+    const char *frame_times;
+    /** TRUE if abort when a frame allocates after the level started */
+    bool strict_allocations;
+    /** Filename of the trace file written at exit, NULL if disabled */
+    const char *profiler_trace;
+    /** TRUE if read the performance counters of the profiled regions */
+    bool perf_counters;
+    /** TRUE if the frames are presented at the refresh rate of the
+     * display, between the ticks of the game */
+    bool vsync;
   } config_file;
   extern config_file *power_conf;
   void configfile_print (void);
@@ -69,6 +107,7 @@ extern "C"
   void configfile_free (void);
   bool configfile_scan_arguments (Sint32 arg_count, char **arg_values);
   const char *configfile_get_lang (void);
+  const char *configfile_get_dir (void);
 
 #ifdef __cplusplus
 }
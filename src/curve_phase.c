@@ -27,6 +27,7 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "tools.h"
+#include "arena.h"
 #include "images.h"
 #include "curve_phase.h"
 #include "display.h"
@@ -44,6 +45,8 @@
 const Sint32 CURVES_BEZIER_NUMOF = 122;
 /** All bezier curves loaded at startup */
 curve *initial_curve = NULL;
+/** Content of the curve bank file, the points of all the curves */
+static char *curve_bank = NULL;
 /** Current curve phase level data structure */
 curve_level courbe;
 #ifdef DEVELOPPEMENT
@@ -98,6 +101,11 @@ curve_free (void)
       free_memory ((char *) initial_curve);
       initial_curve = NULL;
     }
+  if (curve_bank != NULL)
+    {
+      free_file (curve_bank);
+      curve_bank = NULL;
+    }
 }
 
 /**
@@ -142,7 +150,7 @@ curve_phase (void)
       /* set number of images for animation */
       foe->spr.numof_images = (Sint16) 32;
       /* set current image */
-      foe->spr.current_image = initial_curve[courbe.num_courbe[i]].angle[0];
+      foe->spr.current_image = initial_curve[courbe.num_courbe[i]].points[0].angle;
       /* set addresses of the images buffer */
       for (k = 0; k < foe->spr.numof_images; k++)
         {
@@ -384,8 +392,8 @@ courbe_editeur ()
       if (tmp_tsts_x >= 0 && tmp_tsts_x < offscreen_width && tmp_tsts_y >= 0
           && tmp_tsts_y < offscreen_height)
         put_pixel (game_offscreen, tmp_tsts_x, tmp_tsts_y, coulor[GREEN]);
-      tmp_tsts_x += initial_curve[courbe.num_courbe[ge_act_pos_y]].delta_x[i];
-      tmp_tsts_y += initial_curve[courbe.num_courbe[ge_act_pos_y]].delta_y[i];
+      tmp_tsts_x += initial_curve[courbe.num_courbe[ge_act_pos_y]].points[i].delta_x;
+      tmp_tsts_y += initial_curve[courbe.num_courbe[ge_act_pos_y]].points[i].delta_y;
     }
   /* save a level curve */
   if (keys_down[K_S] && keys_down[K_A] && !curve_s_key_down)
@@ -531,40 +539,60 @@ fin_curv_editor:;
 #endif
 
 /**
- * Load all curves files 
+ * Load the curve bank, a single file which holds all the curves:
+ * the number of curves and the offset of each one in the file, then
+ * for each curve its number of points, its start coordinates and its
+ * points. The curves keep pointers to their points in the bank
  * @return TRUE if it completed successfully or FALSE otherwise
  */
 bool
 curves_load_all (void)
 {
-  Sint32 i, j;
-  char *fcurve;
-  signed char *ptr8;
+  Sint32 i, num_of_curves;
+  Uint32 size, offset;
   Sint16 *ptr16;
+  curve_bank = loadfile ("data/curves/bezier_curves.bin", &size);
+  if (curve_bank == NULL)
+    {
+      return FALSE;
+    }
+  num_of_curves = 0;
+  if (size >= 4)
+    {
+      num_of_curves = little_endian_to_int ((Sint32 *) curve_bank);
+    }
+  if (num_of_curves < CURVES_BEZIER_NUMOF
+      || size < 4 + (Uint32) num_of_curves * 4)
+    {
+      LOG_ERR ("the curve bank holds %i curves instead of %i",
+               num_of_curves, CURVES_BEZIER_NUMOF);
+      return FALSE;
+    }
   for (i = 0; i < CURVES_BEZIER_NUMOF; i++)
     {
-      fcurve = loadfile_num ("data/curves/bezier_curve_%03d.bin", i);
-      if (fcurve == NULL)
+      offset = little_endian_to_int ((Sint32 *) (curve_bank + 4 + i * 4));
+      if (offset > size - 6)
         {
+          LOG_ERR ("the curve %i is out of the curve bank", i);
           return FALSE;
         }
       /* 16-bit access */
-      ptr16 = (Sint16 *) fcurve;
+      ptr16 = (Sint16 *) (curve_bank + offset);
       /* number of points of the curve */
       initial_curve[i].nbr_pnt_curve = little_endian_to_short (ptr16++);
       /* start x coordinate */
       initial_curve[i].pos_x = little_endian_to_short (ptr16++);
       /* start y coordinate */
       initial_curve[i].pos_y = little_endian_to_short (ptr16++);
-      /* 8-bit access */
-      ptr8 = (signed char *) ptr16;
-      for (j = 0; j < initial_curve[i].nbr_pnt_curve; j++)
+      /* the points are 3 bytes: x offset, y offset and angle */
+      if (initial_curve[i].nbr_pnt_curve < 0
+          || initial_curve[i].nbr_pnt_curve * sizeof (curve_point) >
+          size - offset - 6)
         {
-          initial_curve[i].delta_x[j] = *(ptr8++);
-          initial_curve[i].delta_y[j] = *(ptr8++);
-          initial_curve[i].angle[j] = *(ptr8++);
+          LOG_ERR ("the curve %i is out of the curve bank", i);
+          return FALSE;
         }
-      free_memory (fcurve);
+      initial_curve[i].points = (const curve_point *) ptr16;
     }
   return TRUE;
 }
@@ -581,14 +609,18 @@ curve_load_level (Sint32 level_num)
   Sint16 *source;
   Sint16 *dest;
   Sint32 i;
+  Uint32 mark;
 
   /* load the file of the level curve */
   if (level_num > MAX_NUM_OF_LEVELS || level_num < 0)
     {
       level_num = 0;
     }
+  mark = arena_mark (&frame_arena);
   level_data =
-    loadfile_num ("data/levels/curves_phase/curves_%02d.bin", level_num);
+    loadfile_num_into_arena (&frame_arena,
+                             "data/levels/curves_phase/curves_%02d.bin",
+                             level_num);
   if (level_data == NULL)
     {
       return FALSE;
@@ -628,7 +660,7 @@ curve_load_level (Sint32 level_num)
     {
       *(dest++) = little_endian_to_short (source++);
     }
-  free_memory (level_data);
+  arena_release (&frame_arena, mark);
   return TRUE;
 }
 
@@ -677,7 +709,7 @@ curve_enable_level (void)
       /* set number of images for animation */
       foe->spr.numof_images = 32;
       /* set current image */
-      foe->spr.current_image = initial_curve[courbe.num_courbe[i]].angle[0];
+      foe->spr.current_image = initial_curve[courbe.num_courbe[i]].points[0].angle;
       /* set addresses of the images buffer */
       for (j = 0; j < foe->spr.numof_images; j++)
         {
@@ -43,20 +43,25 @@ extern "C"
   void courbe_editeur (void);
 #endif
 
-/* Maximum number of points on a curve */
-#define MAX_PNT_OF_CURVE 2000
+  /** A point of a curve */
+  typedef struct curve_point
+  {
+    /** X offset */
+    signed char delta_x;
+    /** Y offset */
+    signed char delta_y;
+    /** Enemy angle */
+    signed char angle;
+  } curve_point;
+
   typedef struct curve
   {
     /** Number of points on the curve */
     Sint16 nbr_pnt_curve;
     /** Curve start coordinates on the screen */
     Sint16 pos_x, pos_y;
-    /** X offsets */
-    signed char delta_x[MAX_PNT_OF_CURVE];
-    /** Y offsets */
-    signed char delta_y[MAX_PNT_OF_CURVE];
-    /** Ennemies angles */
-    signed char angle[MAX_PNT_OF_CURVE];
+    /** Points of the curve, stored in the curve bank */
+    const curve_point *points;
   } curve;
 
 /*
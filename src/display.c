@@ -117,7 +117,7 @@ bool is_iconified = FALSE;
 unsigned char coulor[COLORS_ENUM_NUMOF];
 Uint32 real_black_color = 0;
 SCREEN_ORIENTATION screen_orientation = PORTRAIT;
-static char *convert_16_or_24 (bitmap_desc * bmp);
+static const void *pcx_colors (void);
 
 /* 
  * common 
@@ -128,6 +128,10 @@ Uint32 window_width = 0;
 Uint32 window_height = 0;
 /** TRUE = update display option panel and bareline's score */
 bool update_all = TRUE;
+/** TRUE = skip all the pixel work, the game logic runs unchanged */
+bool render_disabled = FALSE;
+/** TRUE if the presentation of a frame waits for the vertical retrace */
+bool display_vsync = FALSE;
 
 /** 
  * Initialize SDL or X11 display
@@ -202,7 +206,7 @@ display_release (void)
   display_free ();
   if (palette_24 != NULL)
     {
-      free_memory ((char *) palette_24);
+      free_file ((char *) palette_24);
       palette_24 = NULL;
     }
   if (keys_down != NULL)
@@ -285,43 +289,21 @@ clear_keymap (void)
 }
 
 /** 
- * Color conversion 8-bit to 15-bits 16-bit, 24 bit or 32-bit
- * @param Pointer to a bitmap structure
- * @return Pointer to a pixel buffer
+ * Return the pixel values of the 256 colors for the screen depth
+ * @return Pointer to the pixel values, NULL for a 8-bit screen
  */
-static char *
-convert_16_or_24 (bitmap_desc * gfx)
+static const void *
+pcx_colors (void)
 {
-  Uint32 size;
-  char *buffer;
-  if (bytes_per_pixel == 1)
-    {
-      return gfx->pixel;
-    }
-  size = gfx->width * gfx->height;
-  buffer = memory_allocation (size * bytes_per_pixel);
-  if (buffer == NULL)
-    {
-      LOG_ERR ("not enough memory to allocate %i bytes!",
-               size * bytes_per_pixel);
-      return NULL;
-    }
   switch (bytes_per_pixel)
     {
     case 2:
-      conv8_16 (gfx->pixel, buffer, pal16, size);
-      break;
+      return pal16;
     case 3:
-      conv8_24 (gfx->pixel, buffer, pal32, size);
-      break;
     case 4:
-      conv8_32 (gfx->pixel, buffer, pal32, size);
-      break;
+      return pal32;
     }
-  free_memory (gfx->pixel);
-  gfx->pixel = buffer;
-  gfx->size = size * bytes_per_pixel;
-  return buffer;
+  return NULL;
 }
 
 /** 
@@ -333,23 +315,8 @@ convert_16_or_24 (bitmap_desc * gfx)
 char *
 load_pcx_file (const char *filename)
 {
-  char *buffer;
-  bitmap_desc *gfx = load_pcx (filename);
-  if (gfx == NULL)
-    {
-      return NULL;
-    }
-  if (bytes_per_pixel > 0)
-    {
-      if (!convert_16_or_24 (gfx))
-        {
-          LOG_ERR ("convert_16_or_24() failed!");
-          return NULL;
-        }
-    }
-  buffer = gfx->pixel;
-  free_memory ((char *) gfx);
-  return buffer;
+  return load_pcx_pixels (filename, NULL, bytes_per_pixel, pcx_colors (),
+                          NULL, NULL);
 }
 
 /**
@@ -362,27 +329,6 @@ load_pcx_file (const char *filename)
 bool
 load_pcx_into_buffer (const char *filename, char *buffer)
 {
-  Uint32 i;
-  char *data;
-  bitmap_desc *gfx = load_pcx (filename);
-  if (gfx == NULL)
-    {
-      return FALSE;
-    }
-  if (bytes_per_pixel > 0)
-    {
-      if (!convert_16_or_24 (gfx))
-        {
-          LOG_ERR ("convert_16_or_24() failed!");
-          return TRUE;
-        }
-    }
-  data = gfx->pixel;
-  for (i = 0; i < gfx->size; i++)
-    {
-      buffer[i] = data[i];
-    }
-  free_memory (data);
-  free_memory ((char *) gfx);
-  return TRUE;
+  return load_pcx_pixels (filename, buffer, bytes_per_pixel, pcx_colors (),
+                          NULL, NULL) != NULL;
 }
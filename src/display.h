@@ -123,6 +123,7 @@ extern "C"
   bool load_pcx_into_buffer (const char *filename, char *buffer);
   bool create_movie_offscreen (void);
   void destroy_movie_offscreen (void);
+  bool display_record_start (const char *filename);
 #ifdef MANGADUALIST_SDL
   void do_fullscreen (bool);
 #ifdef USE_SDL_JOYSTICK
@@ -198,6 +199,8 @@ extern "C"
 
 /* common */
   extern bool update_all;
+  extern bool render_disabled;
+  extern bool display_vsync;
   extern Uint32 window_width;
   extern Uint32 window_height;
   extern bool is_iconified;
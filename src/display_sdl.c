@@ -35,8 +35,10 @@
 #include "energy_gauge.h"
 #include "menu_sections.h"
 #include "movie.h"
+#include "movie_recorder.h"
 #include "log_recorder.h"
 #include "options_panel.h"
+#include "profiler.h"
 #include "gfx_wrapper.h"
 #ifdef USE_SCALE2X
 #include "scalebit.h"
@@ -99,6 +101,7 @@ display_init (void)
 {
   Uint32 i;
   Uint32 sdl_flag;
+  Uint32 window_flags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL;
 
   for (i = 0; i < MAX_OF_SURFACES; i++)
     {
@@ -108,10 +111,21 @@ display_init (void)
    window_width = 320;
    window_height = 200;
 
+  /* nothing is drawn: the video runs headless, without a connection
+   * to the display server which forked children could share */
+  if (render_disabled)
+    {
+      setenv ("SDL_VIDEODRIVER", "dummy", 1);
+      window_flags = SDL_WINDOW_HIDDEN;
+    }
+
   /* initialize SDL screen */
   sdl_flag = SDL_INIT_VIDEO;
 #ifdef USE_SDL_JOYSTICK
-  sdl_flag |= SDL_INIT_JOYSTICK;
+  if (!render_disabled)
+    {
+      sdl_flag |= SDL_INIT_JOYSTICK;
+    }
 #endif
   if (SDL_Init (sdl_flag) != 0)
     {
@@ -119,13 +133,17 @@ display_init (void)
       return FALSE;
     }
 #ifdef USE_SDL_JOYSTICK
-  if (!display_open_joysticks ())
+  if (!render_disabled && !display_open_joysticks ())
     {
       return FALSE;
     }
 #endif
 
-	SDL_CreateWindowAndRenderer(640, 400, SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL, &sdlWindow, &sdlRenderer);
+  if (power_conf->vsync)
+    {
+      SDL_SetHint (SDL_HINT_RENDER_VSYNC, "1");
+    }
+	SDL_CreateWindowAndRenderer(640, 400, window_flags, &sdlWindow, &sdlRenderer);
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
 	SDL_RenderSetLogicalSize(sdlRenderer, 320, 200);
 
@@ -151,6 +169,12 @@ display_init (void)
 		return FALSE;
 	}
 	
+  display_vsync = (rInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+  if (power_conf->vsync && !display_vsync)
+    {
+      LOG_WARN ("the renderer doesn't wait for the vertical retrace");
+    }
+
 	bits_per_pixel = SDL_BITSPERPIXEL(rInfo.texture_formats[0]);
 	bytes_per_pixel = SDL_BYTESPERPIXEL(rInfo.texture_formats[0]);
 	
@@ -736,6 +760,12 @@ key_status (const Uint8 * k)
 void
 display_update_window (void)
 {
+  if (render_disabled)
+    {
+      /* nothing draws the option boxes, drop their refreshes */
+      opt_refresh_index = -1;
+      return;
+    }
   /* movie is playing? */
   if (movie_surface != NULL)
     {
@@ -820,6 +850,7 @@ display (void)
   rsour.y = (Sint16) offscreen_clipsize;
   rsour.w = (Uint16) offscreen_width_visible;
   rsour.h = (Uint16) offscreen_height_visible;
+  PROFILER_BEGIN (PROFILER_BLITS);
   get_rect (&rdest, 0, 16, (Sint16) display_width, (Sint16) display_height);
   if (SDL_BlitSurface (game_surface, &rsour, public_surface, &rdest) < 0)
     {
@@ -957,15 +988,49 @@ display (void)
           is_player_score_displayed = FALSE;
         }
     }
+  PROFILER_END ();
+  PROFILER_BEGIN (PROFILER_RECORD);
+  movie_recorder_frame (public_surface->pixels, public_surface->pitch);
+  PROFILER_END ();
+  PROFILER_BEGIN (PROFILER_PRESENT);
     SDL_UpdateTexture(public_texture, NULL, public_surface->pixels, public_surface->pitch);
 	SDL_RenderClear(sdlRenderer);
 	SDL_RenderCopy(sdlRenderer, public_texture, NULL, NULL);
 	SDL_RenderPresent(sdlRenderer);
+  PROFILER_END ();
   
   /* SDL_UpdateRect (public_surface, 0, 16, 256, 184); */
 
 }
 
+/**
+ * Start recording the screen of the game into a movie file
+ * @param filename Filename of the movie file
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+display_record_start (const char *filename)
+{
+  Uint32 colors[256];
+  Uint32 i;
+  for (i = 0; i < 256; i++)
+    {
+      switch (bytes_per_pixel)
+        {
+        case 1:
+          colors[i] = i;
+          break;
+        case 2:
+          colors[i] = pal16[i];
+          break;
+        default:
+          colors[i] = pal32[i];
+          break;
+        }
+    }
+  return movie_recorder_open (filename, colors, bytes_per_pixel);
+}
+
 #ifdef USE_SDL_JOYSTICK
 /**
  * Opens all joysticks available
@@ -1079,6 +1144,10 @@ void
 display_clear_offscreen (void)
 {
   SDL_Rect rect;
+  if (render_disabled)
+    {
+      return;
+    }
   rect.x = (Sint16) offscreen_clipsize;
   rect.y = (Sint16) offscreen_clipsize;
   rect.w = (Uint16) offscreen_width_visible;
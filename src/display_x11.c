@@ -599,6 +599,12 @@ display_handle_events (void)
 void
 display_update_window (void)
 {
+  if (render_disabled)
+    {
+      /* nothing draws the option boxes, drop their refreshes */
+      opt_refresh_index = -1;
+      return;
+    }
   /* currently play a movie? */
   if (movie_ximage)
     {
@@ -1421,6 +1427,10 @@ display_free (void)
 void
 display_clear_offscreen (void)
 {
+  if (render_disabled)
+    {
+      return;
+    }
   /* clear logical screen */
   clear_offscreen (game_offscreen +
                    (offscreen_clipsize * offscreen_pitch) +
@@ -1431,6 +1441,18 @@ display_clear_offscreen (void)
                     offscreen_width_visible) * bytes_per_pixel);
 }
 
+/**
+ * Start recording the screen of the game into a movie file
+ * @param filename Filename of the movie file
+ * @return Always FALSE, not supported by the X11 display
+ */
+bool
+display_record_start (const char *filename)
+{
+  LOG_ERR ("\"%s\" can't be recorded with the X11 display", filename);
+  return FALSE;
+}
+
 /**
  * Initialize small cursor (one pixel)
  */
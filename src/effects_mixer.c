@@ -0,0 +1,494 @@
+/**
+ * @file effects_mixer.c
+ * @brief Mix the sound effects in the SDL_mixer post mix callback
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: effects_mixer.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "log_recorder.h"
+#ifdef USE_SDLMIXER
+#include "effects_mixer.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * The game thread only sets one bit per requested sound in an atomic
+ * mask. The audio callback takes the whole mask at once, so a sound
+ * requested several times between two callbacks starts a single voice.
+ * The voices are mixed with a 8-bit fixed-point volume into a 32-bit
+ * accumulator, then added with saturation to the stream which already
+ * holds the music.
+ */
+
+/** Maximum number of voices mixed at the same time */
+#define EFFECTS_MAX_OF_VOICES 32
+/** Number of samples mixed at once in the accumulator */
+#define EFFECTS_BLOCK_SIZE 1024
+
+typedef struct effects_voice
+{
+  /** Signed 16-bit samples of the sound, NULL if the voice is free */
+  const Sint16 *samples;
+  /** Number of samples of the sound */
+  Uint32 length;
+  /** Next sample to mix */
+  Uint32 position;
+  /** Priority of the sound, the higher the more important */
+  Uint32 priority;
+} effects_voice;
+
+/** Sounds converted to the format of the audio device */
+static Mix_Chunk **effects_chunks = NULL;
+static const Uint8 *effects_priorities = NULL;
+static Uint32 effects_num_of_sounds = 0;
+static effects_voice voices[EFFECTS_MAX_OF_VOICES];
+static Uint32 effects_num_of_voices = 0;
+/** Bit mask of the sounds requested since the last callback */
+static SDL_atomic_t effects_requests;
+/** Volume from 0 to MIX_MAX_VOLUME */
+static SDL_atomic_t effects_volume;
+static Sint32 accumulator[EFFECTS_BLOCK_SIZE];
+static bool effects_opened = FALSE;
+/** Sample frames per second and bytes per sample frame of the device */
+static Uint32 effects_frequency = 0;
+static Uint32 effects_frame_size = 0;
+
+/*
+ * Latency probe: time in microseconds of the first request since the
+ * last callback, and time from the request to the callback which mixes
+ * its first samples. The audio thread writes, the overlay reads.
+ */
+static SDL_atomic_t latency_request_time;
+static SDL_atomic_t latency_last;
+static SDL_atomic_t latency_max;
+static SDL_atomic_t latency_underruns;
+static SDL_atomic_t latency_average;
+static SDL_atomic_t latency_count;
+static SDL_atomic_t effects_buffer_us;
+/* only used by the audio thread */
+static Uint64 latency_total = 0;
+static Uint32 previous_callback_time = 0;
+
+/* statistics written by the audio callback, read once closed */
+static Uint32 stats_callbacks = 0;
+static Uint64 stats_total_ticks = 0;
+static Uint64 stats_max_ticks = 0;
+static Uint32 stats_started = 0;
+static Uint32 stats_stolen = 0;
+static Uint32 stats_dropped = 0;
+
+static void effects_mix (void *udata, Uint8 * stream, int len);
+
+/**
+ * Return the current time in microseconds, wraps every 71 minutes
+ * @return Time in microseconds
+ */
+static Uint32
+effects_time_us (void)
+{
+  Uint64 ticks = SDL_GetPerformanceCounter ();
+  Uint64 frequency = SDL_GetPerformanceFrequency ();
+  /* exact for any frequency of the counter, without overflow */
+  return (Uint32) (ticks / frequency * 1000000 +
+                   ticks % frequency * 1000000 / frequency);
+}
+
+/**
+ * Mix the sound effects into the SDL_mixer output from now on
+ * @param chunks Sounds loaded with Mix_LoadWAV()
+ * @param priorities Priority of each sound, the higher the more important
+ * @param num_of_sounds Number of sounds, up to EFFECTS_MAX_OF_SOUNDS
+ * @param num_of_voices Maximum number of sounds played at the same time
+ * @return FALSE if the sounds must be played by SDL_mixer
+ */
+bool
+effects_mixer_open (Mix_Chunk ** chunks, const Uint8 * priorities,
+                    Uint32 num_of_sounds, Uint32 num_of_voices)
+{
+  int frequency, channels;
+  Uint16 format;
+  if (!Mix_QuerySpec (&frequency, &format, &channels))
+    {
+      LOG_ERR ("Mix_QuerySpec() failed: %s", Mix_GetError ());
+      return FALSE;
+    }
+  if (format != AUDIO_S16SYS || num_of_sounds > EFFECTS_MAX_OF_SOUNDS)
+    {
+      LOG_WARN ("audio format %x not supported by the effects mixer",
+                format);
+      return FALSE;
+    }
+  effects_chunks = chunks;
+  effects_priorities = priorities;
+  effects_num_of_sounds = num_of_sounds;
+  effects_num_of_voices = num_of_voices > EFFECTS_MAX_OF_VOICES ?
+    EFFECTS_MAX_OF_VOICES : num_of_voices;
+  memset (voices, 0, sizeof (voices));
+  SDL_AtomicSet (&effects_requests, 0);
+  SDL_AtomicSet (&effects_volume, MIX_MAX_VOLUME);
+  stats_callbacks = 0;
+  stats_total_ticks = 0;
+  stats_max_ticks = 0;
+  stats_started = 0;
+  stats_stolen = 0;
+  stats_dropped = 0;
+  effects_frequency = frequency;
+  effects_frame_size = sizeof (Sint16) * channels;
+  SDL_AtomicSet (&latency_last, 0);
+  SDL_AtomicSet (&latency_max, 0);
+  SDL_AtomicSet (&latency_underruns, 0);
+  SDL_AtomicSet (&latency_average, 0);
+  SDL_AtomicSet (&latency_count, 0);
+  SDL_AtomicSet (&effects_buffer_us, 0);
+  latency_total = 0;
+  previous_callback_time = 0;
+  Mix_SetPostMix (effects_mix, NULL);
+  effects_opened = TRUE;
+  LOG_INF ("effects mixer: %i voices, %i Hz, %i channels",
+           effects_num_of_voices, frequency, channels);
+  return TRUE;
+}
+
+/**
+ * Request to play a sound effect, called by the game thread
+ * @param sound_num Number of the sound
+ */
+void
+effects_mixer_play (Uint32 sound_num)
+{
+  int requests;
+  Uint32 now = effects_time_us ();
+  do
+    {
+      requests = SDL_AtomicGet (&effects_requests);
+    }
+  while (!SDL_AtomicCAS
+         (&effects_requests, requests, requests | (int) (1U << sound_num)));
+  if (requests == 0)
+    {
+      /* first request since the last callback */
+      SDL_AtomicSet (&latency_request_time, (int) now);
+    }
+}
+
+/**
+ * Return the measures of the latency probe
+ * @param last_us Time from the last request to the callback which
+ *                mixed it, in microseconds
+ * @param max_us Maximum of this time
+ * @param buffer_us Duration of the last audio buffer, the time the
+ *                  mixed samples wait before they are heard
+ * @param underruns Number of callbacks which came too late
+ */
+void
+effects_mixer_latency (Uint32 * last_us, Uint32 * max_us, Uint32 * buffer_us,
+                       Uint32 * underruns)
+{
+  *last_us = SDL_AtomicGet (&latency_last);
+  *max_us = SDL_AtomicGet (&latency_max);
+  *buffer_us = SDL_AtomicGet (&effects_buffer_us);
+  *underruns = SDL_AtomicGet (&latency_underruns);
+}
+
+/**
+ * Set the volume of the sound effects
+ * @param volume Volume from 0 to MIX_MAX_VOLUME
+ */
+void
+effects_mixer_volume (Uint32 volume)
+{
+  SDL_AtomicSet (&effects_volume, volume);
+}
+
+/**
+ * Stop mixing the sound effects and print the cost of the mixing
+ */
+void
+effects_mixer_close (void)
+{
+  if (!effects_opened)
+    {
+      return;
+    }
+  Mix_SetPostMix (NULL, NULL);
+  effects_opened = FALSE;
+  if (SDL_AtomicGet (&latency_count) > 0)
+    {
+      LOG_INF ("effects mixer latency: average %i us; maximum %i us; "
+               "buffer %i us; %i late callbacks",
+               SDL_AtomicGet (&latency_average),
+               SDL_AtomicGet (&latency_max),
+               SDL_AtomicGet (&effects_buffer_us),
+               SDL_AtomicGet (&latency_underruns));
+    }
+  if (stats_callbacks > 0)
+    {
+      LOG_INF ("effects mixer: %i callbacks; average %i us; maximum %i us",
+               stats_callbacks,
+               (Uint32) (stats_total_ticks * 1000000 /
+                         SDL_GetPerformanceFrequency () / stats_callbacks),
+               (Uint32) (stats_max_ticks * 1000000 /
+                         SDL_GetPerformanceFrequency ()));
+    }
+  LOG_INF ("effects mixer: %i sounds started; %i voices stolen; %i dropped",
+           stats_started, stats_stolen, stats_dropped);
+}
+
+/**
+ * Start a voice, a free one or the one of the less important sound,
+ * the oldest for a same priority
+ * @param sound_num Number of the sound
+ */
+static void
+effects_start (Uint32 sound_num)
+{
+  Uint32 i, priority;
+  effects_voice *voice = NULL;
+  Mix_Chunk *chunk = effects_chunks[sound_num];
+  if (chunk == NULL || chunk->alen < sizeof (Sint16))
+    {
+      return;
+    }
+  priority = effects_priorities[sound_num];
+  for (i = 0; i < effects_num_of_voices; i++)
+    {
+      if (voices[i].samples == NULL)
+        {
+          voice = &voices[i];
+          break;
+        }
+      if (voices[i].priority > priority)
+        {
+          continue;
+        }
+      if (voice == NULL || voices[i].priority < voice->priority
+          || (voices[i].priority == voice->priority
+              && voices[i].position > voice->position))
+        {
+          voice = &voices[i];
+        }
+    }
+  if (voice == NULL)
+    {
+      /* all the voices play more important sounds */
+      stats_dropped++;
+      return;
+    }
+  if (voice->samples != NULL)
+    {
+      stats_stolen++;
+    }
+  voice->samples = (const Sint16 *) chunk->abuf;
+  voice->length = chunk->alen / sizeof (Sint16);
+  voice->position = 0;
+  voice->priority = priority;
+  stats_started++;
+}
+
+/**
+ * Add samples multiplied by a volume to the accumulator
+ * @param acc Pointer to the 32-bit accumulator
+ * @param src Pointer to the signed 16-bit samples
+ * @param count Number of samples
+ * @param volume Volume from 0 to MIX_MAX_VOLUME
+ */
+static void
+effects_accumulate (Sint32 * acc, const Sint16 * src, Uint32 count,
+                    Sint32 volume)
+{
+  Uint32 i = 0;
+#if defined(__SSE2__)
+  __m128i s, lo, hi;
+  __m128i v = _mm_set1_epi16 ((short) volume);
+  for (; i + 8 <= count; i += 8)
+    {
+      s = _mm_loadu_si128 ((const __m128i *) (src + i));
+      lo = _mm_mullo_epi16 (s, v);
+      hi = _mm_mulhi_epi16 (s, v);
+      _mm_storeu_si128 ((__m128i *) (acc + i),
+                        _mm_add_epi32 (_mm_loadu_si128
+                                       ((__m128i *) (acc + i)),
+                                       _mm_unpacklo_epi16 (lo, hi)));
+      _mm_storeu_si128 ((__m128i *) (acc + i + 4),
+                        _mm_add_epi32 (_mm_loadu_si128
+                                       ((__m128i *) (acc + i + 4)),
+                                       _mm_unpackhi_epi16 (lo, hi)));
+    }
+#endif
+  for (; i < count; i++)
+    {
+      acc[i] += src[i] * volume;
+    }
+}
+
+/**
+ * Add the accumulator to the stream, with saturation
+ * @param dest Pointer to the signed 16-bit samples of the stream
+ * @param acc Pointer to the 32-bit accumulator
+ * @param count Number of samples
+ */
+static void
+effects_output (Sint16 * dest, const Sint32 * acc, Uint32 count)
+{
+  Uint32 i = 0;
+  Sint32 sample;
+#if defined(__SSE2__)
+  __m128i a0, a1, d;
+  for (; i + 8 <= count; i += 8)
+    {
+      a0 = _mm_srai_epi32 (_mm_loadu_si128 ((const __m128i *) (acc + i)), 7);
+      a1 =
+        _mm_srai_epi32 (_mm_loadu_si128 ((const __m128i *) (acc + i + 4)),
+                        7);
+      d = _mm_loadu_si128 ((__m128i *) (dest + i));
+      /* sign extend the stream samples and saturate the 32-bit sums */
+      a0 = _mm_add_epi32 (a0, _mm_srai_epi32 (_mm_unpacklo_epi16 (d, d), 16));
+      a1 = _mm_add_epi32 (a1, _mm_srai_epi32 (_mm_unpackhi_epi16 (d, d), 16));
+      _mm_storeu_si128 ((__m128i *) (dest + i), _mm_packs_epi32 (a0, a1));
+    }
+#endif
+  for (; i < count; i++)
+    {
+      sample = dest[i] + (acc[i] >> 7);
+      if (sample > 32767)
+        {
+          sample = 32767;
+        }
+      else if (sample < -32768)
+        {
+          sample = -32768;
+        }
+      dest[i] = (Sint16) sample;
+    }
+}
+
+/**
+ * SDL_mixer post mix callback, runs in the audio thread
+ * @param udata Not used
+ * @param stream Output of SDL_mixer, music included
+ * @param len Size of the stream in bytes
+ */
+static void
+effects_mix (void *udata, Uint8 * stream, int len)
+{
+  Uint32 i, offset, size, count, num_of_samples;
+  Sint32 volume;
+  int requests;
+  Uint32 now, latency, buffer_us, numof_latencies;
+  bool is_playing = FALSE;
+  effects_voice *voice;
+  Uint64 ticks = SDL_GetPerformanceCounter ();
+  (void) udata;
+
+  /* a callback later than one buffer and a half let the device starve */
+  now = effects_time_us ();
+  buffer_us =
+    (Uint32) ((Uint64) len * 1000000 / effects_frame_size /
+              effects_frequency);
+  SDL_AtomicSet (&effects_buffer_us, (int) buffer_us);
+  if (previous_callback_time != 0
+      && now - previous_callback_time > buffer_us * 3 / 2)
+    {
+      SDL_AtomicAdd (&latency_underruns, 1);
+    }
+  previous_callback_time = now;
+
+  /* take all the requests at once */
+  do
+    {
+      requests = SDL_AtomicGet (&effects_requests);
+    }
+  while (!SDL_AtomicCAS (&effects_requests, requests, 0));
+  if (requests != 0)
+    {
+      latency = now - (Uint32) SDL_AtomicGet (&latency_request_time);
+      SDL_AtomicSet (&latency_last, latency);
+      if (latency > (Uint32) SDL_AtomicGet (&latency_max))
+        {
+          SDL_AtomicSet (&latency_max, latency);
+        }
+      latency_total += latency;
+      numof_latencies = (Uint32) SDL_AtomicAdd (&latency_count, 1) + 1;
+      SDL_AtomicSet (&latency_average,
+                     (int) (latency_total / numof_latencies));
+    }
+  for (i = 0; i < effects_num_of_sounds; i++)
+    {
+      if (requests & (int) (1U << i))
+        {
+          effects_start (i);
+        }
+    }
+  for (i = 0; i < effects_num_of_voices && !is_playing; i++)
+    {
+      is_playing = voices[i].samples != NULL;
+    }
+  if (!is_playing)
+    {
+      return;
+    }
+
+  volume = SDL_AtomicGet (&effects_volume);
+  num_of_samples = (Uint32) len / sizeof (Sint16);
+  for (offset = 0; offset < num_of_samples; offset += size)
+    {
+      size = num_of_samples - offset;
+      if (size > EFFECTS_BLOCK_SIZE)
+        {
+          size = EFFECTS_BLOCK_SIZE;
+        }
+      memset (accumulator, 0, size * sizeof (Sint32));
+      for (i = 0; i < effects_num_of_voices; i++)
+        {
+          voice = &voices[i];
+          if (voice->samples == NULL)
+            {
+              continue;
+            }
+          count = voice->length - voice->position;
+          if (count > size)
+            {
+              count = size;
+            }
+          effects_accumulate (accumulator, voice->samples + voice->position,
+                              count, volume);
+          voice->position += count;
+          if (voice->position >= voice->length)
+            {
+              voice->samples = NULL;
+            }
+        }
+      effects_output ((Sint16 *) stream + offset, accumulator, size);
+    }
+
+  ticks = SDL_GetPerformanceCounter () - ticks;
+  stats_callbacks++;
+  stats_total_ticks += ticks;
+  if (ticks > stats_max_ticks)
+    {
+      stats_max_ticks = ticks;
+    }
+}
+#endif
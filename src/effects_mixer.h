@@ -0,0 +1,51 @@
+/**
+ * @file effects_mixer.h
+ * @brief Mix the sound effects in the SDL_mixer post mix callback
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: effects_mixer.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __EFFECTS_MIXER__
+#define __EFFECTS_MIXER__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef USE_SDLMIXER
+/** Maximum number of sound effects, one bit each in the requests mask */
+#define EFFECTS_MAX_OF_SOUNDS 32
+
+  bool effects_mixer_open (Mix_Chunk ** chunks, const Uint8 * priorities,
+                           Uint32 num_of_sounds, Uint32 num_of_voices);
+  void effects_mixer_play (Uint32 sound_num);
+  void effects_mixer_volume (Uint32 volume);
+  void effects_mixer_latency (Uint32 * last_us, Uint32 * max_us,
+                              Uint32 * buffer_us, Uint32 * underruns);
+  void effects_mixer_close (void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
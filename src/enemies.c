@@ -163,7 +163,7 @@ enemies_load (void)
     {
       return FALSE;
     }
-  free_memory (filedata);
+  free_file (filedata);
   return TRUE;
 }
 
@@ -455,6 +455,7 @@ static bool
 enemy_curve (enemy * foe)
 {
   Sint32 k;
+  const curve_point *point;
   sprite *spr = &foe->spr;
 
   if (!player_pause && menu_status == MENU_OFF
@@ -470,16 +471,14 @@ enemy_curve (enemy * foe)
           return FALSE;
         }
       /* update x and y coordinates */
-      spr->xcoord +=
-        (float) initial_curve[foe->num_courbe].
-        delta_x[foe->pos_vaiss[POS_CURVE]];
-      spr->ycoord +=
-        (float) initial_curve[foe->num_courbe].
-        delta_y[foe->pos_vaiss[POS_CURVE]];
+      point =
+        &initial_curve[foe->num_courbe].points[foe->pos_vaiss[POS_CURVE]];
+      spr->xcoord += (float) point->delta_x;
+      spr->ycoord += (float) point->delta_y;
     }
   /* set current image of the enemy sprite */
   spr->current_image =
-    initial_curve[foe->num_courbe].angle[foe->pos_vaiss[POS_CURVE]];
+    initial_curve[foe->num_courbe].points[foe->pos_vaiss[POS_CURVE]].angle;
   /* 
    * check if the sprite is visible or not 
    */
@@ -602,10 +601,10 @@ enemy_curve (enemy * foe)
 
   if (spaceship_enemy_collision
       (foe,
-       (float) initial_curve[foe->num_courbe].delta_x[foe->
-                                                      pos_vaiss[POS_CURVE]],
-       (float) initial_curve[foe->num_courbe].delta_y[foe->
-                                                      pos_vaiss[POS_CURVE]]))
+       (float) initial_curve[foe->num_courbe].
+       points[foe->pos_vaiss[POS_CURVE]].delta_x,
+       (float) initial_curve[foe->num_courbe].
+       points[foe->pos_vaiss[POS_CURVE]].delta_y))
     {
       explosion_add (spr->xcoord, spr->ycoord, 0.25, foe->type, 0);
       explosions_fragments_add (spr->xcoord +
@@ -1105,6 +1104,7 @@ enemy_lonely_towards_right (enemy * foe)
 static bool
 enemy_lonely_follow_curve (enemy * foe)
 {
+  const curve_point *point;
   sprite *spr = &foe->spr;
   if (!player_pause && menu_status == MENU_OFF
       && menu_section == NO_SECTION_SELECTED)
@@ -1118,16 +1118,14 @@ enemy_lonely_follow_curve (enemy * foe)
           return FALSE;
         }
       /* update y and x coordinates of the foe */
-      spr->xcoord +=
-        (float) initial_curve[foe->num_courbe].delta_x[foe->
-                                                       pos_vaiss[POS_CURVE]];
-      spr->ycoord +=
-        (float) initial_curve[foe->num_courbe].delta_y[foe->
-                                                       pos_vaiss[POS_CURVE]];
+      point =
+        &initial_curve[foe->num_courbe].points[foe->pos_vaiss[POS_CURVE]];
+      spr->xcoord += (float) point->delta_x;
+      spr->ycoord += (float) point->delta_y;
     }
   /* set current image of the foe sprite */
   spr->current_image =
-    initial_curve[foe->num_courbe].angle[foe->pos_vaiss[POS_CURVE]];
+    initial_curve[foe->num_courbe].points[foe->pos_vaiss[POS_CURVE]].angle;
   /* check if the sprite is visible or not  */
   if (((Sint16) spr->xcoord + spr->img[spr->current_image]->w) <
       offscreen_startx
@@ -1847,6 +1845,33 @@ enemy_get_first (void)
   return enemy_first;
 }
 
+/**
+ * Fold the state of all active enemies into a hash
+ * @param hash Current hash value
+ * @return The updated hash value
+ */
+Uint32
+enemies_hash (Uint32 hash)
+{
+  Sint32 i;
+  enemy *foe = enemy_first;
+  for (i = 0; i < num_of_enemies && foe != NULL; i++, foe = foe->next)
+    {
+      hash = sprite_hash (hash, &foe->spr);
+      hash = hash_fnv1a (hash, &foe->dead, sizeof (foe->dead));
+      hash = hash_fnv1a (hash, &foe->invincible, sizeof (foe->invincible));
+      hash = hash_fnv1a (hash, &foe->fire_rate_count,
+                         sizeof (foe->fire_rate_count));
+      hash = hash_fnv1a (hash, &foe->displacement,
+                         sizeof (foe->displacement));
+      hash = hash_fnv1a (hash, &foe->pos_vaiss[0], sizeof (foe->pos_vaiss));
+      hash = hash_fnv1a (hash, &foe->type, sizeof (foe->type));
+      hash = hash_fnv1a (hash, &foe->timelife, sizeof (foe->timelife));
+      hash = hash_fnv1a (hash, &foe->img_angle, sizeof (foe->img_angle));
+    }
+  return hash;
+}
+
 /** 
  * Remove a enemy element from list
  * @param Pointer to a enemy structure 
@@ -156,6 +156,7 @@ extern "C"
   void enemy_set_fadeout (enemy * foe);
   enemy *enemy_get (void);
   enemy *enemy_get_first (void);
+  Uint32 enemies_hash (Uint32 hash);
   void enemy_draw (enemy * foe);
   void enemy_guns_collisions (enemy * foe);
   void enemy_satellites_collisions (enemy * foe);
@@ -289,6 +289,30 @@ explosions_handle ()
     }
 }
 
+/**
+ * Fold the state of all active explosions into a hash
+ * @param hash Current hash value
+ * @return The updated hash value
+ */
+Uint32
+explosions_hash (Uint32 hash)
+{
+  Sint32 i;
+  explosion_struct *blast = explosion_first;
+  for (i = 0; i < num_of_explosions && blast != NULL;
+       i++, blast = blast->next)
+    {
+      hash = hash_fnv1a (hash, &blast->current_image,
+                         sizeof (blast->current_image));
+      hash = hash_fnv1a (hash, &blast->anim_count,
+                         sizeof (blast->anim_count));
+      hash = hash_fnv1a (hash, &blast->xcoord, sizeof (blast->xcoord));
+      hash = hash_fnv1a (hash, &blast->ycoord, sizeof (blast->ycoord));
+      hash = hash_fnv1a (hash, &blast->countdown, sizeof (blast->countdown));
+    }
+  return hash;
+}
+
 /** 
  * Add a new explosion 
  * @param coordx X-coordinate 
@@ -45,6 +45,7 @@ extern "C"
 #endif
   void explosions_free (void);
   void explosions_handle (void);
+  Uint32 explosions_hash (Uint32 hash);
   void explosions_add_serie (enemy * foe);
   void explosion_add (float coordx, float coordy, float speed, Sint32 type,
                       Sint32 delay);
@@ -0,0 +1,115 @@
+/**
+ * @file frame_pacer.c
+ * @brief Wait for the deadlines of the frames
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: frame_pacer.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "log_recorder.h"
+#include "frame_pacer.h"
+#include <time.h>
+#include <sched.h>
+
+/** Time of the deadline of the first frame at the current rate */
+static Uint64 origin = 0;
+/** Number of frames since the origin */
+static Uint64 numof_periods = 0;
+/** Current number of frames per second, 0 before the first frame */
+static Uint32 current_rate = 0;
+
+/**
+ * Return the monotonic time
+ * @return Time in nanoseconds
+ */
+static Uint64
+pacer_time (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (Uint64) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Return the deadline of a frame, the deadlines don't drift:
+ * they are computed from the origin and not from the previous one
+ * @param periods Number of frames since the origin
+ * @return Time of the deadline in nanoseconds
+ */
+static Uint64
+pacer_deadline (Uint64 periods)
+{
+  return origin + periods * 1000000000 / current_rate;
+}
+
+/**
+ * Wait for the deadline of the next frame: sleep until near the
+ * deadline, then spin. A frame later than a whole period restarts
+ * the deadlines from now, the game doesn't try to catch up
+ * @param rate Number of frames per second
+ * @param jitter Time in microseconds between the deadline and the
+ *               end of the wait, the lateness of a late frame
+ * @return TRUE if the frame was on schedule, or FALSE if it was
+ *         late and the deadlines restarted
+ */
+bool
+frame_pacer_wait (Uint32 rate, Uint32 * jitter)
+{
+  Uint64 now = pacer_time ();
+  Uint64 deadline, wake;
+  struct timespec sleep;
+  Sint32 result;
+  if (rate != current_rate)
+    {
+      /* the new cadence starts from the last deadline */
+      origin = current_rate == 0 ? now : pacer_deadline (numof_periods);
+      numof_periods = 0;
+      current_rate = rate;
+    }
+  deadline = pacer_deadline (++numof_periods);
+  if (now > deadline + 1000000000 / rate)
+    {
+      *jitter = (Uint32) ((now - deadline) / 1000);
+      origin = now;
+      numof_periods = 0;
+      return FALSE;
+    }
+  if (deadline > now + FRAME_PACER_SPIN)
+    {
+      wake = deadline - FRAME_PACER_SPIN;
+      sleep.tv_sec = wake / 1000000000;
+      sleep.tv_nsec = wake % 1000000000;
+      do
+        {
+          result =
+            clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &sleep, NULL);
+        }
+      while (result == EINTR);
+    }
+  while ((now = pacer_time ()) < deadline)
+    {
+      sched_yield ();
+    }
+  *jitter = (Uint32) ((now - deadline) / 1000);
+  return TRUE;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file frame_pacer.h
+ * @brief Wait for the deadlines of the frames
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: frame_pacer.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __FRAME_PACER__
+#define __FRAME_PACER__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** The last part of a wait spins instead of sleeping, in
+ * nanoseconds */
+#define FRAME_PACER_SPIN 1000000
+
+  bool frame_pacer_wait (Uint32 rate, Uint32 * jitter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
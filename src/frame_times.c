@@ -0,0 +1,293 @@
+/**
+ * @file frame_times.c
+ * @brief Histograms of the durations of the frames
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: frame_times.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "log_recorder.h"
+#include "frame_times.h"
+#include <time.h>
+
+/** The durations below are recorded exactly, each power of two
+ * above is divided into FRAME_TIMES_SUB_BUCKETS buckets: the
+ * precision is about 3% */
+#define FRAME_TIMES_SUB_BUCKETS 32
+/** Number of buckets for durations up to 2^32 microseconds */
+#define FRAME_TIMES_BUCKETS ((32 - 5) * FRAME_TIMES_SUB_BUCKETS + 32)
+
+/** Durations in microseconds of one kind of time */
+typedef struct frame_histogram
+{
+  Uint32 buckets[FRAME_TIMES_BUCKETS];
+  Uint32 count;
+  Uint32 maximum;
+  Uint64 sum;
+} frame_histogram;
+
+static frame_histogram histograms[FRAME_TIMES_NUMOF];
+static const char *histograms_names[FRAME_TIMES_NUMOF] = {
+  "frame",
+  "busy",
+  "update",
+  "jitter"
+};
+
+/** Percentiles reported, in thousandths */
+static const Uint32 percentiles[] = { 500, 900, 990, 999 };
+
+#define FRAME_TIMES_NUMOF_PERCENTILES \
+  (sizeof (percentiles) / sizeof (percentiles[0]))
+
+/** Number of frames whose busy time was over the budget */
+static Uint32 frames_over_budget = 0;
+static Uint32 missed_streak = 0;
+static Uint32 longest_missed_streak = 0;
+
+/**
+ * Return the monotonic time
+ * @return Time in microseconds
+ */
+Uint64
+frame_times_now (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (Uint64) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Return the bucket of a duration
+ * @param duration Duration in microseconds
+ * @return Index of the bucket
+ */
+static Uint32
+bucket_index (Uint32 duration)
+{
+  Uint32 shift = 0;
+  if (duration < 2 * FRAME_TIMES_SUB_BUCKETS)
+    {
+      return duration;
+    }
+  while ((duration >> shift) >= 2 * FRAME_TIMES_SUB_BUCKETS)
+    {
+      shift++;
+    }
+  return shift * FRAME_TIMES_SUB_BUCKETS + (duration >> shift);
+}
+
+/**
+ * Return the highest duration of a bucket
+ * @param index Index of the bucket
+ * @return Duration in microseconds
+ */
+static Uint32
+bucket_highest (Uint32 index)
+{
+  Uint32 shift;
+  if (index < 2 * FRAME_TIMES_SUB_BUCKETS)
+    {
+      return index;
+    }
+  shift = index / FRAME_TIMES_SUB_BUCKETS - 1;
+  return (((index % FRAME_TIMES_SUB_BUCKETS + FRAME_TIMES_SUB_BUCKETS + 1)
+           << shift) - 1);
+}
+
+/**
+ * Return a percentile of a histogram
+ * @param histogram A histogram
+ * @param thousandths The percentile in thousandths
+ * @return The highest duration of the bucket of the percentile, in
+ *         microseconds, not above the maximum
+ */
+static Uint32
+histogram_percentile (const frame_histogram * histogram, Uint32 thousandths)
+{
+  Uint64 rank, count = 0;
+  Uint32 i, duration;
+  if (histogram->count == 0)
+    {
+      return 0;
+    }
+  rank = ((Uint64) histogram->count * thousandths + 999) / 1000;
+  for (i = 0; i < FRAME_TIMES_BUCKETS; i++)
+    {
+      count += histogram->buckets[i];
+      if (count >= rank)
+        {
+          break;
+        }
+    }
+  duration = bucket_highest (i);
+  return duration < histogram->maximum ? duration : histogram->maximum;
+}
+
+/**
+ * Clear the histograms
+ */
+void
+frame_times_reset (void)
+{
+  memset (histograms, 0, sizeof (histograms));
+  frames_over_budget = 0;
+  missed_streak = 0;
+  longest_missed_streak = 0;
+}
+
+/**
+ * Record a duration into a histogram
+ * @param kind The histogram
+ * @param duration The duration in microseconds
+ */
+void
+frame_times_add (FRAME_TIMES kind, Uint32 duration)
+{
+  frame_histogram *histogram = &histograms[kind];
+  histogram->buckets[bucket_index (duration)]++;
+  histogram->count++;
+  histogram->sum += duration;
+  if (duration > histogram->maximum)
+    {
+      histogram->maximum = duration;
+    }
+}
+
+/**
+ * Record the durations of a frame
+ * @param durations The durations of the frame, the busy time and
+ *                  update_frame() in microseconds
+ * @param budget Duration of a frame in microseconds at the rate of
+ *               the game or of the movies
+ */
+void
+frame_times_record (const Uint32 * durations, Uint32 budget)
+{
+  Uint32 i;
+  for (i = FRAME_TIMES_FRAME; i <= FRAME_TIMES_UPDATE; i++)
+    {
+      frame_times_add ((FRAME_TIMES) i, durations[i]);
+    }
+  /* the frame can't be on time, whatever the wait */
+  if (durations[FRAME_TIMES_BUSY] > budget)
+    {
+      frames_over_budget++;
+      missed_streak++;
+      if (missed_streak > longest_missed_streak)
+        {
+          longest_missed_streak = missed_streak;
+        }
+    }
+  else
+    {
+      missed_streak = 0;
+    }
+}
+
+/**
+ * Write the percentiles of the durations of the frames
+ */
+void
+frame_times_print (void)
+{
+  Uint32 i;
+  frame_histogram *histogram;
+  for (i = 0; i < FRAME_TIMES_NUMOF; i++)
+    {
+      histogram = &histograms[i];
+      if (histogram->count == 0)
+        {
+          continue;
+        }
+      LOG_INF ("%-6s us: mean %u; p50 %u; p90 %u; p99 %u; p99.9 %u; max %u",
+               histograms_names[i],
+               (Uint32) (histogram->sum / histogram->count),
+               histogram_percentile (histogram, 500),
+               histogram_percentile (histogram, 900),
+               histogram_percentile (histogram, 990),
+               histogram_percentile (histogram, 999), histogram->maximum);
+    }
+  LOG_INF ("frames over budget: %u of %u; longest streak of missed"
+           " frames: %u", frames_over_budget,
+           histograms[FRAME_TIMES_FRAME].count, longest_missed_streak);
+}
+
+/**
+ * Write the histograms into a JSON file
+ * @param filename Filename of the file
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+frame_times_write (const char *filename)
+{
+  FILE *file;
+  Uint32 i, j;
+  const char *separator;
+  frame_histogram *histogram;
+  file = fopen (filename, "w");
+  if (file == NULL)
+    {
+      LOG_ERR ("fopen(%s) failed (%s)", filename, strerror (errno));
+      return FALSE;
+    }
+  fprintf (file, "{\n\"frames\": %u,\n\"frames_over_budget\": %u,\n"
+           "\"longest_missed_streak\": %u",
+           histograms[FRAME_TIMES_FRAME].count, frames_over_budget,
+           longest_missed_streak);
+  for (i = 0; i < FRAME_TIMES_NUMOF; i++)
+    {
+      histogram = &histograms[i];
+      fprintf (file, ",\n\"%s\": {\"count\": %u, \"mean_us\": %u, "
+               "\"max_us\": %u", histograms_names[i], histogram->count,
+               histogram->count > 0 ?
+               (Uint32) (histogram->sum / histogram->count) : 0,
+               histogram->maximum);
+      for (j = 0; j < FRAME_TIMES_NUMOF_PERCENTILES; j++)
+        {
+          fprintf (file, ", \"p%g_us\": %u", percentiles[j] / 10.0,
+                   histogram_percentile (histogram, percentiles[j]));
+        }
+      /* the non empty buckets: highest duration and count */
+      fprintf (file, ",\n  \"buckets\": [");
+      separator = "";
+      for (j = 0; j < FRAME_TIMES_BUCKETS; j++)
+        {
+          if (histogram->buckets[j] == 0)
+            {
+              continue;
+            }
+          fprintf (file, "%s[%u, %u]", separator, bucket_highest (j),
+                   histogram->buckets[j]);
+          separator = ", ";
+        }
+      fprintf (file, "]}");
+    }
+  fprintf (file, "\n}\n");
+  if (fclose (file) != 0)
+    {
+      LOG_ERR ("fclose(%s) failed (%s)", filename, strerror (errno));
+      return FALSE;
+    }
+  return TRUE;
+}
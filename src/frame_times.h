@@ -0,0 +1,59 @@
+/**
+ * @file frame_times.h
+ * @brief Histograms of the durations of the frames
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: frame_times.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __FRAME_TIMES__
+#define __FRAME_TIMES__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Durations recorded for each frame */
+  typedef enum
+  {
+    /* whole iteration of the main loop */
+    FRAME_TIMES_FRAME,
+    /* the iteration without the wait for the next frame */
+    FRAME_TIMES_BUSY,
+    /* update_frame() */
+    FRAME_TIMES_UPDATE,
+    /* lateness of the end of the wait for the next frame */
+    FRAME_TIMES_JITTER,
+    FRAME_TIMES_NUMOF
+  } FRAME_TIMES;
+
+  Uint64 frame_times_now (void);
+  void frame_times_reset (void);
+  void frame_times_add (FRAME_TIMES kind, Uint32 duration);
+  void frame_times_record (const Uint32 * durations, Uint32 budget);
+  void frame_times_print (void);
+  bool frame_times_write (const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -37,6 +37,8 @@
 #include "gfx_wrapper.h"
 #include "gfxroutines.h"
 #include "log_recorder.h"
+#include "profiler.h"
+#include "render_list.h"
 #include "text_overlay.h"
 
 /**
@@ -88,6 +90,11 @@ draw_sprite_mask (Uint32 color, image * img, Uint32 xcoord, Uint32 ycoord)
 {
   Uint32 size;
   char *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_add (RENDER_SPRITE_MASK, img, xcoord, ycoord, color);
   dest =
     game_offscreen + (ycoord * offscreen_width + xcoord) * bytes_per_pixel;
   repeats = img->compress;
@@ -120,11 +127,17 @@ draw_sprite (image * img, Uint32 xcoord, Uint32 ycoord)
 {
   Uint32 size;
   char *source, *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_add (RENDER_SPRITE, img, xcoord, ycoord, 0);
   source = img->img;
   dest =
     game_offscreen + (ycoord * offscreen_pitch + xcoord * bytes_per_pixel);
   repeats = img->compress;
   size = img->nbr_data_comp >> 2;
+  PROFILER_BEGIN (PROFILER_SPRITES);
   switch (bytes_per_pixel)
     {
     case 1:
@@ -140,6 +153,7 @@ draw_sprite (image * img, Uint32 xcoord, Uint32 ycoord)
       put_sprite_32 (source, dest, repeats, size);
       break;
     }
+  PROFILER_END ();
 }
 
 /** 
@@ -153,6 +167,11 @@ draw_bitmap (bitmap * bmp, Uint32 xcoord, Uint32 ycoord)
 {
   Uint32 size;
   char *source, *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_add (RENDER_BITMAP, bmp, xcoord, ycoord, 0);
   source = bmp->img;
   dest =
     game_offscreen + (ycoord * offscreen_width + xcoord) * bytes_per_pixel;
@@ -186,6 +205,10 @@ draw_bitmap_in_score (bitmap * bmp, Uint32 xcoord, Uint32 ycoord)
 {
   Uint32 size;
   char *source, *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
   source = bmp->img;
   dest =
     scores_offscreen + ycoord * score_offscreen_pitch +
@@ -220,6 +243,10 @@ draw_bitmap_in_options (bitmap * bmp, Uint32 xcoord, Uint32 ycoord)
 {
   Uint32 size;
   char *source, *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
   source = bmp->img;
   dest =
     options_offscreen + (ycoord * OPTIONS_WIDTH + xcoord) * bytes_per_pixel;
@@ -253,6 +280,10 @@ draw_image_in_score (image * img, Uint32 xcoord, Uint32 ycoord)
 {
   Uint32 size;
   char *source, *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
   source = img->img;
   dest =
     scores_offscreen + ycoord * score_offscreen_pitch +
@@ -289,6 +320,10 @@ draw_image_in_score_repeat (image * img, Uint32 xcoord, Uint32 ycoord,
 {
   Uint32 i, step, size;
   char *source, *dest, *repeats;
+  if (render_disabled)
+    {
+      return;
+    }
   source = img->img;
   dest =
     scores_offscreen + ycoord * score_offscreen_pitch +
@@ -338,6 +373,11 @@ draw_image_in_score_repeat (image * img, Uint32 xcoord, Uint32 ycoord,
 void
 draw_electrical_shock (char *oscreen, Eclair * shock, Sint32 numof_iterations)
 {
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_invalidate ();
   switch (bytes_per_pixel)
     {
     case 1:
@@ -372,6 +412,11 @@ void
 draw_empty_rectangle (char *oscreen, Sint32 xcoord, Sint32 ycoord,
                       Sint32 color, Sint32 width, Sint32 height)
 {
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_invalidate ();
   switch (bytes_per_pixel)
     {
     case 1:
@@ -400,6 +445,11 @@ draw_empty_rectangle (char *oscreen, Sint32 xcoord, Sint32 ycoord,
 void
 draw_bitmap_char (unsigned char *dest, unsigned char *source)
 {
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_invalidate ();
   switch (bytes_per_pixel)
     {
     case 1:
@@ -431,6 +481,10 @@ draw_bitmap_char (unsigned char *dest, unsigned char *source)
 void
 copy2X_512x440 (char *source, char *dest, Uint32 height)
 {
+  if (render_disabled)
+    {
+      return;
+    }
   switch (bytes_per_pixel)
     {
     case 1:
@@ -461,6 +515,10 @@ void
 copy2X (char *source, char *dest, Uint32 width,
         Uint32 height, Uint32 _iOffset, Uint32 _iOffset2)
 {
+  if (render_disabled)
+    {
+      return;
+    }
   switch (bytes_per_pixel)
     {
     case 1:
@@ -27,6 +27,7 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "tools.h"
+#include "arena.h"
 #include "images.h"
 #include "curve_phase.h"
 #include "display.h"
@@ -134,30 +135,41 @@ grid_load (Sint32 num_grid)
   Sint16 *dest;
   Sint32 i;
   char *source;
+  Uint32 mark;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+  float speed;
+#endif
   meteors_images_free ();
   if (num_grid > MAX_NUM_OF_LEVELS || num_grid < 0)
     {
       num_grid = 0;
     }
 
-  /* load grid level file */
-  source = loadfile_num ("data/levels/grids_phase/grid_%02d.bin", num_grid);
+  /* load grid level file, only needed until the grid is read */
+  mark = arena_mark (&frame_arena);
+  source =
+    loadfile_num_into_arena (&frame_arena,
+                             "data/levels/grids_phase/grid_%02d.bin",
+                             num_grid);
   if (source == NULL)
     {
       return FALSE;
     }
 
   /* read grid speed of the displacement
-   * read little endian float */
+   * read little endian float, the file data can be read-only */
   ptr32 = (float *) source;
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-  convert32bits_2bigendian ((unsigned char *) ptr32);
-#endif
+  memcpy (&speed, ptr32++, sizeof (float));
+  convert32bits_2bigendian ((unsigned char *) &speed);
+  grid.vit_dep_x = speed;
+  memcpy (&speed, ptr32++, sizeof (float));
+  convert32bits_2bigendian ((unsigned char *) &speed);
+  grid.vit_dep_y = speed;
+#else
   grid.vit_dep_x = (float) *(ptr32++);
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-  convert32bits_2bigendian ((unsigned char *) ptr32);
-#endif
   grid.vit_dep_y = (float) *(ptr32++);
+#endif
   grid.speed_x = grid.vit_dep_x;
 
   ptr16 = (Sint16 *) ptr32;
@@ -173,7 +185,7 @@ grid_load (Sint32 num_grid)
     {
       *(dest++) = little_endian_to_short (ptr16++);
     }
-  free_memory (source);
+  arena_release (&frame_arena, mark);
   return TRUE;
 }
 
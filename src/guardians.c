@@ -29,6 +29,7 @@
 #include "mangadualist.h"
 #include "tools.h"
 #include "images.h"
+#include "assets_segment.h"
 #include "config_file.h"
 #include "congratulations.h"
 #include "curve_phase.h"
@@ -61,6 +62,26 @@ image gardi[GUARDIAN_MAX_OF_ANIMS][ENEMIES_SPECIAL_NUM_OF_IMAGES];
 const Sint32 clip_gard10 = 16;
 guardian_struct *guardian;
 
+/** States of the background loading of the next guardian */
+typedef enum
+{
+  PREFETCH_RUNNING,
+  PREFETCH_DONE,
+  PREFETCH_FAILED
+} PREFETCH_STATES;
+
+/** Images of the next guardian, swapped with 'gardi' at the phase change */
+static image
+  gardi_prefetched[GUARDIAN_MAX_OF_ANIMS][ENEMIES_SPECIAL_NUM_OF_IMAGES];
+/** Number of the guardian being prefetched, 0 if none */
+static Sint32 prefetch_num = 0;
+static SDL_Thread *prefetch_thread = NULL;
+/** PREFETCH_RUNNING, PREFETCH_DONE or PREFETCH_FAILED */
+static SDL_atomic_t prefetch_state;
+
+static bool guardian_images_load (Sint32 guardian_num, image * img);
+static void guardian_prefetch_cancel (void);
+
 /**
  * Initialization guardian that is only run once
  * @return TRUE if it completed successfully or FALSE otherwise
@@ -83,26 +104,25 @@ guardians_once_init (void)
 }
 
 /**
- * Release memory used by the current guardian
+ * Release memory used by the images of a guardian
+ * @param img Pointer to the first image of the guardian
  */
 static void
-guardian_images_free (void)
+guardian_images_free (image * img)
 {
-  Uint32 i, j;
-  for (i = 0; i < GUARDIAN_MAX_OF_ANIMS; i++)
+  Uint32 i;
+  for (i = 0; i < GUARDIAN_MAX_OF_ANIMS * ENEMIES_SPECIAL_NUM_OF_IMAGES;
+       i++, img++)
     {
-      for (j = 0; j < ENEMIES_SPECIAL_NUM_OF_IMAGES; j++)
+      if (img->img != NULL)
         {
-          if (gardi[i][j].img != NULL)
-            {
-              free_memory (gardi[i][j].img);
-              gardi[i][j].img = NULL;
-            }
-          if (gardi[i][j].compress != NULL)
-            {
-              free_memory (gardi[i][j].compress);
-              gardi[i][j].compress = NULL;
-            }
+          assets_free (img->img);
+          img->img = NULL;
+        }
+      if (img->compress != NULL)
+        {
+          assets_free (img->compress);
+          img->compress = NULL;
         }
     }
 }
@@ -113,7 +133,8 @@ guardian_images_free (void)
 void
 guardians_free (void)
 {
-  guardian_images_free ();
+  guardian_prefetch_cancel ();
+  guardian_images_free (&gardi[0][0]);
   if (guardian != NULL)
     {
       free_memory ((char *) guardian);
@@ -2761,17 +2782,15 @@ guardian_handle (enemy * guard)
 }
 
 /**
- * Loading guardian's sprites images in memory 
+ * Load and convert the sprites images of a guardian
  * @param guardian_num number of the guardian 1 to 14
+ * @param img Pointer to the first image which receives the guardian
  * @return TRUE if successful
  */
-bool
-guardian_load (Sint32 guardian_num)
+static bool
+guardian_images_load (Sint32 guardian_num, image * img)
 {
   Uint32 num_of_sprites;
-  LOG_INF ("Load guardian %i", guardian_num);
-  guardian_images_free ();
-
   switch (guardian_num)
     {
     case 2:
@@ -2789,12 +2808,111 @@ guardian_load (Sint32 guardian_num)
       num_of_sprites = 1;
       break;
     }
-  if (!image_load_num
-      ("graphics/sprites/guardians/guardian_%02d.spr",
-       guardian_num - 1, &gardi[0][0], num_of_sprites,
-       ENEMIES_SPECIAL_NUM_OF_IMAGES))
+  return image_load_num
+    ("graphics/sprites/guardians/guardian_%02d.spr",
+     guardian_num - 1, img, num_of_sprites, ENEMIES_SPECIAL_NUM_OF_IMAGES);
+}
+
+/**
+ * Thread which loads the next guardian in the background
+ * @param unused Not used
+ * @return Always 0
+ */
+static int
+guardian_prefetch_run (void *unused)
+{
+  bool is_loaded;
+  (void) unused;
+  is_loaded = guardian_images_load (prefetch_num, &gardi_prefetched[0][0]);
+  SDL_AtomicSet (&prefetch_state, is_loaded ? PREFETCH_DONE : PREFETCH_FAILED);
+  return 0;
+}
+
+/**
+ * Wait for the prefetch thread and release the images it loaded
+ */
+static void
+guardian_prefetch_cancel (void)
+{
+  if (prefetch_thread != NULL)
     {
-      return FALSE;
+      SDL_WaitThread (prefetch_thread, NULL);
+      prefetch_thread = NULL;
+    }
+  guardian_images_free (&gardi_prefetched[0][0]);
+  prefetch_num = 0;
+}
+
+/**
+ * Start to load the sprites images of a guardian in the background,
+ * as soon as the level number is known. They are swapped in by
+ * guardian_load() when the guardian appears
+ * @param guardian_num number of the guardian 1 to 14
+ */
+void
+guardian_prefetch (Sint32 guardian_num)
+{
+  if (prefetch_num == guardian_num)
+    {
+      return;
+    }
+  guardian_prefetch_cancel ();
+  LOG_INF ("Prefetch guardian %i", guardian_num);
+  prefetch_num = guardian_num;
+  SDL_AtomicSet (&prefetch_state, PREFETCH_RUNNING);
+  prefetch_thread =
+    SDL_CreateThread (guardian_prefetch_run, "guardian", NULL);
+  if (prefetch_thread == NULL)
+    {
+      /* guardian_load() will load it synchronously */
+      LOG_WARN ("SDL_CreateThread() failed: %s", SDL_GetError ());
+      prefetch_num = 0;
+    }
+}
+
+/**
+ * Loading guardian's sprites images in memory, the images prefetched
+ * in the background are swapped in if they are for this guardian
+ * @param guardian_num number of the guardian 1 to 14
+ * @return TRUE if successful
+ */
+bool
+guardian_load (Sint32 guardian_num)
+{
+  bool is_prefetched = FALSE;
+  if (prefetch_num == guardian_num)
+    {
+      if (SDL_AtomicGet (&prefetch_state) == PREFETCH_RUNNING)
+        {
+          LOG_WARN ("guardian %i is not prefetched yet", guardian_num);
+        }
+      /* the remaining work is shorter than a synchronous load */
+      SDL_WaitThread (prefetch_thread, NULL);
+      prefetch_thread = NULL;
+      is_prefetched = SDL_AtomicGet (&prefetch_state) == PREFETCH_DONE;
+    }
+  if (is_prefetched)
+    {
+      LOG_INF ("Swap prefetched guardian %i", guardian_num);
+      guardian_images_free (&gardi[0][0]);
+      memcpy (gardi, gardi_prefetched, sizeof (gardi));
+      memset (gardi_prefetched, 0, sizeof (gardi_prefetched));
+      prefetch_num = 0;
+    }
+  else
+    {
+      guardian_prefetch_cancel ();
+      LOG_INF ("Load guardian %i", guardian_num);
+      guardian_images_free (&gardi[0][0]);
+      if (!guardian_images_load (guardian_num, &gardi[0][0]))
+        {
+          return FALSE;
+        }
+    }
+  /* the last three guardians follow each other on the last level */
+  if (guardian_num >= 11 && guardian_num < GUARDIAN_MAX_OF_TYPES)
+    {
+      guardian_prefetch (guardian_num + 1);
     }
   return TRUE;
 }
@@ -2822,7 +2940,8 @@ guardians_extract (void)
       return FALSE;
     }
 
-  for (guardian_num = 1; guardian_num <= 14; guardian_num++)
+  for (guardian_num = 1; guardian_num <= GUARDIAN_MAX_OF_TYPES;
+       guardian_num++)
     {
       if (!guardian_load (guardian_num))
         {
@@ -2937,7 +3056,7 @@ guardian_finished (void)
               num_level = 0;
             }
 
-          /* load guardian files in advance */
+          /* load guardian files in advance, in the background */
           switch (num_level)
             {
             case 4:
@@ -2973,10 +3092,7 @@ guardian_finished (void)
             }
           if (guard_num > 0)
             {
-              if (!guardian_load (guard_num))
-                {
-                  return FALSE;
-                }
+              guardian_prefetch (guard_num);
             }
 
           /* load grid level */
@@ -37,6 +37,8 @@ extern "C"
 #define GUARDIAN_MAX_OF_ANIMS 5
 /** Maximum number of sprites which compose a guardian */
 #define GUARDIAN_MAX_ELEMENTS 2
+/** Number of different guardians */
+#define GUARDIAN_MAX_OF_TYPES 14
 
   typedef enum
   {
@@ -109,6 +111,7 @@ extern "C"
   void guardians_free (void);
   void guardian_handle (enemy * guard);
   bool guardian_new (Uint32 guard_num);
+  void guardian_prefetch (Sint32 guardian_num);
   bool guardian_load (Sint32 guardian_num);
 #ifdef PNG_EXPORT_ENABLE
   bool guardians_extract (void);
@@ -30,7 +30,9 @@
 #include "tools.h"
 #include "display.h"
 #include "images.h"
+#include "assets_segment.h"
 #include "log_recorder.h"
+#include "render_list.h"
 #ifdef PNG_EXPORT_ENABLE
 #include <zlib.h>
 #include <png.h>
@@ -44,6 +46,10 @@ static char *bitmap_extract (bitmap * bmp, char *filedata);
 static char *read_pixels (Uint32 numofpixels, char *source,
                           char *destination);
 static char *read_compress (Uint32 filesize, char *filedata, char *compress);
+static char *extract_pixels (Uint32 numofpixels, char *source,
+                             char **destination);
+static char *extract_compress (Uint32 filesize, char *source,
+                               char **destination);
 
 /** 
  * Load and extract a file *.spr into 'image' structure
@@ -67,10 +73,10 @@ image_load (const char *fname, image * img, Uint32 num_of_sprites,
   data = images_read (img, num_of_sprites, num_of_anims, data, num_of_anims);
   if (data == NULL)
     {
-      free_memory (file);
+      free_file (file);
       return FALSE;
     }
-  free_memory (file);
+  free_file (file);
   return TRUE;
 }
 
@@ -94,7 +100,7 @@ image_load_num (const char *fname, Sint32 num, image * img,
       return FALSE;
     }
   data = images_read (img, num_of_sprites, num_of_anims, file, num_of_anims);
-  free_memory (file);
+  free_file (file);
   if (data == NULL)
     {
       return FALSE;
@@ -118,10 +124,10 @@ bitmap_load (const char *fname, bitmap * fonte, Uint32 num_of_obj,
   addr = bitmap_read (fonte, num_of_obj, num_of_images, file, num_of_images);
   if (addr == NULL)
     {
-      free_memory (file);
+      free_file (file);
       return FALSE;
     }
-  free_memory (file);
+  free_file (file);
   return TRUE;
 }
 
@@ -167,6 +173,8 @@ images_free (image * first_image, Uint32 num_of_sprites, Uint32 num_of_anims,
 {
   Uint32 i, j;
   image *img;
+  /* the current tick may have drawn these images */
+  render_list_invalidate ();
   for (i = 0; i < num_of_sprites; i++)
     {
       for (j = 0; j < num_of_anims; j++)
@@ -174,12 +182,12 @@ images_free (image * first_image, Uint32 num_of_sprites, Uint32 num_of_anims,
           img = first_image + (i * max_of_anims) + j;
           if (img->img != NULL)
             {
-              free_memory (img->img);
+              assets_free (img->img);
               img->img = NULL;
             }
           if (img->compress != NULL)
             {
-              free_memory (img->compress);
+              assets_free (img->compress);
               img->compress = NULL;
             }
         }
@@ -224,6 +232,8 @@ bitmap_free (bitmap * first_bitmap, Uint32 num_of_bitmap, Uint32 num_of_anims,
 {
   Uint32 i, j;
   bitmap *bmp;
+  /* the current tick may have drawn these bitmaps */
+  render_list_invalidate ();
   for (i = 0; i < num_of_bitmap; i++)
     {
       for (j = 0; j < num_of_anims; j++)
@@ -231,18 +241,40 @@ bitmap_free (bitmap * first_bitmap, Uint32 num_of_bitmap, Uint32 num_of_anims,
           bmp = first_bitmap + (i * max_of_anims) + j;
           if (bmp->img != NULL)
             {
-              free_memory (bmp->img);
+              assets_free (bmp->img);
               bmp->img = NULL;
             }
           if (bmp->compress != NULL)
             {
-              free_memory (bmp->compress);
+              assets_free (bmp->compress);
               bmp->compress = NULL;
             }
         }
     }
 }
 
+/**
+ * Fold the gameplay values of a sprite into a hash, the pointers
+ * to the images are ignored, their addresses change from one run to another
+ * @param hash Current hash value
+ * @param spr Pointer to a sprite structure
+ * @return The updated hash value
+ */
+Uint32
+sprite_hash (Uint32 hash, const sprite * spr)
+{
+  hash = hash_fnv1a (hash, &spr->type, sizeof (spr->type));
+  hash = hash_fnv1a (hash, &spr->trajectory, sizeof (spr->trajectory));
+  hash = hash_fnv1a (hash, &spr->pow_of_dest, sizeof (spr->pow_of_dest));
+  hash = hash_fnv1a (hash, &spr->energy_level, sizeof (spr->energy_level));
+  hash = hash_fnv1a (hash, &spr->current_image, sizeof (spr->current_image));
+  hash = hash_fnv1a (hash, &spr->anim_count, sizeof (spr->anim_count));
+  hash = hash_fnv1a (hash, &spr->xcoord, sizeof (spr->xcoord));
+  hash = hash_fnv1a (hash, &spr->ycoord, sizeof (spr->ycoord));
+  hash = hash_fnv1a (hash, &spr->speed, sizeof (spr->speed));
+  return hash;
+}
+
 /**
  * Load a sprite file (*.spr) with a single image
  * @param filename Filename the file *.spr which should be loaded 
@@ -262,10 +294,10 @@ image_load_single (const char *filename, image * img)
   if (addr == NULL)
     {
       LOG_ERR ("image_extract() failed!");
-      free_memory (filedata);
+      free_file (filedata);
       return FALSE;
     }
-  free_memory (filedata);
+  free_file (filedata);
   return TRUE;
 }
 
@@ -350,14 +382,13 @@ image_extract (image * img, const char *file)
   ptr32 = (Sint32 *) (ptr16);
   /* number of pixels */
   img->numof_pixels = little_endian_to_int (ptr32++);
-  img->img = memory_allocation (img->numof_pixels * bytes_per_pixel);
-  if (img->img == NULL)
+  /* 8-bit access */
+  ptr8 = (char *) ptr32;
+  ptr8 = extract_pixels (img->numof_pixels, ptr8, &img->img);
+  if (ptr8 == NULL)
     {
       return NULL;
     }
-  /* 8-bit access */
-  ptr8 = (char *) ptr32;
-  ptr8 = read_pixels (img->numof_pixels, ptr8, img->img);
 
   /* 
    * read offsets and repeat values 
@@ -366,14 +397,9 @@ image_extract (image * img, const char *file)
   ptr32 = (Sint32 *) (ptr8);
   /* size of the table in bytes */
   img->nbr_data_comp = little_endian_to_int (ptr32++);
-  img->compress = memory_allocation (img->nbr_data_comp * 2);
-  if (img->compress == NULL)
-    {
-      return NULL;
-    }
   /* 8-bit access */
   ptr8 = (char *) ptr32;
-  ptr8 = read_compress (img->nbr_data_comp, ptr8, img->compress);
+  ptr8 = extract_compress (img->nbr_data_comp, ptr8, &img->compress);
   return ptr8;
 }
 
@@ -397,14 +423,13 @@ bitmap_extract (bitmap * bmp, char *filedata)
   ptr32 = (Sint32 *) (ptr8);
   /* number of pixels */
   bmp->numof_pixels = little_endian_to_int (ptr32++);
-  bmp->img = memory_allocation (bmp->numof_pixels * bytes_per_pixel);
-  if (bmp->img == NULL)
+  /* 8-bit access */
+  ptr8 = (char *) ptr32;
+  ptr8 = extract_pixels (bmp->numof_pixels, ptr8, &bmp->img);
+  if (ptr8 == NULL)
     {
       return NULL;
     }
-  /* 8-bit access */
-  ptr8 = (char *) ptr32;
-  ptr8 = read_pixels (bmp->numof_pixels, ptr8, bmp->img);
 
   /* 
    * read offsets and repeat values 
@@ -413,17 +438,68 @@ bitmap_extract (bitmap * bmp, char *filedata)
   ptr32 = (Sint32 *) (ptr8);
   /* size of the table in bytes */
   bmp->nbr_data_comp = little_endian_to_int (ptr32++);
-  bmp->compress = memory_allocation (bmp->nbr_data_comp * 2);
-  if (bmp->compress == NULL)
-    {
-      return NULL;
-    }
   /* 8-bit access */
   ptr8 = (char *) ptr32;
-  ptr8 = read_compress (bmp->nbr_data_comp, ptr8, bmp->compress);
+  ptr8 = extract_compress (bmp->nbr_data_comp, ptr8, &bmp->compress);
   return ptr8;
 }
 
+/**
+ * Get the pixels of a sprite converted to the screen depth, from the
+ * shared segment if they are there, otherwise allocate and convert them
+ * @param numofpixels Number of 8-bit pixels
+ * @param source 8-bit data from the file
+ * @param destination Receives the pointer to the converted pixels
+ * @return The source pointer incremented, NULL if out of memory
+ */
+static char *
+extract_pixels (Uint32 numofpixels, char *source, char **destination)
+{
+  Uint32 size = numofpixels * bytes_per_pixel;
+  *destination =
+    assets_segment_find (ASSETS_PIXELS, source, size);
+  if (*destination != NULL)
+    {
+      return source + numofpixels;
+    }
+  *destination = memory_allocation (size);
+  if (*destination == NULL)
+    {
+      return NULL;
+    }
+  read_pixels (numofpixels, source, *destination);
+  assets_segment_add (ASSETS_PIXELS, source, *destination, size);
+  return source + numofpixels;
+}
+
+/**
+ * Get the offsets and repeat values table of a sprite, from the
+ * shared segment if it is there, otherwise allocate and convert it
+ * @param filesize Size of the source table in bytes
+ * @param source Source table from the file
+ * @param destination Receives the pointer to the converted table
+ * @return The source pointer incremented, NULL if out of memory
+ */
+static char *
+extract_compress (Uint32 filesize, char *source, char **destination)
+{
+  Uint32 size = filesize * 2;
+  *destination =
+    assets_segment_find (ASSETS_COMPRESS, source, size);
+  if (*destination != NULL)
+    {
+      return source + filesize;
+    }
+  *destination = memory_allocation (size);
+  if (*destination == NULL)
+    {
+      return NULL;
+    }
+  read_compress (filesize, source, *destination);
+  assets_segment_add (ASSETS_COMPRESS, source, *destination, size);
+  return source + filesize;
+}
+
 /**
  * Read 8-bit pixels from the data file,
  *   and copy or convert to 16/24/32-bit
@@ -152,6 +152,7 @@ extern "C"
                     Uint32 num_of_anims, Uint32 max_of_anims);
   void bitmap_free (bitmap * first_bitmap, Uint32 num_of_bitmap,
                     Uint32 num_of_anims, Uint32 max_of_anims);
+  Uint32 sprite_hash (Uint32 hash, const sprite * spr);
 #ifdef PNG_EXPORT_ENABLE
   bool image_to_png (image * img, const char *filename);
   bool bitmap_to_png (bitmap * bmp, const char *filename, Uint32 width,
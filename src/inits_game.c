@@ -28,6 +28,9 @@
 #include "mangadualist.h"
 #include "tools.h"
 #include "images.h"
+#include "assets_segment.h"
+#include "archive.h"
+#include "arena.h"
 #include "config_file.h"
 #include "curve_phase.h"
 #include "display.h"
@@ -45,7 +48,9 @@
 #include "menu.h"
 #include "menu_sections.h"
 #include "movie.h"
+#include "movie_recorder.h"
 #include "options_panel.h"
+#include "profiler.h"
 #include "satellite_protections.h"
 #include "scrolltext.h"
 #include "sdl_mixer.h"
@@ -53,6 +58,7 @@
 #include "spaceship.h"
 #include "sprites_string.h"
 #include "starfield.h"
+#include "task_graph.h"
 #include "text_overlay.h"
 #include "texts.h"
 
@@ -64,6 +70,81 @@
 /* logo TLK Games */
 extern bitmap logotlk[TLKLOGO_MAXOF_IMAGES];
 
+static bool sound_init (void);
+static bool tlk_logo_load (void);
+static bool colors_init (void);
+static bool options_panel_load (void);
+static bool scores_panel_load (void);
+
+/** Initialization tasks, in an order compatible with their dependencies */
+typedef enum
+{
+  INIT_SOUND,
+  INIT_MENU_SECTIONS,
+  INIT_TEXT_OVERLAY,
+  INIT_SPRITES_STRING,
+  INIT_TEXTS,
+  INIT_TLK_LOGO,
+  INIT_GUARDIANS,
+  INIT_METEORS,
+  INIT_STARFIELD,
+  INIT_SCROLLTEXT,
+  INIT_BONUS,
+  INIT_SHOTS,
+  INIT_ENEMIES,
+  INIT_OPTIONS,
+  INIT_EXPLOSIONS,
+  INIT_GUNS,
+  INIT_ENERGY_GAUGE,
+  INIT_SPACESHIP,
+  INIT_CURVES,
+  INIT_COLORS,
+  INIT_ELECTRICAL_SHOCK,
+  INIT_SHOCKWAVE,
+  INIT_SATELLITES,
+  INIT_MENU,
+  INIT_OPTIONS_PANEL,
+  INIT_SCORES_PANEL,
+  INIT_MAX_OF_TASKS
+} INIT_TASKS;
+
+/**
+ * The tasks are run once the display is initialized, the sprites are
+ * converted to the screen depth and palette in parallel. The tasks
+ * which share data are chained by their dependencies
+ */
+static const task_desc init_tasks[INIT_MAX_OF_TASKS] = {
+  {"sound", sound_init, 0},
+  {"menu sections", menu_sections_once_init, 0},
+  {"text overlay", text_overlay_once_init, 0},
+  {"sprites string", sprites_string_once_init, 0},
+  /* the texts are made of sprites strings */
+  {"texts", texts_init_once, TASK_AFTER (INIT_SPRITES_STRING)},
+  {"TLK logo", tlk_logo_load, 0},
+  {"guardians", guardians_once_init, 0},
+  /* guardians_once_init() releases the meteors */
+  {"meteors", meteors_once_init, TASK_AFTER (INIT_GUARDIANS)},
+  {"starfield", starfield_once_init, 0},
+  {"scrolltext", scrolltext_once_init, 0},
+  {"bonus", bonus_once_init, 0},
+  {"shots", shots_once_init, 0},
+  {"enemies", enemies_once_init, 0},
+  {"options", options_once_init, 0},
+  {"explosions", explosions_once_init, 0},
+  {"guns", guns_once_init, 0},
+  {"energy gauge", energy_gauge_once_init, 0},
+  /* the guns and the spaceship initialize the same structure */
+  {"spaceship", spaceship_once_init, TASK_AFTER (INIT_GUNS)},
+  {"curves", curve_once_init, 0},
+  {"colors", colors_init, 0},
+  {"electrical shock", electrical_shock_once_init, 0},
+  {"shockwave", shockwave_once_init, 0},
+  {"satellites", satellites_once_init, TASK_AFTER (INIT_SPACESHIP)},
+  {"menu", menu_once_init, 0},
+  {"options panel", options_panel_load, 0},
+  {"scores panel", scores_panel_load, 0}
+};
+
 /**
  * Initialization code that is only run once
  * @return TRUE if successful
@@ -71,145 +152,142 @@ extern bitmap logotlk[TLKLOGO_MAXOF_IMAGES];
 bool
 inits_game (void)
 {
-  if (!menu_sections_once_init ())
-    {
-      return FALSE;
-    }
-#ifdef USE_SDLMIXER
-  if (!sound_once_init ())
+  Sint32 i;
+  /* all the data files are then read from the mapping */
+  if (power_conf->archive != NULL && !archive_open (power_conf->archive))
     {
       return FALSE;
     }
-#endif
   /* initialize SDL or X11 display */
   if (!display_initialize ())
     {
       return FALSE;
     }
-  if (!text_overlay_once_init ())
-    {
-      return FALSE;
-    }
-  if (!sprites_string_once_init ())
-    {
-      return FALSE;
-    }
-  if (!texts_init_once ())
-    {
-      return FALSE;
-    }
-  /* allocate and precalculate sinus and cosinus curves */
-  if (!alloc_precalulate_sinus ())
-    {
-      return FALSE;
-    }
-  /* load TLK logo 92 949 bytes */
-  if (!bitmap_load
-      ("graphics/bitmap/tlk_games_logo.spr", &logotlk[0], 1,
-       TLKLOGO_MAXOF_IMAGES))
-    {
-      return FALSE;
-    }
-  if (!guardians_once_init ())
-    {
-      return FALSE;
-    }
-  if (!meteors_once_init ())
-    {
-      return FALSE;
-    }
-  if (!starfield_once_init ())
-    {
-      return FALSE;
-    }
-  /* allocate and clear fontes list and elements */
-  if (!scrolltext_once_init ())
-    {
-      return FALSE;
-    }
-  /* initialize bonus data structure */
-  if (!bonus_once_init ())
-    {
-      return FALSE;
-    }
-  /* initialize shots data structure */
-  if (!shots_once_init ())
-    {
-      return FALSE;
-    }
-  /* allocate buffers and initialize structure of the enemies vessels */
-  if (!enemies_once_init ())
-    {
-      return FALSE;
-    }
-  if (!options_once_init ())
-    {
-      return FALSE;
-    }
-  /* initialize explosions */
-  if (!explosions_once_init ())
-    {
-      return FALSE;
-    }
-  /* initialize extra guns */
-  if (!guns_once_init ())
+  if (power_conf->record_movie != NULL
+      && !display_record_start (power_conf->record_movie))
     {
       return FALSE;
     }
-  if (!energy_gauge_once_init ())
+  /* the converted images depend on the screen depth and palette */
+  if (power_conf->assets_segment != NULL)
     {
-      return FALSE;
-    }
-  /* initialize spaceship's structure */
-  if (!spaceship_once_init ())
-    {
-      return FALSE;
-    }
-  /* laod all bezier curves */
-  if (!curve_once_init ())
-    {
-      return FALSE;
+      if (!assets_segment_open
+          (power_conf->assets_segment, power_conf->rebuild_cache))
+        {
+          return FALSE;
+        }
     }
-  /* initialize some predefined colors */
-  display_colors_init ();
-  if (!electrical_shock_once_init ())
+  else if (!power_conf->nocache)
     {
-      return FALSE;
+      /* the game runs without cache if it can't be opened */
+      assets_segment_open_cache (power_conf->rebuild_cache);
     }
-  if (!shockwave_once_init ())
+  /* the level files are read there by the game thread */
+  if (!arena_create (&frame_arena, "frame", FRAME_ARENA_SIZE))
     {
       return FALSE;
     }
-  if (!satellites_once_init ())
+#if defined (USE_PROFILER)
+  if (!profiler_initialize ())
     {
       return FALSE;
     }
-  /* main menu enable */
-  if (!menu_once_init ())
+#endif
+  /* allocate and precalculate sinus and cosinus curves */
+  if (!alloc_precalulate_sinus ())
     {
       return FALSE;
     }
+  /* the SDL surfaces are created by the main thread */
   if (!create_offscreens ())
     {
       return FALSE;
     }
-  /* load right options panel  */
-  if (!
-      (load_pcx_into_buffer
-       ("graphics/right_options_panel.pcx", options_offscreen)))
+  if (!task_graph_run (init_tasks, INIT_MAX_OF_TASKS, SDL_GetCPUCount ()))
     {
       return FALSE;
     }
-  /* load top scores panel */
-  if (!
-      (load_pcx_into_buffer
-       ("graphics/top_scores_panel.pcx", scores_offscreen)))
+  if (assets_segment_is_building ())
     {
-      return FALSE;
+      /* guardians and meteors are loaded on demand, convert all
+       * of them once to put them in the shared segment */
+      for (i = 1; i <= GUARDIAN_MAX_OF_TYPES; i++)
+        {
+          if (!guardian_load (i))
+            {
+              return FALSE;
+            }
+        }
+      for (i = 0; i <= MAX_NUM_OF_LEVELS; i++)
+        {
+          if (!meteors_load (i))
+            {
+              return FALSE;
+            }
+        }
     }
+  return assets_segment_seal ();
+}
+
+/**
+ * Initialize the sounds and the musics
+ * @return TRUE if successful
+ */
+static bool
+sound_init (void)
+{
+#ifdef USE_SDLMIXER
+  return sound_once_init ();
+#else
+  return TRUE;
+#endif
+}
+
+/**
+ * Load TLK logo 92 949 bytes
+ * @return TRUE if successful
+ */
+static bool
+tlk_logo_load (void)
+{
+  return bitmap_load
+    ("graphics/bitmap/tlk_games_logo.spr", &logotlk[0], 1,
+     TLKLOGO_MAXOF_IMAGES);
+}
+
+/**
+ * Initialize some predefined colors
+ * @return Always TRUE
+ */
+static bool
+colors_init (void)
+{
+  display_colors_init ();
   return TRUE;
 }
 
+/**
+ * Load right options panel
+ * @return TRUE if successful
+ */
+static bool
+options_panel_load (void)
+{
+  return load_pcx_into_buffer
+    ("graphics/right_options_panel.pcx", options_offscreen);
+}
+
+/**
+ * Load top scores panel
+ * @return TRUE if successful
+ */
+static bool
+scores_panel_load (void)
+{
+  return load_pcx_into_buffer
+    ("graphics/top_scores_panel.pcx", scores_offscreen);
+}
+
 /**
  * Convert TLK Games logo from data bitmaps to PNG file
  * @return TRUE if successful
@@ -254,6 +332,8 @@ void
 release_game (void)
 {
   bitmap_free (&logotlk[0], 1, TLKLOGO_MAXOF_IMAGES, TLKLOGO_MAXOF_IMAGES);
+  /* the recorder reads the palette of the display */
+  movie_recorder_close ();
   /* free video ressources (xorg-x11 or SDL) */
   display_release ();
 #ifdef USE_SDLMIXER
@@ -281,6 +361,12 @@ release_game (void)
   sprites_string_free ();
   movie_free ();
   free_precalulate_sinus ();
+  arena_destroy (&frame_arena);
+#if defined (USE_PROFILER)
+  profiler_release ();
+#endif
+  assets_segment_close ();
+  archive_close ();
   configfile_save ();
   configfile_free ();
 }
@@ -29,14 +29,82 @@
 #include "tools.h"
 #include "log_recorder.h"
 #include <time.h>
+#include <signal.h>
+#include <stddef.h>
 
 #if defined(MANGADUALIST_LOG_ENABLED)
 #if defined(UNDER_DEVELOPMENT)
 #define ENABLE_LOG_FILE
 #endif
 
-const Uint32 LOG_MESSAGE_SIZE = 1536;
-const Uint32 LOG_OUTPUT_SIZE = 2048;
+#define LOG_MESSAGE_SIZE 1536
+#define LOG_OUTPUT_SIZE 2048
+/** Number of messages the ring holds, a power of 2 */
+#define LOG_RING_SIZE 512
+/** Maximum number of arguments kept for a message */
+#define LOG_MAX_ARGS 12
+/** Size of the copies of the strings given as arguments */
+#define LOG_STRINGS_SIZE 384
+
+/** Types of the arguments kept for a message */
+typedef enum
+{
+  LOG_ARG_SIGNED,
+  LOG_ARG_UNSIGNED,
+  LOG_ARG_CHAR,
+  LOG_ARG_REAL,
+  LOG_ARG_POINTER,
+  LOG_ARG_STRING,
+  LOG_ARG_NONE
+} LOG_ARG_TYPES;
+
+/** Conversion specification of a format string */
+typedef struct log_spec
+{
+  /** First char after the flags, the width and the precision */
+  const char *length;
+  /** First char after the specification */
+  const char *end;
+  /** Length modifier: 'H' for hh, 'h', 'l', 'q' for ll, 'j',
+   * 'z', 't', 'L' or 0 */
+  char modifier;
+  /** Conversion specifier */
+  char conversion;
+  /** Number of '*' in the width and the precision */
+  Uint32 numof_stars;
+  /** Precision given by digits, -1 if none or a '*' */
+  Sint32 precision;
+} log_spec;
+
+/** Argument kept for a message */
+typedef union log_arg
+{
+  long long integer;
+  double real;
+  const void *pointer;
+  /** Offset of the copy of a string */
+  Uint32 string;
+} log_arg;
+
+/** Message waiting in the ring to be formatted and written */
+typedef struct log_record
+{
+  /** Position of the record in the ring, plus one once it is ready */
+  SDL_atomic_t sequence;
+  LOG_LEVELS level;
+  Sint32 line_num;
+  const char *filename;
+  const char *function;
+  const char *format;
+#if defined(ENABLE_LOG_FILE)
+  time_t time;
+#endif
+  Uint32 numof_args;
+  log_arg args[LOG_MAX_ARGS];
+  Uint32 strings_size;
+  char strings[LOG_STRINGS_SIZE];
+} log_record;
+
 #if defined(ENABLE_LOG_FILE)
 static FILE *log_fstream = NULL;
 #endif
@@ -44,8 +112,28 @@ static char *buffer_message = NULL;
 static char *output_message = NULL;
 static LOG_LEVELS verbose_level = LOG_NOTHING;
 
-static struct tm *cur_time = NULL;
-
+/** Serializes the messages written before the thread starts */
+static SDL_mutex *log_mutex = NULL;
+/** The messages of all the threads, written by the log thread. The
+ * producers reserve a record with a compare-and-swap on the head */
+static log_record *log_ring = NULL;
+/** Number of records reserved by the producers */
+static SDL_atomic_t ring_head;
+/** Number of records written by the consumer, the one which holds
+ * log_consuming */
+static Uint32 ring_tail = 0;
+/** 1 while the ring is being emptied by a thread */
+static SDL_atomic_t log_consuming;
+/** Number of messages dropped because the ring was full */
+static SDL_atomic_t log_dropped;
+static Uint32 log_dropped_reported = 0;
+/** 1 once the log thread must stop */
+static SDL_atomic_t log_stop;
+/** Posted for each message, and once to stop the thread */
+static SDL_sem *log_posted = NULL;
+static SDL_Thread *log_thread = NULL;
+/** The call sites of LOG_ERR and LOG_WARN which wrote a message */
+static log_site *log_sites = NULL;
 
 static const char *log_levels[LOG_NUMOF] = {
   "(--)",
@@ -55,6 +143,15 @@ static const char *log_levels[LOG_NUMOF] = {
   "(DD)"
 };
 
+/** The signals of a crash, the pending messages are written first */
+static const int crash_signals[] = {
+  SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT
+};
+
+static Sint32 log_thread_run (void *unused);
+static void log_crash (int signum);
+static void log_sites_report (void);
+
 /**
  * Change level of debug
  * @param verbose Level of debug
@@ -77,19 +174,19 @@ log_set_level (LOG_LEVELS verbose)
 bool
 log_initialize (LOG_LEVELS verbose)
 {
+  Uint32 i;
 #if defined(ENABLE_LOG_FILE)
   const char *filename;
 #endif
   log_set_level (verbose);
 
-  if (cur_time == NULL)
+  if (log_mutex == NULL)
     {
-      cur_time = (struct tm *) memory_allocation (sizeof (struct tm));
-      if (cur_time == NULL)
+      log_mutex = SDL_CreateMutex ();
+      if (log_mutex == NULL)
         {
           fprintf (stderr, "log_recorder.c/log_initialize()"
-                   "not enough memory to allocate %i bytes\n",
-                   LOG_MESSAGE_SIZE);
+                   "SDL_CreateMutex() failed (%s)\n", SDL_GetError ());
           return FALSE;
         }
     }
@@ -127,7 +224,56 @@ log_initialize (LOG_LEVELS verbose)
                "fopen(%s) failed (%s)\n", filename, strerror (errno));
       return FALSE;
     }
- #endif
+#endif
+
+  if (log_ring == NULL)
+    {
+      log_ring =
+        (log_record *) memory_allocation (LOG_RING_SIZE *
+                                          sizeof (log_record));
+      if (log_ring == NULL)
+        {
+          fprintf (stderr, "log_recorder.c/log_initialize()"
+                   "not enough memory to allocate %i bytes\n",
+                   (Uint32) (LOG_RING_SIZE * sizeof (log_record)));
+          return FALSE;
+        }
+      for (i = 0; i < LOG_RING_SIZE; i++)
+        {
+          SDL_AtomicSet (&log_ring[i].sequence, i);
+        }
+      SDL_AtomicSet (&ring_head, 0);
+      ring_tail = 0;
+      SDL_AtomicSet (&log_consuming, 0);
+      SDL_AtomicSet (&log_dropped, 0);
+      log_dropped_reported = 0;
+    }
+  if (log_posted == NULL)
+    {
+      log_posted = SDL_CreateSemaphore (0);
+      if (log_posted == NULL)
+        {
+          fprintf (stderr, "log_recorder.c/log_initialize()"
+                   "SDL_CreateSemaphore() failed (%s)\n", SDL_GetError ());
+          return FALSE;
+        }
+    }
+  if (log_thread == NULL)
+    {
+      SDL_AtomicSet (&log_stop, 0);
+      log_thread = SDL_CreateThread (log_thread_run, "log", NULL);
+      if (log_thread == NULL)
+        {
+          fprintf (stderr, "log_recorder.c/log_initialize()"
+                   "SDL_CreateThread() failed (%s)\n", SDL_GetError ());
+          return FALSE;
+        }
+      for (i = 0; i < sizeof (crash_signals) / sizeof (crash_signals[0]);
+           i++)
+        {
+          signal (crash_signals[i], log_crash);
+        }
+    }
   return TRUE;
 }
 
@@ -137,6 +283,30 @@ log_initialize (LOG_LEVELS verbose)
 void
 log_close (void)
 {
+  Uint32 i;
+  log_sites_report ();
+  if (log_thread != NULL)
+    {
+      for (i = 0; i < sizeof (crash_signals) / sizeof (crash_signals[0]);
+           i++)
+        {
+          signal (crash_signals[i], SIG_DFL);
+        }
+      SDL_AtomicSet (&log_stop, 1);
+      SDL_SemPost (log_posted);
+      SDL_WaitThread (log_thread, NULL);
+      log_thread = NULL;
+    }
+  if (log_ring != NULL)
+    {
+      free_memory ((char *) log_ring);
+      log_ring = NULL;
+    }
+  if (log_posted != NULL)
+    {
+      SDL_DestroySemaphore (log_posted);
+      log_posted = NULL;
+    }
 #if defined(ENABLE_LOG_FILE)
   if (log_fstream != NULL)
     {
@@ -155,12 +325,11 @@ log_close (void)
       output_message = NULL;
     }
 
-  if (cur_time != NULL)
+  if (log_mutex != NULL)
     {
-      free_memory ((char *) cur_time);
-      cur_time = NULL;
+      SDL_DestroyMutex (log_mutex);
+      log_mutex = NULL;
     }
-
 }
 
 /**
@@ -169,21 +338,22 @@ log_close (void)
  * @param filename The filename in which this function is called
  * @param line_num The line number on which this function is called
  * @param function The function name in which this function is called
- * @param format The format string to be appended to the log
- * @param ... The arguments to use to fill out format 
+ * @param now Time of the message
+ * @param message The message
+ * @param output Buffer of LOG_OUTPUT_SIZE bytes
  */
 #if defined(ENABLE_LOG_FILE)
 static void
 log_write (LOG_LEVELS level, const char *filename, Sint32 line_num,
-           const char *function, const char *message)
+           const char *function, time_t now, const char *message,
+           char *output)
 {
   size_t msg_len;
-  time_t now;
+  struct tm date;
   if (log_fstream == NULL)
     {
       return;
     }
-  now = time (NULL);
   if (now == (time_t) - 1)
     {
       fprintf (stderr, "log_recorder.c/log_write()"
@@ -192,23 +362,26 @@ log_write (LOG_LEVELS level, const char *filename, Sint32 line_num,
     }
 
   /* Get the current time */
-  localtime_r (&now, cur_time);
-  if (cur_time == NULL)
+  if (localtime_r (&now, &date) == NULL)
     {
       fprintf (stderr, "log_recorder.c/log_write()"
                "localtime(_r)() failed.\n");
       return;
     }
-  msg_len = snprintf (output_message, LOG_OUTPUT_SIZE,
+  msg_len = snprintf (output, LOG_OUTPUT_SIZE,
                       "%04u-%02u-%02u %02u:%02u:%02u %s "
                       "[File: %s][Line: %d][Function: %s] %s\n",
-                      cur_time->tm_year + 1900,
-                      cur_time->tm_mon + 1,
-                      cur_time->tm_mday,
-                      cur_time->tm_hour, cur_time->tm_min, cur_time->tm_sec,
+                      date.tm_year + 1900,
+                      date.tm_mon + 1,
+                      date.tm_mday,
+                      date.tm_hour, date.tm_min, date.tm_sec,
                       log_levels[level], filename, line_num, function,
                       message);
-  if (fwrite (output_message, sizeof (char), msg_len, log_fstream) != msg_len)
+  if (msg_len >= LOG_OUTPUT_SIZE)
+    {
+      msg_len = LOG_OUTPUT_SIZE - 1;
+    }
+  if (fwrite (output, sizeof (char), msg_len, log_fstream) != msg_len)
     {
       fprintf (stderr, "log_recorder.c/log_write()" "fwrite() failed!\n");
     }
@@ -221,55 +394,591 @@ log_write (LOG_LEVELS level, const char *filename, Sint32 line_num,
  * @param filename The filename in which this function is called
  * @param line_num The line number on which this function is called
  * @param function The function name in which this function is called
- * @param format The format string to be appended to the log
- * @param ... The arguments to use to fill out format 
+ * @param message The message
+ * @param output Buffer of LOG_OUTPUT_SIZE bytes
  */
 static void
 log_put (LOG_LEVELS level, const char *filename, Sint32 line_num,
-         const char *function, const char *message)
+         const char *function, const char *message, char *output)
 {
-  snprintf (output_message, LOG_OUTPUT_SIZE, "%s %s [%s:%d, %s]\n",
+  snprintf (output, LOG_OUTPUT_SIZE, "%s %s [%s:%d, %s]\n",
             log_levels[level], message, filename, line_num, function);
   if (level == LOG_ERROR)
     {
-      fprintf (stderr, "%s", output_message);
+      fprintf (stderr, "%s", output);
     }
   else
     {
-      fprintf (stdout, "%s", output_message);
+      fprintf (stdout, "%s", output);
     }
 }
 
 /**
- * Log messages to the screen and/or a file.
+ * Parse a conversion specification of a format string
+ * @param format Pointer to the char after the '%'
+ * @param spec Pointer to the specification to fill
+ */
+static void
+log_parse_spec (const char *format, log_spec * spec)
+{
+  const char *ptr = format;
+  spec->numof_stars = 0;
+  spec->precision = -1;
+  ptr += strspn (ptr, "-+ #0'");
+  if (*ptr == '*')
+    {
+      spec->numof_stars++;
+      ptr++;
+    }
+  else
+    {
+      ptr += strspn (ptr, "0123456789");
+    }
+  if (*ptr == '.')
+    {
+      ptr++;
+      if (*ptr == '*')
+        {
+          spec->numof_stars++;
+          ptr++;
+        }
+      else
+        {
+          spec->precision = atoi (ptr);
+          ptr += strspn (ptr, "0123456789");
+        }
+    }
+  spec->length = ptr;
+  spec->modifier = 0;
+  switch (*ptr)
+    {
+    case 'h':
+    case 'l':
+      spec->modifier = *ptr++;
+      if (*ptr == spec->modifier)
+        {
+          spec->modifier = spec->modifier == 'h' ? 'H' : 'q';
+          ptr++;
+        }
+      break;
+    case 'j':
+    case 'z':
+    case 't':
+    case 'L':
+    case 'q':
+      spec->modifier = *ptr++;
+      break;
+    }
+  spec->conversion = *ptr;
+  spec->end = *ptr != '\0' ? ptr + 1 : ptr;
+}
+
+/**
+ * Return the type of the argument of a conversion
+ * @param conversion Conversion specifier
+ * @return Type of the argument or LOG_ARG_NONE if it's not supported
+ */
+static LOG_ARG_TYPES
+log_arg_type (char conversion)
+{
+  switch (conversion)
+    {
+    case 'd':
+    case 'i':
+      return LOG_ARG_SIGNED;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      return LOG_ARG_UNSIGNED;
+    case 'c':
+      return LOG_ARG_CHAR;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      return LOG_ARG_REAL;
+    case 'p':
+      return LOG_ARG_POINTER;
+    case 's':
+      return LOG_ARG_STRING;
+    default:
+      return LOG_ARG_NONE;
+    }
+}
+
+/**
+ * Keep the arguments of a message, the strings are copied. The
+ * arguments which don't fit are ignored, the end of the format
+ * string is then written as is
+ * @param record The record of the message
+ * @param args The arguments of the format string
+ */
+static void
+log_capture (log_record * record, va_list args)
+{
+  const char *ptr = record->format;
+  const char *str;
+  log_spec spec;
+  log_arg *arg;
+  Uint32 i, len, size;
+  record->numof_args = 0;
+  record->strings_size = 0;
+  while ((ptr = strchr (ptr, '%')) != NULL)
+    {
+      ptr++;
+      if (*ptr == '%')
+        {
+          ptr++;
+          continue;
+        }
+      log_parse_spec (ptr, &spec);
+      if (log_arg_type (spec.conversion) == LOG_ARG_NONE
+          || record->numof_args + spec.numof_stars + 1 > LOG_MAX_ARGS)
+        {
+          return;
+        }
+      for (i = 0; i < spec.numof_stars; i++)
+        {
+          record->args[record->numof_args++].integer = va_arg (args, int);
+        }
+      arg = &record->args[record->numof_args++];
+      switch (log_arg_type (spec.conversion))
+        {
+        case LOG_ARG_SIGNED:
+          switch (spec.modifier)
+            {
+            case 'l':
+              arg->integer = va_arg (args, long);
+              break;
+            case 'q':
+              arg->integer = va_arg (args, long long);
+              break;
+            case 'j':
+              arg->integer = va_arg (args, intmax_t);
+              break;
+            case 'z':
+              arg->integer = (long long) va_arg (args, size_t);
+              break;
+            case 't':
+              arg->integer = va_arg (args, ptrdiff_t);
+              break;
+            case 'h':
+              arg->integer = (short) va_arg (args, int);
+              break;
+            case 'H':
+              arg->integer = (signed char) va_arg (args, int);
+              break;
+            default:
+              arg->integer = va_arg (args, int);
+              break;
+            }
+          break;
+        case LOG_ARG_UNSIGNED:
+          switch (spec.modifier)
+            {
+            case 'l':
+              arg->integer = (long long) va_arg (args, unsigned long);
+              break;
+            case 'q':
+              arg->integer = (long long) va_arg (args, unsigned long long);
+              break;
+            case 'j':
+              arg->integer = (long long) va_arg (args, uintmax_t);
+              break;
+            case 'z':
+              arg->integer = (long long) va_arg (args, size_t);
+              break;
+            case 't':
+              arg->integer = (long long) va_arg (args, ptrdiff_t);
+              break;
+            case 'h':
+              arg->integer = (unsigned short) va_arg (args, unsigned int);
+              break;
+            case 'H':
+              arg->integer = (unsigned char) va_arg (args, unsigned int);
+              break;
+            default:
+              arg->integer = va_arg (args, unsigned int);
+              break;
+            }
+          break;
+        case LOG_ARG_CHAR:
+          arg->integer = va_arg (args, int);
+          break;
+        case LOG_ARG_REAL:
+          if (spec.modifier == 'L')
+            {
+              arg->real = (double) va_arg (args, long double);
+            }
+          else
+            {
+              arg->real = va_arg (args, double);
+            }
+          break;
+        case LOG_ARG_POINTER:
+          arg->pointer = va_arg (args, void *);
+          break;
+        case LOG_ARG_STRING:
+          str = va_arg (args, const char *);
+          if (str == NULL)
+            {
+              str = "(null)";
+            }
+          /* the strings often are in buffers reused by the caller */
+          size = LOG_STRINGS_SIZE - record->strings_size - 1;
+          if (spec.precision >= 0 && (Uint32) spec.precision < size)
+            {
+              size = spec.precision;
+            }
+          for (len = 0; len < size && str[len] != '\0'; len++)
+            {
+              record->strings[record->strings_size + len] = str[len];
+            }
+          record->strings[record->strings_size + len] = '\0';
+          arg->string = record->strings_size;
+          record->strings_size += len + 1;
+          break;
+        case LOG_ARG_NONE:
+          break;
+        }
+      ptr = spec.end;
+    }
+}
+
+/**
+ * Format a message from the arguments kept in a record
+ * @param record The record of the message
+ * @param message Buffer of LOG_MESSAGE_SIZE bytes
+ */
+static void
+log_render (const log_record * record, char *message)
+{
+  const char *ptr = record->format;
+  const char *percent;
+  const log_arg *arg = record->args;
+  const log_arg *last = record->args + record->numof_args;
+  log_spec spec;
+  char conversion[64];
+  Uint32 len = 0;
+  Uint32 conv_len, i, numof_stars;
+  Sint32 written;
+  while (len < LOG_MESSAGE_SIZE - 1 && *ptr != '\0')
+    {
+      percent = strchr (ptr, '%');
+      if (percent == NULL)
+        {
+          percent = ptr + strlen (ptr);
+        }
+      while (ptr < percent && len < LOG_MESSAGE_SIZE - 1)
+        {
+          message[len++] = *ptr++;
+        }
+      if (*ptr == '\0' || len >= LOG_MESSAGE_SIZE - 1)
+        {
+          break;
+        }
+      if (ptr[1] == '%')
+        {
+          message[len++] = '%';
+          ptr += 2;
+          continue;
+        }
+      log_parse_spec (ptr + 1, &spec);
+      if (log_arg_type (spec.conversion) == LOG_ARG_NONE
+          || arg + spec.numof_stars + 1 > last
+          || spec.length - ptr > (Sint32) sizeof (conversion) - 8)
+        {
+          /* not kept: write the end of the format string as is */
+          while (*ptr != '\0' && len < LOG_MESSAGE_SIZE - 1)
+            {
+              message[len++] = *ptr++;
+            }
+          break;
+        }
+      /* the stars are kept in the arguments, the length modifier
+       * is the one of the type of the argument kept */
+      conv_len = 0;
+      numof_stars = 0;
+      for (i = 0; ptr + i < spec.length; i++)
+        {
+          if (ptr[i] == '*')
+            {
+              conv_len +=
+                sprintf (conversion + conv_len, "%d",
+                         (int) arg[numof_stars++].integer);
+            }
+          else
+            {
+              conversion[conv_len++] = ptr[i];
+            }
+        }
+      arg += numof_stars;
+      switch (log_arg_type (spec.conversion))
+        {
+        case LOG_ARG_SIGNED:
+        case LOG_ARG_UNSIGNED:
+          conversion[conv_len++] = 'l';
+          conversion[conv_len++] = 'l';
+          break;
+        default:
+          break;
+        }
+      conversion[conv_len++] = spec.conversion;
+      conversion[conv_len] = '\0';
+      switch (log_arg_type (spec.conversion))
+        {
+        case LOG_ARG_SIGNED:
+          written = snprintf (message + len, LOG_MESSAGE_SIZE - len,
+                              conversion, arg->integer);
+          break;
+        case LOG_ARG_UNSIGNED:
+          written = snprintf (message + len, LOG_MESSAGE_SIZE - len,
+                              conversion, (unsigned long long) arg->integer);
+          break;
+        case LOG_ARG_CHAR:
+          written = snprintf (message + len, LOG_MESSAGE_SIZE - len,
+                              conversion, (int) arg->integer);
+          break;
+        case LOG_ARG_REAL:
+          written = snprintf (message + len, LOG_MESSAGE_SIZE - len,
+                              conversion, arg->real);
+          break;
+        case LOG_ARG_POINTER:
+          written = snprintf (message + len, LOG_MESSAGE_SIZE - len,
+                              conversion, arg->pointer);
+          break;
+        case LOG_ARG_STRING:
+          written = snprintf (message + len, LOG_MESSAGE_SIZE - len,
+                              conversion, record->strings + arg->string);
+          break;
+        default:
+          written = 0;
+          break;
+        }
+      arg++;
+      if (written > 0)
+        {
+          len += written;
+        }
+      if (len > LOG_MESSAGE_SIZE - 1)
+        {
+          len = LOG_MESSAGE_SIZE - 1;
+        }
+      ptr = spec.end;
+    }
+  message[len] = '\0';
+}
+
+/**
+ * Write the messages of the ring, only one thread can do it
+ * at once
+ * @return FALSE if an other thread is emptying the ring
+ */
+static bool
+log_drain (void)
+{
+  log_record *record;
+  Sint32 dropped;
+  if (!SDL_AtomicCAS (&log_consuming, 0, 1))
+    {
+      return FALSE;
+    }
+  for (;;)
+    {
+      record = &log_ring[ring_tail & (LOG_RING_SIZE - 1)];
+      if ((Uint32) SDL_AtomicGet (&record->sequence) != ring_tail + 1)
+        {
+          break;
+        }
+      log_render (record, buffer_message);
+      if (buffer_message[0] != '\0')
+        {
+#if defined(ENABLE_LOG_FILE)
+          log_write (record->level, record->filename, record->line_num,
+                     record->function, record->time, buffer_message,
+                     output_message);
+#endif
+          /* put the message in the console */
+          log_put (record->level, record->filename, record->line_num,
+                   record->function, buffer_message, output_message);
+        }
+      /* the record can be reused once the ring went around */
+      SDL_AtomicSet (&record->sequence, ring_tail + LOG_RING_SIZE);
+      ring_tail++;
+    }
+  dropped = SDL_AtomicGet (&log_dropped);
+  if ((Uint32) dropped != log_dropped_reported)
+    {
+      fprintf (stderr, "(WW) %i log messages were dropped, the log"
+               " ring was full\n", dropped - (Sint32) log_dropped_reported);
+      log_dropped_reported = dropped;
+    }
+  SDL_AtomicSet (&log_consuming, 0);
+  return TRUE;
+}
+
+/**
+ * Log thread: format and write the messages of the ring
+ * @param unused
+ * @return Always 0
+ */
+static Sint32
+log_thread_run (void *unused)
+{
+  (void) unused;
+  while (!SDL_AtomicGet (&log_stop))
+    {
+      SDL_SemWait (log_posted);
+      log_drain ();
+    }
+  while (!log_drain ())
+    {
+      SDL_Delay (1);
+    }
+  return 0;
+}
+
+/**
+ * Write all the messages pending in the ring
+ */
+void
+log_flush (void)
+{
+  if (log_thread == NULL)
+    {
+      return;
+    }
+  while (!log_drain ())
+    {
+      SDL_Delay (1);
+    }
+  fflush (stdout);
+}
+
+/**
+ * Start again the log thread in a forked child, the
+ * threads of the parent don't exist in the child
+ */
+void
+log_fork_child (void)
+{
+  if (log_thread == NULL)
+    {
+      return;
+    }
+  SDL_AtomicSet (&log_consuming, 0);
+  SDL_AtomicSet (&log_stop, 0);
+  log_thread = SDL_CreateThread (log_thread_run, "log", NULL);
+}
+
+/**
+ * Crash handler: write the pending messages before the process
+ * ends. The thread which was writing them is given a short time
+ * to finish, then the crash is raised again
+ * @param signum Number of the signal
+ */
+static void
+log_crash (int signum)
+{
+  Uint32 tries;
+  signal (signum, SIG_DFL);
+  if (log_ring != NULL)
+    {
+      for (tries = 0; tries < 100 && !log_drain (); tries++)
+        {
+          SDL_Delay (1);
+        }
+    }
+  fflush (stdout);
+  fflush (stderr);
+  raise (signum);
+}
+
+/**
+ * Format and write a message at once, before the log thread
+ * starts or after it stopped
  * @param level The level of this message 
  * @param filename The filename in which this function is called
  * @param line_num The line number on which this function is called
  * @param function The function name in which this function is called
  * @param format The format string to be appended to the log
- * @param ... The arguments to use to fill out format 
+ * @param args The arguments to use to fill out format 
  */
 static void
 write_log (LOG_LEVELS level, const char *filename,
            Sint32 line_num, const char *function,
            const char *format, va_list args)
 {
+  char message[LOG_MESSAGE_SIZE];
+  char output[LOG_OUTPUT_SIZE];
   Sint32 msg_len;
-  if (buffer_message == NULL)
-    {
-      return;
-    }
-  msg_len = vsnprintf (buffer_message, LOG_MESSAGE_SIZE, format, args);
+  msg_len = vsnprintf (message, LOG_MESSAGE_SIZE, format, args);
   if (msg_len < 1)
     {
       return;
     }
-  buffer_message[msg_len] = 0;
 #if defined(ENABLE_LOG_FILE)
-  log_write (level, filename, line_num, function, buffer_message);
+  log_write (level, filename, line_num, function, time (NULL), message,
+             output);
 #endif
   /* put the message in the console */
-  log_put (level, filename, line_num, function, buffer_message);
+  log_put (level, filename, line_num, function, message, output);
+}
+
+/**
+ * Put a message in the ring, the log thread formats and writes it.
+ * The message is dropped if the ring is full
+ * @param level The level of this message 
+ * @param filename The filename in which this function is called
+ * @param line_num The line number on which this function is called
+ * @param function The function name in which this function is called
+ * @param format The format string to be appended to the log
+ * @param args The arguments to use to fill out format 
+ */
+static void
+log_push (LOG_LEVELS level, const char *filename,
+          Sint32 line_num, const char *function,
+          const char *format, va_list args)
+{
+  log_record *record;
+  Sint32 position, sequence;
+  position = SDL_AtomicGet (&ring_head);
+  for (;;)
+    {
+      record = &log_ring[position & (LOG_RING_SIZE - 1)];
+      sequence = SDL_AtomicGet (&record->sequence);
+      if (sequence == position)
+        {
+          if (SDL_AtomicCAS (&ring_head, position, position + 1))
+            {
+              break;
+            }
+        }
+      else if (sequence - position < 0)
+        {
+          /* the log thread is late by a whole ring */
+          SDL_AtomicAdd (&log_dropped, 1);
+          return;
+        }
+      position = SDL_AtomicGet (&ring_head);
+    }
+  record->level = level;
+  record->filename = filename;
+  record->line_num = line_num;
+  record->function = function;
+  record->format = format;
+#if defined(ENABLE_LOG_FILE)
+  record->time = time (NULL);
+#endif
+  log_capture (record, args);
+  /* publish the record */
+  SDL_AtomicSet (&record->sequence, position + 1);
+  SDL_SemPost (log_posted);
 }
 
 /**
@@ -292,7 +1001,112 @@ log_message (LOG_LEVELS level, const char *filename, Sint32 line_num,
     }
   va_start (args, function);
   format = va_arg (args, const char *);
-  write_log (level, filename, line_num, function, format, args);
+  if (log_thread != NULL)
+    {
+      log_push (level, filename, line_num, function, format, args);
+    }
+  else if (log_mutex != NULL)
+    {
+      SDL_LockMutex (log_mutex);
+      write_log (level, filename, line_num, function, format, args);
+      SDL_UnlockMutex (log_mutex);
+    }
+  else
+    {
+      write_log (level, filename, line_num, function, format, args);
+    }
   va_end (args);
 }
+
+/**
+ * Count a message of a call site of LOG_ERR or LOG_WARN. The first
+ * message of a period is written, with the number of messages of
+ * the previous period
+ * @param site The state of the call site
+ * @param level The level of the messages of the site
+ * @param filename The filename of the call site
+ * @param line_num The line number of the call site
+ * @param function The function name of the call site
+ * @return TRUE if the message must be written, FALSE if it was counted
+ */
+bool
+log_site_open (log_site * site, LOG_LEVELS level, const char *filename,
+               Sint32 line_num, const char *function)
+{
+  Uint32 now = SDL_GetTicks ();
+  Uint32 repeats = 0;
+  Uint32 since = now;
+  bool is_written = TRUE;
+  if (log_mutex != NULL)
+    {
+      SDL_LockMutex (log_mutex);
+    }
+  if (site->filename == NULL)
+    {
+      site->level = level;
+      site->line_num = line_num;
+      site->function = function;
+      site->filename = filename;
+      site->next = log_sites;
+      log_sites = site;
+    }
+  else if (now - site->since < LOG_SITE_PERIOD)
+    {
+      site->repeats++;
+      is_written = FALSE;
+    }
+  else
+    {
+      repeats = site->repeats;
+      since = site->since;
+    }
+  if (is_written)
+    {
+      site->since = now;
+      site->repeats = 0;
+    }
+  if (log_mutex != NULL)
+    {
+      SDL_UnlockMutex (log_mutex);
+    }
+  if (repeats > 0)
+    {
+      log_message (level, filename, line_num, function,
+                   "message repeated %u times in last %u ms",
+                   repeats, now - since);
+    }
+  return is_written;
+}
+
+/**
+ * Write the number of messages not written yet by the call sites
+ * of LOG_ERR and LOG_WARN
+ */
+static void
+log_sites_report (void)
+{
+  log_site *site;
+  Uint32 repeats;
+  Uint32 now = SDL_GetTicks ();
+  for (site = log_sites; site != NULL; site = site->next)
+    {
+      if (log_mutex != NULL)
+        {
+          SDL_LockMutex (log_mutex);
+        }
+      repeats = site->repeats;
+      site->repeats = 0;
+      if (log_mutex != NULL)
+        {
+          SDL_UnlockMutex (log_mutex);
+        }
+      if (repeats == 0)
+        {
+          continue;
+        }
+      log_message (site->level, site->filename, site->line_num,
+                   site->function, "message repeated %u times in last %u ms",
+                   repeats, now - site->since);
+    }
+}
 #endif
@@ -37,6 +37,8 @@
 #define LOG_INF(...)  ( (void)0 )
 #define LOG_WARN(...)  ( (void)0 )
 #define LOG_ERR(...)  ( (void)0 )
+#define LOG_WARN_ALL(...)  ( (void)0 )
+#define LOG_ERR_ALL(...)  ( (void)0 )
 
 #else
 
@@ -52,20 +54,62 @@ typedef enum
   LOG_NUMOF
 } LOG_LEVELS;
 
+/** Period in milliseconds during which a call site of LOG_ERR
+ * or LOG_WARN writes only one message */
+#define LOG_SITE_PERIOD 1000
+
+/** State of a call site of LOG_ERR or LOG_WARN, the messages of a
+ * site are only counted during a period once one was written. The
+ * threads update it under the log mutex */
+typedef struct log_site
+{
+  /** Time in milliseconds of the last written message */
+  Uint32 since;
+  /** Number of messages not written since */
+  Uint32 repeats;
+  LOG_LEVELS level;
+  Sint32 line_num;
+  const char *filename;
+  const char *function;
+  /** Next site which wrote a message, NULL if it's the last one */
+  struct log_site *next;
+} log_site;
+
 void log_message (LOG_LEVELS level, const char *filename, Sint32 line_num,
                   const char *function, ...);
 void log_set_level (LOG_LEVELS verbose);
 bool log_initialize (LOG_LEVELS verbose);
 void log_close (void);
+void log_flush (void);
+void log_fork_child (void);
+bool log_site_open (log_site * site, LOG_LEVELS level,
+                    const char *filename, Sint32 line_num,
+                    const char *function);
 
-#define LOG_ERR(...)  log_message \
-  (LOG_ERROR, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
+/* the first message of a site is written, the following ones are
+ * counted until the period ends */
+#define LOG_LIMITED(level, ...)  do \
+  { \
+    static log_site log_site_state = \
+      { 0, 0, LOG_NOTHING, 0, NULL, NULL, NULL }; \
+    if (log_site_open (&log_site_state, level, __FILE__, __LINE__, \
+                       __func__)) \
+      { \
+        log_message (level, __FILE__, __LINE__, __func__, ##__VA_ARGS__); \
+      } \
+  } while (0)
+
+#define LOG_ERR(...)  LOG_LIMITED (LOG_ERROR, ##__VA_ARGS__)
 #define LOG_INF(...)  log_message \
   (LOG_INFO, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
-#define LOG_WARN(...)  log_message \
-  (LOG_WARNING, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#define LOG_WARN(...)  LOG_LIMITED (LOG_WARNING, ##__VA_ARGS__)
 #define LOG_DBG(...)  log_message \
   (LOG_DEBUG, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
+/* never limited: for the reports which loop over their items */
+#define LOG_ERR_ALL(...)  log_message \
+  (LOG_ERROR, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#define LOG_WARN_ALL(...)  log_message \
+  (LOG_WARNING, __FILE__, __LINE__, __func__, ##__VA_ARGS__)
 
 #endif
 #endif
@@ -155,7 +155,7 @@ lonely_foe_curve_create (Sint32 type, Sint32 shot_delay)
   Sint16 current_image, power, energy;
   spaceship_struct *ship = spaceship_get ();
   curve_num = 51 + (Sint16) (rand () % 4);
-  current_image = initial_curve[curve_num].angle[0];
+  current_image = initial_curve[curve_num].points[0].angle;
   power = (Sint16) ((ship->type << 1) + type - 40);
   energy = (Sint16) ((ship->type << 2) + (power << 3) / 3 + 10);
   foe = lonely_foe_new (power, energy, current_image, type, shot_delay);
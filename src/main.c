@@ -28,6 +28,8 @@
 #include "tools.h"
 #include "images.h"
 #include "config_file.h"
+#include "archive.h"
+#include "arena.h"
 #include "curve_phase.h"
 #include "display.h"
 #include "electrical_shock.h"
@@ -35,15 +37,20 @@
 #include "bonus.h"
 #include "energy_gauge.h"
 #include "explosions.h"
+#include "frame_pacer.h"
+#include "frame_times.h"
 #include "shots.h"
 #include "extra_gun.h"
 #include "gfx_wrapper.h"
 #include "guardians.h"
 #include "menu.h"
+#include "menu_sections.h"
 #include "meteors_phase.h"
 #include "movie.h"
 #include "log_recorder.h"
 #include "options_panel.h"
+#include "profiler.h"
+#include "render_list.h"
 #include "scrolltext.h"
 #include "satellite_protections.h"
 #include "shockwave.h"
@@ -56,20 +63,21 @@
 
 /* TRUE = leave the Mangadualist game */
 bool quit_game = FALSE;
-#ifdef MANGADUALIST_SDL
-/* game speed : 70 frames/sec (1000 <=> 1 seconde ; 1000 / 70 =~ 14) */
-static const Uint32 GAME_FRAME_RATE = 14;
-/* movie speed: 28 frames/sec */
-static const Uint32 MOVIE_FRAME_RATE = 35;
-#else
-/* game speed : 70 frames/sec (1000000 <=> 1 seconde ; 1000000 / 70 =~ 14286) */
-static const Uint32 GAME_FRAME_RATE = 14286;
-/* movie speed: 28 frames/sec */
-static const Uint32 MOVIE_FRAME_RATE = 35715;
-#endif
+/* TRUE = the frames are not paced; unlike power_conf->nosync,
+ * it is not saved in the configuration file */
+static bool sync_disabled = FALSE;
+/* TRUE = the events are not handled, by the fork-server children */
+static bool events_disabled = FALSE;
+/* ticks run before a frame is presented, at most */
+static const Uint32 MAX_TICKS_PER_FRAME = 5;
+/* episodes played at the same time by the fork-server, at most */
+static const Uint32 FORK_SERVER_MAX_EPISODES = 8;
 
 static bool initialize_and_run (void);
+static Uint32 main_tick (Uint32 ticks_counter, Uint32 * state_hash);
 static void main_loop (void);
+static Uint32 fork_server_reap (Uint32 numof_episodes, bool is_blocking);
+static bool fork_server_run (void);
 
 /**
  * The main function is where the program starts execution.
@@ -124,11 +132,29 @@ main (Sint32 args_count, char **arguments)
           power_conf->nosound = TRUE;
           pixel_size = 1;
         }
+      /* the children can neither share the audio thread nor the
+       * window of the server; these overrides are not saved */
+      render_disabled = power_conf->norender || power_conf->fork_server;
+#ifdef USE_SDLMIXER
+      sound_disabled = power_conf->nosound || power_conf->fork_server;
+#endif
+      /* no drawing: no reason to wait for the display */
+      sync_disabled = power_conf->nosync || render_disabled;
         vmode = 0;
-      initialize_and_run ();
+      if (power_conf->pack_archive != NULL)
+        {
+          archive_pack (power_conf->pack_archive);
+        }
+      else
+        {
+          initialize_and_run ();
+        }
     }
   release_game ();
 
+#if defined (USE_MALLOC_WRAPPER)
+  memory_report ();
+#endif
 #if defined(MANGADUALIST_LOG_ENABLED)
   log_close ();
 #endif
@@ -186,6 +212,25 @@ initialize_and_run (void)
     }
 #endif
 
+  if (power_conf->fork_server)
+    {
+      if (!fork_server_run ())
+        {
+          return TRUE;
+        }
+      /* forked child: play one episode, then leave without releasing
+       * the resources shared with the server */
+      events_disabled = TRUE;
+      fps_init ();
+      main_loop ();
+      fps_print ();
+#if defined(MANGADUALIST_LOG_ENABLED)
+      log_flush ();
+#endif
+      fflush (stdout);
+      _exit (0);
+    }
+
   fps_init ();
   main_loop ();
   fps_print ();
@@ -194,48 +239,292 @@ initialize_and_run (void)
   return TRUE;
 }
 
+#if defined (USE_MALLOC_WRAPPER)
 /**
- * Main loop of the Mangadualist game
+ * Check if the player is playing, neither the menu nor a movie
+ * are displayed and the game is not paused
+ * @return TRUE if a gameplay frame is being processed
+ */
+static bool
+is_gameplay_frame (void)
+{
+  return menu_status == MENU_OFF && menu_section == NO_SECTION_SELECTED
+    && movie_playing_switch == MOVIE_NOT_PLAYED && !player_pause;
+}
+#endif
+
+/**
+ * Run a tick of the game: update and draw the game offscreen,
+ * then handle the events and the sounds
+ * @param ticks_counter Number of ticks since the start
+ * @param state_hash Hash of the game state, updated with --framehash
+ * @return Duration of update_frame() in microseconds
+ */
+static Uint32
+main_tick (Uint32 ticks_counter, Uint32 * state_hash)
+{
+  Uint64 update_start;
+  Uint32 duration;
+#if defined (USE_MALLOC_WRAPPER)
+  Sint32 level;
+  bool is_gameplay;
+#endif
+  /* fire button held: start a game from the menu and keep shooting */
+  if (power_conf->hash_frames > 0)
+    {
+      fire_button_down = TRUE;
+    }
+  /* the scratch memory of the previous frame is no more used */
+  arena_reset (&frame_arena);
+#if defined (USE_MALLOC_WRAPPER)
+  is_gameplay = is_gameplay_frame ();
+  level = num_level;
+  memory_frame_begin ();
+#endif
+  /* handle Mangadualist game */
+  PROFILER_BEGIN (PROFILER_UPDATE);
+  update_start = frame_times_now ();
+  render_list_begin ();
+  if (!update_frame ())
+    {
+      quit_game = TRUE;
+    }
+  render_list_end ();
+  duration = (Uint32) (frame_times_now () - update_start);
+  PROFILER_END ();
+#if defined (USE_MALLOC_WRAPPER)
+  /* a gameplay frame uses the arenas, never the heap, only a
+   * new level may convert its sprites if they are not cached */
+  memory_frame_end (is_gameplay && is_gameplay_frame ()
+                    && level == num_level);
+#endif
+  if (power_conf->hash_frames > 0)
+    {
+      *state_hash = game_state_hash (*state_hash);
+      if (ticks_counter >= (Uint32) power_conf->hash_frames)
+        {
+          quit_game = TRUE;
+        }
+    }
+  /* handle keyboard and joystick events */
+  if (!events_disabled)
+    {
+      PROFILER_BEGIN (PROFILER_EVENTS);
+      display_handle_events ();
+      PROFILER_END ();
+    }
+
+#ifdef USE_SDLMIXER
+  /* play music and sounds */
+  PROFILER_BEGIN (PROFILER_SOUND);
+  sound_handle ();
+  PROFILER_END ();
+#endif
+  return duration;
+}
+
+/**
+ * Main loop of the Mangadualist game. The game runs at 70 ticks per
+ * second. Without vertical retrace, a frame is presented after each
+ * tick. With it, the frames are presented at the refresh rate of the
+ * display and the sprites are drawn between their positions of the
+ * last two ticks
  */
 void
 main_loop (void)
 {
-  Sint32 pause_delay = 0;
-  Sint32 frame_diff = 0;
+  Uint32 state_hash = HASH_FNV1A_INIT;
+  Uint32 durations[FRAME_TIMES_NUMOF];
+  Uint32 rate, jitter, numof_ticks;
+  Uint32 ticks_counter = 0;
+  Uint64 frame_start, awake, present_start, frame_end, previous;
+  /* time not yet run by the ticks, in microseconds times the rate:
+   * a tick is due every million */
+  Uint64 accumulator = 0;
+  /* a recorded movie keeps one frame per tick */
+  bool is_decoupled = display_vsync && !sync_disabled
+    && power_conf->record_movie == NULL;
+  render_list_enable (is_decoupled);
+  previous = frame_times_now ();
   do
     {
       loops_counter++;
-      if (!power_conf->nosync)
+#if defined (USE_PROFILER)
+      profiler_frame_begin ();
+#endif
+      frame_start = frame_times_now ();
+      rate = movie_playing_switch != MOVIE_NOT_PLAYED ?
+        MOVIE_FRAME_RATE : GAME_FRAME_RATE;
+      numof_ticks = 1;
+      if (is_decoupled)
         {
-          frame_diff = get_time_difference ();
-          if (movie_playing_switch != MOVIE_NOT_PLAYED)
+          accumulator += (frame_start - previous) * rate;
+          previous = frame_start;
+          numof_ticks = (Uint32) (accumulator / 1000000);
+          if (numof_ticks > MAX_TICKS_PER_FRAME)
             {
-              pause_delay =
-                wait_next_frame (MOVIE_FRAME_RATE - frame_diff + pause_delay,
-                                 MOVIE_FRAME_RATE);
+              /* too late: don't try to catch up */
+              numof_ticks = MAX_TICKS_PER_FRAME;
+              accumulator %= 1000000;
             }
           else
             {
-              pause_delay =
-                wait_next_frame (GAME_FRAME_RATE - frame_diff + pause_delay,
-                                 GAME_FRAME_RATE);
+              accumulator -= (Uint64) numof_ticks * 1000000;
             }
         }
-      /* handle Mangadualist game */
-      if (!update_frame ())
+      else if (!sync_disabled)
         {
-          quit_game = TRUE;
+          PROFILER_BEGIN (PROFILER_WAIT);
+          /* the late frames are recorded too, they are the worst */
+          frame_pacer_wait (rate, &jitter);
+          frame_times_add (FRAME_TIMES_JITTER, jitter);
+          PROFILER_END ();
+        }
+      awake = frame_times_now ();
+      durations[FRAME_TIMES_UPDATE] = 0;
+      while (numof_ticks-- > 0 && !quit_game)
+        {
+          durations[FRAME_TIMES_UPDATE] +=
+            main_tick (++ticks_counter, &state_hash);
         }
-      /* handle keyboard and joystick events */
-      display_handle_events ();
 
       /* update our main window */
+      PROFILER_BEGIN (PROFILER_DISPLAY);
+      present_start = frame_times_now ();
+      if (is_decoupled)
+        {
+          render_list_draw ((Uint32) (accumulator * RENDER_LIST_ONE /
+                                      1000000));
+        }
       display_update_window ();
+      PROFILER_END ();
+      frame_end = frame_times_now ();
+      durations[FRAME_TIMES_FRAME] = (Uint32) (frame_end - frame_start);
+      /* the presentation waits for the vertical retrace */
+      durations[FRAME_TIMES_BUSY] =
+        (Uint32) ((is_decoupled ? present_start : frame_end) - awake);
+      frame_times_record (durations, 1000000 / rate);
+    }
+  while (!quit_game);
+  if (power_conf->hash_frames > 0)
+    {
+      /* also catch any divergence of the random generator */
+      Sint32 seed = rand ();
+      state_hash = hash_fnv1a (state_hash, &seed, sizeof (seed));
+      fprintf (stdout, "state hash after %i frames: %08x\n",
+               power_conf->hash_frames, state_hash);
+    }
+#if defined (USE_PROFILER)
+  if (power_conf->profiler_trace != NULL)
+    {
+      profiler_write_trace (power_conf->profiler_trace);
+    }
+#endif
+}
 
-#ifdef USE_SDLMIXER
-      /* play music and sounds */
-      sound_handle ();
+/**
+ * Reap the episodes of the fork-server which have finished
+ * @param numof_episodes Number of episodes running
+ * @param is_blocking TRUE to wait until at least one episode finishes
+ * @return Number of episodes still running
+ */
+static Uint32
+fork_server_reap (Uint32 numof_episodes, bool is_blocking)
+{
+  int status;
+  pid_t pid;
+  while (numof_episodes > 0)
+    {
+      pid = waitpid (-1, &status, is_blocking ? 0 : WNOHANG);
+      if (pid < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (pid < 0)
+        {
+          LOG_ERR ("waitpid() failed: %s", strerror (errno));
+          return 0;
+        }
+      if (pid == 0)
+        {
+          break;
+        }
+      numof_episodes--;
+      is_blocking = FALSE;
+      fprintf (stdout, "episode %i exited with %i\n", (Sint32) pid,
+               WIFEXITED (status) ? WEXITSTATUS (status) : -1);
+      fflush (stdout);
+    }
+  return numof_episodes;
+}
+
+/**
+ * Fork-server: the assets are loaded only once, then each "run [frames]"
+ * line read on the standard input forks a child which plays one episode
+ * of a bounded number of frames, by default the one of --framehash.
+ * The children share all the asset memory copy-on-write with the server,
+ * up to FORK_SERVER_MAX_EPISODES of them run at the same time.
+ * A "quit" line or the end of the input stops the server once all the
+ * episodes have finished
+ * @return TRUE in a forked child which must play the episode,
+ *         FALSE in the server once it has finished
+ */
+static bool
+fork_server_run (void)
+{
+  char line[64];
+  Sint32 frames;
+  Uint32 numof_episodes = 0;
+  pid_t pid;
+  LOG_INF ("fork-server ready");
+  while (fgets (line, sizeof (line), stdin) != NULL)
+    {
+      numof_episodes = fork_server_reap (numof_episodes, FALSE);
+      if (!strncmp (line, "quit", 4))
+        {
+          break;
+        }
+      if (strncmp (line, "run", 3))
+        {
+          LOG_WARN ("fork-server: unknown command %s", line);
+          continue;
+        }
+      frames = power_conf->hash_frames;
+      sscanf (line + 3, "%d", &frames);
+      /* an episode without end would never be reaped */
+      if (frames <= 0)
+        {
+          LOG_WARN ("fork-server: \"run\" expects a number of frames");
+          continue;
+        }
+      if (numof_episodes >= FORK_SERVER_MAX_EPISODES)
+        {
+          numof_episodes = fork_server_reap (numof_episodes, TRUE);
+        }
+      /* don't let the child output again what is still buffered */
+#if defined(MANGADUALIST_LOG_ENABLED)
+      log_flush ();
 #endif
+      fflush (stdout);
+      pid = fork ();
+      if (pid < 0)
+        {
+          LOG_ERR ("fork() failed: %s", strerror (errno));
+          break;
+        }
+      if (pid == 0)
+        {
+#if defined(MANGADUALIST_LOG_ENABLED)
+          log_fork_child ();
+#endif
+          power_conf->hash_frames = frames;
+          return TRUE;
+        }
+      numof_episodes++;
     }
-  while (!quit_game);
+  while (numof_episodes > 0)
+    {
+      numof_episodes = fork_server_reap (numof_episodes, TRUE);
+    }
+  return FALSE;
 }
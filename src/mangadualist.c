@@ -48,6 +48,7 @@
 #include "meteors_phase.h"
 #include "movie.h"
 #include "options_panel.h"
+#include "profiler.h"
 #include "satellite_protections.h"
 #include "scrolltext.h"
 #include "shockwave.h"
@@ -139,34 +140,44 @@ update_frame (void)
       /* 
        * handle the phases of the game 
        */
+      PROFILER_BEGIN (PROFILER_PHASES);
       /* phase 2: grids (enemy wave like Space Invaders) */
       grid_handle ();
       /* phase 1: curves (little skirmish) */
       curve_phase ();
       /* phase 3: meteor storm */
       meteors_handle ();
+      PROFILER_END ();
     }
 
   /* draw the starfield background */
+  PROFILER_BEGIN (PROFILER_STARFIELD);
   starfield_handle ();
+  PROFILER_END ();
 
   /* handle bonus: green, red, yellow, blue and purple gems */
+  PROFILER_BEGIN (PROFILER_BONUS);
   bonus_handle ();
+  PROFILER_END ();
 
   /* handle protection satellites and extra gun of the player spaceship  */
   if (!gameover_enable && menu_section == NO_SECTION_SELECTED)
     {
+      PROFILER_BEGIN (PROFILER_SATELLITES);
       /* orbital protection satellites gravitate around player's spaceship */
       satellites_handle ();
       /* extra gun positioned on the sides */
       guns_handle ();
+      PROFILER_END ();
     }
 
   /* handle enemies */
   if (!is_congratulations_enabled)
     {
       /* handling of all the possible types of enemies */
+      PROFILER_BEGIN (PROFILER_ENEMIES);
       enemies_handle ();
+      PROFILER_END ();
     }
   else
     {
@@ -181,13 +192,19 @@ update_frame (void)
   electrical_shock ();
 
   /* draw the player's spaceship */
+  PROFILER_BEGIN (PROFILER_SPACESHIP);
   spaceship_draw ();
+  PROFILER_END ();
 
   /* handle explosions */
+  PROFILER_BEGIN (PROFILER_EXPLOSIONS);
   explosions_handle ();
+  PROFILER_END ();
 
   /* handle shots */
+  PROFILER_BEGIN (PROFILER_SHOTS);
   shots_handle ();
+  PROFILER_END ();
 
   /* wait until all enemies are dead before jumping on next phase */
   if (num_of_enemies == 0 && !player_pause && menu_status == MENU_OFF
@@ -226,7 +243,9 @@ update_frame (void)
   option_execution ();
 
   /* handle high score table, game over, about and order sections */
+  PROFILER_BEGIN (PROFILER_SECTIONS);
   menu_sections_run ();
+  PROFILER_END ();
 
   /* display "PAUSE" chars sprites */
   if (is_pause_draw)
@@ -272,7 +291,9 @@ update_frame (void)
   scrolltext_handle ();
 
   /* handle the main menu of Powermanga */
+  PROFILER_BEGIN (PROFILER_MENU);
   menu_handle ();
+  PROFILER_END ();
 
   /* handle "TLK Games" sprite logo */
   if (tlk_logo_is_move)
@@ -390,6 +411,34 @@ update_frame (void)
   return TRUE;
 }
 
+/**
+ * Fold the gameplay state of the current frame into a hash,
+ * used to check that two runs evolve identically
+ * @param hash Current hash value
+ * @return The updated hash value
+ */
+Uint32
+game_state_hash (Uint32 hash)
+{
+  spaceship_struct *ship = spaceship_get ();
+  hash = hash_fnv1a (hash, &global_counter, sizeof (global_counter));
+  hash = hash_fnv1a (hash, &num_level, sizeof (num_level));
+  hash = hash_fnv1a (hash, &player_score, sizeof (player_score));
+  hash = hash_fnv1a (hash, &gameover_enable, sizeof (gameover_enable));
+  hash = hash_fnv1a (hash, &menu_status, sizeof (menu_status));
+  hash = hash_fnv1a (hash, &num_of_enemies, sizeof (num_of_enemies));
+  hash = hash_fnv1a (hash, &num_of_shots, sizeof (num_of_shots));
+  hash = hash_fnv1a (hash, &starfield_speed, sizeof (starfield_speed));
+  hash = sprite_hash (hash, &ship->spr);
+  hash = hash_fnv1a (hash, &ship->type, sizeof (ship->type));
+  hash = hash_fnv1a (hash, &ship->gems_count, sizeof (ship->gems_count));
+  hash = enemies_hash (hash);
+  hash = shots_hash (hash);
+  hash = explosions_hash (hash);
+  hash = bonus_hash (hash);
+  return hash;
+}
+
 /**
  * Enable/disable pause
  **/
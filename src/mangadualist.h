@@ -49,6 +49,7 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 
 #include <math.h>
 #include <stdio.h>
@@ -93,18 +94,11 @@
 /** Use X Window for display */
 #include <X11/keysym.h>
 #include <X11/keysymdef.h>
-typedef unsigned char Uint8;
-typedef signed char Sint8;
-typedef signed short Sint16;
-typedef unsigned short Uint16;
-typedef signed int Sint32;
-typedef unsigned int Uint32;
-
-/** Else use SDL */
-#else
-#include <SDL2/SDL.h>
 
 #endif
+/** Also with X Window, the SDL provides the types, the threads,
+ * the atomics and the timers */
+#include <SDL2/SDL.h>
 /** Devel flag */
   /* #define DEVELOPPEMENT */
 
@@ -113,9 +107,6 @@ typedef unsigned int Uint32;
 #endif
 
 #ifdef USE_SDLMIXER
-#if defined(MANGADUALIST_X11)
-#include <SDL2/SDL.h>
-#endif
 #include <SDL2/SDL_thread.h>
 #include <SDL2/SDL_mixer.h>
 #endif
@@ -123,6 +114,10 @@ typedef unsigned int Uint32;
 /* #define SHAREWARE_VERSION */
 /** Maximum number of levels in the game, range 0 to 41 */
 #define MAX_NUM_OF_LEVELS 41
+/** Game speed: 70 frames per second */
+#define GAME_FRAME_RATE 70
+/** Movie speed: 28 frames per second */
+#define MOVIE_FRAME_RATE 28
 #define TWO_PI 6.28318530718f
 #define PI 3.14159265359f
 #define HALF_PI 1.57079632679f
@@ -157,6 +152,7 @@ extern "C"
   /* "mangadualist.c" file */
   bool update_frame ();
   bool toggle_pause ();
+  Uint32 game_state_hash (Uint32 hash);
   /** If TRUE display "GAME OVER" */
   extern bool gameover_enable;
   extern Sint32 global_counter;
@@ -27,6 +27,7 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "tools.h"
+#include "arena.h"
 #include "images.h"
 #include "config_file.h"
 #include "display.h"
@@ -80,6 +81,7 @@ const Sint16 KEYSTROKE_EOF = 0x4c2;
 
 static void destroy (void);
 static bool about_load_text (void);
+static bool tables_allocate (void);
 static void about_release_memory (void);
 static bool order_load_textdata (void);
 static void order_release_data (void);
@@ -158,6 +160,8 @@ static sprite_string_struct *about_string = NULL;
  */
 /** List of all the strings composing the high score table */
 static sprite_string_struct **order_strings = NULL;
+/** The tables of the menu sections, allocated once together */
+static arena menu_arena = { "menu", NULL, 0, 0, 0 };
 Sint32 order_x_cursor = 0;
 Uint32 order_y_cursor = 0;
 char *order_text_data = NULL;
@@ -178,7 +182,11 @@ bool order_cmd_type = FALSE;
 bool
 menu_sections_once_init (void)
 {
-  return about_load_text ();
+  if (!about_load_text ())
+    {
+      return FALSE;
+    }
+  return tables_allocate ();
 }
 
 /**
@@ -190,6 +198,42 @@ menu_sections_free (void)
   destroy ();
   about_release_memory ();
   order_release_data ();
+  arena_destroy (&menu_arena);
+}
+
+/**
+ * Allocate the tables of the high score and order sections from
+ * the menu arena
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+tables_allocate (void)
+{
+  Uint32 i;
+  scores_chars_sprites =
+    (sprite_char_struct **) arena_alloc (&menu_arena,
+                                         SCORE_TABLE_SIZE *
+                                         sizeof (sprite_char_struct *));
+  scores_strings =
+    (sprite_string_struct **) arena_alloc (&menu_arena,
+                                           MAX_OF_HIGH_SCORES * 2 *
+                                           sizeof (sprite_string_struct *));
+  order_strings =
+    (sprite_string_struct **) arena_alloc (&menu_arena,
+                                           KEYSTROKE_NUM_OF_LINES *
+                                           sizeof (sprite_string_struct *));
+  order_text_data =
+    arena_alloc (&menu_arena, KEYSTROKE_NUM_OF_LINES * KEYSTOKE_NUM_OF_COLS);
+  if (scores_chars_sprites == NULL || scores_strings == NULL
+      || order_strings == NULL || order_text_data == NULL)
+    {
+      return FALSE;
+    }
+  for (i = 0; i < KEYSTROKE_NUM_OF_LINES * KEYSTOKE_NUM_OF_COLS; i++)
+    {
+      order_text_data[i] = ' ';
+    }
+  return TRUE;
 }
 
 /**
@@ -242,17 +286,33 @@ about_load_text (void)
     }
   strings_count += 3;
 
-  about_text_data = memory_allocation (filesize);
+  /* the arena also holds the tables of the other sections */
+  if (!arena_create (&menu_arena, "menu",
+                     ARENA_SIZE (filesize) +
+                     ARENA_SIZE (strings_count * sizeof (char *)) +
+                     ARENA_SIZE (SCORE_TABLE_SIZE *
+                                 sizeof (sprite_char_struct *)) +
+                     ARENA_SIZE (MAX_OF_HIGH_SCORES * 2 *
+                                 sizeof (sprite_string_struct *)) +
+                     ARENA_SIZE (KEYSTROKE_NUM_OF_LINES *
+                                 sizeof (sprite_string_struct *)) +
+                     ARENA_SIZE (KEYSTROKE_NUM_OF_LINES *
+                                 KEYSTOKE_NUM_OF_COLS)))
+    {
+      free_file (filedata);
+      return FALSE;
+    }
+  about_text_data = arena_alloc (&menu_arena, filesize);
   if (about_text_data == NULL)
     {
-      free_memory (filedata);
+      free_file (filedata);
       return FALSE;
     }
   about_strings_list =
-    (char **) memory_allocation (strings_count * sizeof (char *));
+    (char **) arena_alloc (&menu_arena, strings_count * sizeof (char *));
   if (about_strings_list == NULL)
     {
-      free_memory (filedata);
+      free_file (filedata);
       return FALSE;
     }
 
@@ -313,7 +373,7 @@ about_load_text (void)
   about_text_data[chars_index++] = '\0';
 
   /* release file was loaded in memory */
-  free_memory (filedata);
+  free_file (filedata);
   return TRUE;
 }
 
@@ -323,16 +383,9 @@ about_load_text (void)
 static void
 about_release_memory ()
 {
-  if (about_strings_list != NULL)
-    {
-      free_memory ((char *) about_strings_list);
-      about_strings_list = NULL;
-    }
-  if (about_text_data != NULL)
-    {
-      free_memory (about_text_data);
-      about_text_data = NULL;
-    }
+  /* the text is released with the menu arena */
+  about_strings_list = NULL;
+  about_text_data = NULL;
 }
 
 /**
@@ -481,18 +534,6 @@ destroy (void)
           sprites_string_delete (scores_strings[i]);
           scores_strings[i] = NULL;
         }
-      free_memory ((char *) scores_strings);
-    }
-  if (scores_chars_sprites != NULL)
-    {
-      free_memory ((char *) scores_chars_sprites);
-      scores_chars_sprites = NULL;
-    }
-
-  if (order_text_data != NULL)
-    {
-      free_memory (order_text_data);
-      order_text_data = NULL;
     }
   if (order_strings != NULL)
     {
@@ -505,8 +546,12 @@ destroy (void)
           sprites_string_delete (order_strings[i]);
           order_strings[i] = NULL;
         }
-      free_memory ((char *) order_strings);
     }
+  /* the tables are released with the menu arena */
+  scores_strings = NULL;
+  scores_chars_sprites = NULL;
+  order_strings = NULL;
+  order_text_data = NULL;
 }
 
 /**
@@ -568,33 +613,6 @@ high_scores_initialize ()
   Uint32 str_index = 0;
   Uint32 char_index = 0;
 
-  if (scores_chars_sprites == NULL)
-    {
-      scores_chars_sprites =
-        (sprite_char_struct **) memory_allocation (SCORE_TABLE_SIZE *
-                                                   sizeof (sprite_char_struct
-                                                           **));
-      if (scores_chars_sprites == NULL)
-        {
-          LOG_ERR ("allocation of 'scores_chars_sprites' failed!");
-          return FALSE;
-        }
-    }
-
-  if (scores_strings == NULL)
-    {
-      scores_strings =
-        (sprite_string_struct **) memory_allocation (MAX_OF_HIGH_SCORES * 2 *
-                                                     sizeof
-                                                     (sprite_string_struct
-                                                      **));
-      if (scores_strings == NULL)
-        {
-          LOG_ERR ("allocation of 'scores_strings' failed!");
-          return FALSE;
-        }
-    }
-
   /* convert the characters of players names strings to sprites */
   for (i = 0; i < MAX_OF_HIGH_SCORES; i++, str_index++)
     {
@@ -1403,37 +1421,7 @@ order_initialize (void)
   char *str;
   Sint32 ycoord;
   Uint32 i;
-  if (order_strings == NULL)
-    {
-      order_strings =
-        (sprite_string_struct **) memory_allocation (KEYSTROKE_NUM_OF_LINES *
-                                                     sizeof
-                                                     (sprite_string_struct
-                                                      **));
-      if (order_strings == NULL)
-        {
-          LOG_ERR ("allocation of 'order_strings' failed!");
-          return FALSE;
-        }
-    }
 
-  /* allocate buffer of chars */
-  if (order_text_data == NULL)
-    {
-      order_text_data =
-        memory_allocation (KEYSTROKE_NUM_OF_LINES * KEYSTOKE_NUM_OF_COLS);
-      if (order_text_data == NULL)
-        {
-          LOG_ERR ("not enough memory to allocate %i bytes!",
-                   KEYSTROKE_NUM_OF_LINES * KEYSTOKE_NUM_OF_COLS);
-          return FALSE;
-        }
-      str = order_text_data;
-      for (i = 0; i < KEYSTROKE_NUM_OF_LINES * KEYSTOKE_NUM_OF_COLS; i++)
-        {
-          str[i] = ' ';
-        }
-    }
   ycoord = 128 + 7;
 
   str = order_text_data;
@@ -1955,7 +1943,7 @@ order_load_textdata ()
 
         }
     }
-  free_memory (filedata);
+  free_file (filedata);
   return TRUE;
 }
 
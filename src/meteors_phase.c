@@ -27,7 +27,9 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "tools.h"
+#include "arena.h"
 #include "images.h"
+#include "assets_segment.h"
 #include "config_file.h"
 #include "curve_phase.h"
 #include "display.h"
@@ -186,6 +188,7 @@ meteors_handle (void)
 bool
 meteors_finished (void)
 {
+  Sint32 guard_num = 0;
   /* meteors phase currently in progress? */
   if (!meteor_activity)
     {
@@ -202,37 +205,37 @@ meteors_finished (void)
           switch (num_level)
             {
             case 3:
-              guardian_new (1);
+              guard_num = 1;
               break;
             case 7:
-              guardian_new (2);
+              guard_num = 2;
               break;
             case 11:
-              guardian_new (3);
+              guard_num = 3;
               break;
             case 15:
-              guardian_new (4);
+              guard_num = 4;
               break;
             case 19:
-              guardian_new (5);
+              guard_num = 5;
               break;
             case 23:
-              guardian_new (6);
+              guard_num = 6;
               break;
             case 27:
-              guardian_new (7);
+              guard_num = 7;
               break;
             case 31:
-              guardian_new (8);
+              guard_num = 8;
               break;
             case 35:
-              guardian_new (9);
+              guard_num = 9;
               break;
             case 39:
-              guardian_new (10);
+              guard_num = 10;
               break;
             case 41:
-              guardian_new (11);
+              guard_num = 11;
               break;
             default:
               if (!next_level_without_guardian ())
@@ -241,6 +244,15 @@ meteors_finished (void)
                 }
               break;
             }
+          if (guard_num > 0)
+            {
+              /* swap in the guardian prefetched at the level start */
+              if (!guardian_load (guard_num))
+                {
+                  return FALSE;
+                }
+              guardian_new (guard_num);
+            }
         }
     }
 
@@ -256,11 +268,8 @@ meteors_finished (void)
             {
               num_level = 0;
             }
-          /* load first guardian */
-          if (!guardian_load (1))
-            {
-              return FALSE;
-            }
+          /* load first guardian in the background */
+          guardian_prefetch (1);
           /* load grid phase */
           if (!grid_load (num_level))
             {
@@ -298,12 +307,12 @@ meteors_images_free (void)
         {
           if (meteor_images[i][j].img != NULL)
             {
-              free_memory (meteor_images[i][j].img);
+              assets_free (meteor_images[i][j].img);
               meteor_images[i][j].img = NULL;
             }
           if (meteor_images[i][j].compress != NULL)
             {
-              free_memory (meteor_images[i][j].compress);
+              assets_free (meteor_images[i][j].compress);
               meteor_images[i][j].compress = NULL;
             }
         }
@@ -319,13 +328,17 @@ bool
 meteors_load (Sint32 num_meteor)
 {
   char *file, *data;
+  Uint32 mark;
   meteors_images_free ();
   if (num_meteor > MAX_NUM_OF_LEVELS || num_meteor < 0)
     {
       num_meteor = 0;
     }
+  mark = arena_mark (&frame_arena);
   file =
-    loadfile_num ("graphics/sprites/meteors/meteor_%02d.spr", num_meteor);
+    loadfile_num_into_arena (&frame_arena,
+                             "graphics/sprites/meteors/meteor_%02d.spr",
+                             num_meteor);
   if (file == NULL)
     {
       return FALSE;
@@ -333,7 +346,7 @@ meteors_load (Sint32 num_meteor)
   data =
     images_read (&meteor_images[0][0], METEOR_MAXOF_TYPES,
                  METEOR_NUMOF_IMAGES, file, METEOR_NUMOF_IMAGES);
-  free_memory (file);
+  arena_release (&frame_arena, mark);
   if (data == NULL)
     {
       return FALSE;
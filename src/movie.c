@@ -27,33 +27,56 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "tools.h"
+#include "archive.h"
 #include "assembler.h"
 #include "tools.h"
 #include "config_file.h"
 #include "display.h"
 #include "log_recorder.h"
 #include "movie.h"
+#include "profiler.h"
+#include <sys/mman.h>
+
+/** Size in bytes of a frame of the movies, 320x200 pixels */
+#define MOVIE_FRAME_SIZE 64000
 
 /** Wich movie si played: 1=intro or 2=congratulation */
 Uint32 movie_playing_switch = MOVIE_INTRODUCTION;
 /** Pointer to the buffer for the current animation movie */
 unsigned char *movie_buffer = NULL;
+/** Frame decoded ahead while the current one is shown */
 static unsigned char *image2 = NULL;
-static unsigned char *icmpr = NULL;
+/** Compressed data of the frame decoded ahead, NULL if corrupted */
+static const unsigned char *icmpr = NULL;
 static unsigned char *smage1 = NULL;
 static unsigned char *smage2 = NULL;
-static unsigned char *scmpr = NULL;
-/** Pointer to the filedata of the movie in memory */
-static unsigned char *movie_filedata = NULL;
-/* pointer to the colormap in the file */
+/** Pointer to the filedata of the movie, in the archive mapping
+ * or in a mapping of the movie file */
+static const unsigned char *movie_filedata = NULL;
+static Uint32 movie_filesize = 0;
+/** TRUE if the movie file was mapped by movie_map() */
+static bool movie_is_mapped = FALSE;
 static Sint32 movie_counter = 0;
 static Sint32 images = 0;
+/** Thread which decodes the next frame, NULL if the frames are
+ * decoded by the main thread */
+static SDL_Thread *movie_decoder = NULL;
+static SDL_sem *decode_request = NULL;
+static SDL_sem *decode_done = NULL;
+/** TRUE if a frame is being decoded by the thread */
+static bool decode_pending = FALSE;
+/** TRUE if the thread must exit */
+static bool decode_quit = FALSE;
 
 static bool movie_initialize (const char *filename);
 static bool movie_load (const char *filename);
 static bool movie_play (void);
-static unsigned char *decompress (unsigned char *, unsigned char *,
-                                  unsigned char *);
+static void movie_decoder_start (void);
+static void movie_decoder_stop (void);
+static void movie_decode_next (void);
+static const unsigned char *decompress (const unsigned char *,
+                                        const unsigned char *,
+                                        unsigned char *);
 
 /**
  * Play movie animation compressed
@@ -108,6 +131,7 @@ movie_player (void)
   return TRUE;
 }
 
+
 /**
  * Initialize an animation file, allocate buffers and create offscreen
  * @param filename: the file which should be loaded.
@@ -116,31 +140,21 @@ movie_player (void)
 static bool
 movie_initialize (const char *filename)
 {
-  Sint32 i = 0;
-  smage1 = smage2 = scmpr = NULL;
-  smage1 = ((unsigned char *) memory_allocation (64000));
+  smage1 = smage2 = NULL;
+  smage1 = ((unsigned char *) memory_allocation (MOVIE_FRAME_SIZE));
   if (smage1 == NULL)
     {
       LOG_ERR ("not enough memory to allocate 'smage1'");
       return FALSE;
     }
-  smage2 = ((unsigned char *) memory_allocation (64000));
-  if (smage1 == NULL)
+  smage2 = ((unsigned char *) memory_allocation (MOVIE_FRAME_SIZE));
+  if (smage2 == NULL)
     {
       LOG_ERR ("not enough memory to allocate 'smage2'");
       return FALSE;
     }
-  movie_filedata = ((unsigned char *) memory_allocation ((1024 * 1024 * 4)));
-  if (movie_filedata == NULL)
-    {
-      LOG_ERR ("not enough memory to allocate 'movie_filedata'");
-      return FALSE;
-    }
-  for (i = 0; i < 64000; i++)
-    {
-      smage1[i] = 0;
-      smage2[i] = 0;
-    }
+  memset (smage1, 0, MOVIE_FRAME_SIZE);
+  memset (smage2, 0, MOVIE_FRAME_SIZE);
   if (!movie_load (filename))
     {
       LOG_ERR ("movie_load(%s) failed!", filename);
@@ -148,13 +162,18 @@ movie_initialize (const char *filename)
     }
   movie_buffer = smage1;
   image2 = smage2;
-  icmpr = scmpr;
   movie_counter = 0;
   if (!create_movie_offscreen ())
     {
       LOG_ERR ("create_movie_buffer() failed!");
       return FALSE;
     }
+  /* the first frame is decoded while the game loop waits */
+  movie_decoder_start ();
+  if (images - 1 > 1)
+    {
+      movie_decode_next ();
+    }
   return TRUE;
 }
 
@@ -164,6 +183,7 @@ movie_initialize (const char *filename)
 void
 movie_free (void)
 {
+  movie_decoder_stop ();
   if (smage1 != NULL)
     {
       free_memory ((char *) smage1);
@@ -174,11 +194,13 @@ movie_free (void)
       free_memory ((char *) smage2);
       smage2 = NULL;
     }
-  if (movie_filedata != NULL)
+  if (movie_is_mapped)
     {
-      free_memory ((char *) movie_filedata);
-      movie_filedata = NULL;
+      munmap ((void *) movie_filedata, movie_filesize);
+      movie_is_mapped = FALSE;
     }
+  movie_filedata = NULL;
+  icmpr = NULL;
   if (pal16PlayAnim != NULL)
     {
       free_memory ((char *) pal16PlayAnim);
@@ -192,6 +214,63 @@ movie_free (void)
   destroy_movie_offscreen ();
 }
 
+/**
+ * Map an animation file rather than loading it, the frames are read
+ * once and in order
+ * @param filename: the file which should be mapped.
+ * @return boolean value on success or failure
+ */
+static bool
+movie_map (const char *filename)
+{
+  char *pathname;
+  int fd;
+  struct stat sb;
+  void *map;
+  movie_filedata =
+    (const unsigned char *) archive_find (filename, &movie_filesize);
+  if (movie_filedata != NULL)
+    {
+      return TRUE;
+    }
+  pathname = locate_data_file (filename);
+  if (pathname == NULL)
+    {
+      LOG_ERR ("can't locate file %s", filename);
+      return FALSE;
+    }
+  fd = open (pathname, O_RDONLY);
+  if (fd < 0)
+    {
+      LOG_ERR ("can't open %s (%s)", pathname, strerror (errno));
+      free_memory (pathname);
+      return FALSE;
+    }
+  if (fstat (fd, &sb) || sb.st_size < 4 + 768)
+    {
+      close (fd);
+      LOG_ERR ("%s is not a valid movie", pathname);
+      free_memory (pathname);
+      return FALSE;
+    }
+  map = mmap (NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      LOG_ERR ("mmap(%s) failed: %s", pathname, strerror (errno));
+      free_memory (pathname);
+      return FALSE;
+    }
+  free_memory (pathname);
+#ifdef MADV_SEQUENTIAL
+  madvise (map, sb.st_size, MADV_SEQUENTIAL);
+#endif
+  movie_filedata = (const unsigned char *) map;
+  movie_filesize = sb.st_size;
+  movie_is_mapped = TRUE;
+  return TRUE;
+}
+
 /**
  * Load an animation file and convert colors palette
  * @param filename: the file which should be loaded.
@@ -200,17 +279,20 @@ movie_free (void)
 static bool
 movie_load (const char *filename)
 {
-  Sint32 i, *ptr32;
-  unsigned char *_p8, *_p, *_pPal, *pcxpal;
-  if (!loadfile_into_buffer (filename, (char *) movie_filedata))
+  Sint32 i;
+  unsigned char *_p, *_pPal, *pcxpal;
+  if (!movie_map (filename))
     {
       return FALSE;
     }
-  ptr32 = (Sint32 *) movie_filedata;
-  images = little_endian_to_int (ptr32++);
-  _p8 = (unsigned char *) ptr32;
-  pcxpal = _p8;
-  scmpr = _p8 + 768;
+  if (movie_filesize < 4 + 768)
+    {
+      LOG_ERR ("%s is not a valid movie", filename);
+      return FALSE;
+    }
+  images = little_endian_to_int ((Sint32 *) movie_filedata);
+  pcxpal = (unsigned char *) movie_filedata + 4;
+  icmpr = pcxpal + 768;
   if (bytes_per_pixel == 2)
     {
       if (pal16PlayAnim == NULL)
@@ -268,49 +350,226 @@ movie_play (void)
   /* images = 64 + 16 + 2 + 1 + 1 */
   unsigned char *tmp;
   movie_counter++;
-  if (movie_counter == images - 1)
+  if (movie_counter >= images - 1)
+    {
+      return FALSE;
+    }
+  if (decode_pending)
+    {
+      SDL_SemWait (decode_done);
+      decode_pending = FALSE;
+    }
+  if (icmpr == NULL)
     {
+      LOG_ERR ("frame %i of the movie is corrupted", movie_counter);
       return FALSE;
     }
-  icmpr = decompress (icmpr, movie_buffer, image2);
   tmp = movie_buffer;
   movie_buffer = image2;
   image2 = tmp;
+  /* decode the next frame while this one is shown */
+  if (movie_counter + 1 < images - 1)
+    {
+      movie_decode_next ();
+    }
   return TRUE;
 }
 
-/*
- *
+/**
+ * Thread which decodes the frames ahead, one frame per request
+ * @param unused Not used
+ * @return Always 0
+ */
+static int
+movie_decode_ahead (void *unused)
+{
+  (void) unused;
+  for (;;)
+    {
+      SDL_SemWait (decode_request);
+      if (decode_quit)
+        {
+          break;
+        }
+      icmpr = decompress (icmpr, movie_buffer, image2);
+      SDL_SemPost (decode_done);
+    }
+  return 0;
+}
+
+/**
+ * Start the thread which decodes the frames ahead, the frames are
+ * decoded by the main thread if it can't be started
+ */
+static void
+movie_decoder_start (void)
+{
+  decode_pending = FALSE;
+  decode_quit = FALSE;
+  decode_request = SDL_CreateSemaphore (0);
+  decode_done = SDL_CreateSemaphore (0);
+  if (decode_request != NULL && decode_done != NULL)
+    {
+      movie_decoder = SDL_CreateThread (movie_decode_ahead, "movie", NULL);
+      if (movie_decoder != NULL)
+        {
+          return;
+        }
+    }
+  LOG_WARN ("the frames are not decoded ahead: %s", SDL_GetError ());
+  movie_decoder_stop ();
+}
+
+/**
+ * Stop the thread which decodes the frames ahead
+ */
+static void
+movie_decoder_stop (void)
+{
+  if (movie_decoder != NULL)
+    {
+      if (decode_pending)
+        {
+          SDL_SemWait (decode_done);
+          decode_pending = FALSE;
+        }
+      decode_quit = TRUE;
+      SDL_SemPost (decode_request);
+      SDL_WaitThread (movie_decoder, NULL);
+      movie_decoder = NULL;
+    }
+  if (decode_request != NULL)
+    {
+      SDL_DestroySemaphore (decode_request);
+      decode_request = NULL;
+    }
+  if (decode_done != NULL)
+    {
+      SDL_DestroySemaphore (decode_done);
+      decode_done = NULL;
+    }
+}
+
+/**
+ * Decode the frame which follows the one shown into the other buffer,
+ * it still holds the frame before the one shown
+ */
+static void
+movie_decode_next (void)
+{
+  if (movie_decoder != NULL)
+    {
+      decode_pending = TRUE;
+      SDL_SemPost (decode_request);
+    }
+  else
+    {
+      /* the profiler only times the game thread */
+      PROFILER_BEGIN (PROFILER_DECOMPRESS);
+      icmpr = decompress (icmpr, movie_buffer, image2);
+      PROFILER_END ();
+    }
+}
+
+/**
+ * Return the size of an operation of the compressed data
+ * @param c First byte of the operation
+ * @return Size of the operation in bytes
+ */
+static Sint32
+decompress_op_size (unsigned char c)
+{
+  if (c == 255 || (c & 0xe0) == 0x80)
+    {
+      return 2;
+    }
+  if ((c & 0xc0) == 0 || (c & 0xe0) == 0xa0)
+    {
+      return 3;
+    }
+  if ((c & 0xc0) == 0x40 || (c & 0xe0) == 0xc0)
+    {
+      return 4;
+    }
+  return 1;
+}
+
+/**
+ * Copy bytes inside the frame being decoded. The encoder expects them
+ * copied one after the other: when the source is just behind the
+ * destination, the bytes already copied are repeated
+ * @param dest Pointer to the destination
+ * @param src Pointer to the source, in the same frame
+ * @param length Number of bytes to copy
+ */
+static void
+decompress_copy_forward (unsigned char *dest, const unsigned char *src,
+                         Sint32 length)
+{
+  Sint32 size;
+  if (src >= dest || dest - src >= length)
+    {
+      memmove (dest, src, length);
+      return;
+    }
+  if (dest - src == 1)
+    {
+      memset (dest, *src, length);
+      return;
+    }
+  /* the source stays in place, the size of the
+   * pattern copied at once doubles each time */
+  while (length > 0)
+    {
+      size = dest - src < length ? dest - src : length;
+      memcpy (dest, src, size);
+      dest += size;
+      length -= size;
+    }
+}
+
+/**
+ * Decode a frame
+ * @param wsc Pointer to the compressed data of the frame
+ * @param im1 Pointer to the previous frame
+ * @param im2 Pointer to the frame to decode, it holds the frame
+ *            before the previous one
+ * @return Pointer to the compressed data of the next frame,
+ *         NULL if the compressed data are corrupted
  */
-static unsigned char *
-decompress (unsigned char *wsc, unsigned char *im1, unsigned char *im2)
+static const unsigned char *
+decompress (const unsigned char *wsc, const unsigned char *im1,
+            unsigned char *im2)
 {
-  Sint32 i, j, mode;
+  Sint32 i, mode;
   Uint32 wr;
   unsigned char *idec;
-  unsigned char *wdec;
   unsigned char c;
-  unsigned char color;
+  const unsigned char *wsc_end = movie_filedata + movie_filesize;
   Sint32 length = 0;
   Sint32 retour = 0;
   Sint32 position = 0;
   i = 0;
   idec = im2;
-  while (i < 64000)
+  while (i < MOVIE_FRAME_SIZE)
     {
       mode = 0;
+      /* the data are mapped, never read past their end */
+      if (wsc_end - wsc < 4
+          && (wsc >= wsc_end || wsc_end - wsc < decompress_op_size (*wsc)))
+        {
+          return NULL;
+        }
       /* read a byte */
       c = *wsc++;
       if (c == 255)
         {
-          color = *wsc++;
-          *idec++ = color;
+          *idec++ = *wsc++;
           i++;
           mode = 0;
         }
       else if ((c & 0xc0) == 0)
         {
-          wr = 0;
           wr = c << 16;
           wr += (*wsc++) << 8;
           wr += *wsc++;
@@ -320,7 +579,6 @@ decompress (unsigned char *wsc, unsigned char *im1, unsigned char *im2)
         }
       else if ((c & 0xc0) == 0x40)
         {
-          wr = 0;
           wr = c << 24;
           wr += (*wsc++) << 16;
           wr += (*wsc++) << 8;
@@ -331,7 +589,6 @@ decompress (unsigned char *wsc, unsigned char *im1, unsigned char *im2)
         }
       else if ((c & 0xe0) == 0x80)
         {
-          wr = 0;
           wr = c << 8;
           wr += *wsc++;
           length = wr & 63;
@@ -340,7 +597,6 @@ decompress (unsigned char *wsc, unsigned char *im1, unsigned char *im2)
         }
       else if ((c & 0xe0) == 0xa0)
         {
-          wr = 0;
           wr = c << 16;
           wr += (*wsc++) << 8;
           wr += *wsc++;
@@ -350,7 +606,6 @@ decompress (unsigned char *wsc, unsigned char *im1, unsigned char *im2)
         }
       else if ((c & 0xe0) == 0xc0)
         {
-          wr = 0;
           wr = c << 24;
           wr += (*wsc++) << 16;
           wr += (*wsc++) << 8;
@@ -359,33 +614,41 @@ decompress (unsigned char *wsc, unsigned char *im1, unsigned char *im2)
           position = (wr >> 13) & 65535;
           mode = 3;
         }
-      if (i + length > 64000)
+      if (i + length > MOVIE_FRAME_SIZE)
         {
-          length = 64000 - i;
+          length = MOVIE_FRAME_SIZE - i;
         }
       if (mode == 1)
         {
-          for (j = 0; j < length; j++)
+          /* bytes of the previous frame */
+          if (position + length > MOVIE_FRAME_SIZE)
             {
-              *idec++ = im1[position + j];
+              return NULL;
             }
+          memcpy (idec, im1 + position, length);
+          idec += length;
           i += length;
         }
       else if (mode == 2)
         {
-          wdec = idec - retour;
-          for (j = 0; j < length; j++)
+          /* bytes just decoded */
+          if (retour > i)
             {
-              *idec++ = *wdec++;
+              return NULL;
             }
+          decompress_copy_forward (idec, idec - retour, length);
+          idec += length;
           i += length;
         }
       else if (mode == 3)
         {
-          for (j = 0; j < length; j++)
+          /* bytes of the frame being decoded */
+          if (position + length > MOVIE_FRAME_SIZE)
             {
-              *idec++ = im2[position + j];
+              return NULL;
             }
+          decompress_copy_forward (idec, im2 + position, length);
+          idec += length;
           i += length;
         }
     }
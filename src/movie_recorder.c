@@ -0,0 +1,509 @@
+/**
+ * @file movie_recorder.c
+ * @brief Record the game into a movie file the movie player can play
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: movie_recorder.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "display.h"
+#include "log_recorder.h"
+#include "movie_recorder.h"
+
+/*
+ * A movie file starts with the number of frames plus 2 and the 256
+ * RGB colors of the palette. Each frame is a list of operations which
+ * rebuild its 8-bit pixels, see decompress() in movie.c:
+ *   11111111 cccccccc                  one pixel of color c
+ *   00pppppp pppppppp ppllllll         l pixels of the previous frame
+ *   01pppppp pppppppp ppllllll llllllll  from the position p
+ *   100ddddd ddllllll                  l pixels of the frame being
+ *   101ddddd dddddddd llllllll         decoded, d pixels behind
+ */
+
+/** Size in bytes of a frame of the movie */
+#define RECORDER_FRAME_SIZE (MOVIE_RECORDER_WIDTH * MOVIE_RECORDER_HEIGHT)
+/** Number of frames the queue holds, a power of 2 */
+#define RECORDER_QUEUE_SIZE 8
+/** Size of the table which gives the color of a pixel, a power of 2 */
+#define RECORDER_COLORS_SIZE 1024
+
+static FILE *recorder_file = NULL;
+static const char *recorder_filename = NULL;
+static SDL_Thread *recorder_thread = NULL;
+/** Frames copied by the game thread, then encoded by the recorder
+ * thread. The queue is lock-free: each counter is only written by
+ * one of the threads */
+static char *recorder_queue[RECORDER_QUEUE_SIZE];
+/** Number of frames pushed by the game thread */
+static SDL_atomic_t queue_head;
+/** Number of frames taken by the recorder thread */
+static SDL_atomic_t queue_tail;
+/** Posted for each frame pushed, and once to stop the thread */
+static SDL_sem *queue_posted = NULL;
+/** Number of bytes per pixel of the frames copied */
+static Uint32 recorder_depth = 0;
+/** Pixel values of the palette colors and their indexes, -1 if free */
+static Uint32 colors_pixels[RECORDER_COLORS_SIZE];
+static Sint32 colors_indexes[RECORDER_COLORS_SIZE];
+/** 8-bit frames of the recorder thread, the previous one and the
+ * one being encoded */
+static unsigned char *frame_previous = NULL;
+static unsigned char *frame_current = NULL;
+/** Operations of the frame being encoded, at most 2 bytes per pixel */
+static unsigned char *frame_encoded = NULL;
+static Uint32 frames_recorded = 0;
+static Uint32 frames_dropped = 0;
+/** Accumulates MOVIE_FRAME_RATE for each frame of the game,
+ * a frame is kept each time it reaches GAME_FRAME_RATE */
+static Uint32 frames_phase = 0;
+static Uint32 pixels_unknown = 0;
+static bool recorder_failed = FALSE;
+
+/**
+ * Return the slot of a pixel value in the table of the colors
+ * @param pixel Pixel value
+ * @return Index of the slot holding the pixel value, or of the free
+ *         slot where it can be added
+ */
+static Uint32
+recorder_color_slot (Uint32 pixel)
+{
+  Uint32 slot = (pixel * 2654435761U) >> 22;
+  while (colors_indexes[slot] >= 0 && colors_pixels[slot] != pixel)
+    {
+      slot = (slot + 1) & (RECORDER_COLORS_SIZE - 1);
+    }
+  return slot;
+}
+
+/**
+ * Convert a frame copied from the screen into 8-bit pixels
+ * @param pixels Pointer to the pixels copied, at recorder_depth
+ * @param dest Pointer to the 8-bit frame
+ */
+static void
+recorder_convert (const char *pixels, unsigned char *dest)
+{
+  Uint32 i, pixel, last_pixel = 0;
+  Sint32 index = -1;
+  const Uint8 *src = (const Uint8 *) pixels;
+  if (recorder_depth == 1)
+    {
+      memcpy (dest, pixels, RECORDER_FRAME_SIZE);
+      return;
+    }
+  for (i = 0; i < RECORDER_FRAME_SIZE; i++, src += recorder_depth)
+    {
+      switch (recorder_depth)
+        {
+        case 2:
+          pixel = *(const Uint16 *) src;
+          break;
+        case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+          pixel = (src[0] << 16) | (src[1] << 8) | src[2];
+#else
+          pixel = src[0] | (src[1] << 8) | (src[2] << 16);
+#endif
+          break;
+        default:
+          pixel = *(const Uint32 *) src;
+          break;
+        }
+      /* the pixels of a row often have the same color */
+      if (index < 0 || pixel != last_pixel)
+        {
+          index = colors_indexes[recorder_color_slot (pixel)];
+          if (index < 0)
+            {
+              pixels_unknown++;
+              index = 0;
+            }
+          last_pixel = pixel;
+        }
+      dest[i] = index;
+    }
+}
+
+/**
+ * Count the identical bytes at the start of two buffers
+ * @param a Pointer to the first buffer
+ * @param b Pointer to the second buffer
+ * @param max Maximum number of bytes to compare
+ * @return Number of identical bytes
+ */
+static Sint32
+recorder_run (const unsigned char *a, const unsigned char *b, Sint32 max)
+{
+  Sint32 n = 0;
+  while (n < max && a[n] == b[n])
+    {
+      n++;
+    }
+  return n;
+}
+
+/**
+ * Encode a frame, each operation is chosen for the longest run of
+ * pixels it can copy: from the previous frame at the same position,
+ * or from the pixels just decoded on the left or above
+ * @param cur Pointer to the 8-bit frame to encode
+ * @param prev Pointer to the previous 8-bit frame
+ * @param out Pointer to the buffer which receives the operations
+ * @return Size of the encoded frame in bytes
+ */
+static Uint32
+recorder_encode (const unsigned char *cur, const unsigned char *prev,
+                 unsigned char *out)
+{
+  static const Sint32 distances[] = { 1, 2, MOVIE_RECORDER_WIDTH };
+  Sint32 i, j, n, length, distance, max;
+  Uint32 wr;
+  unsigned char *w = out;
+  i = 0;
+  while (i < RECORDER_FRAME_SIZE)
+    {
+      max = RECORDER_FRAME_SIZE - i;
+      length = recorder_run (cur + i, prev + i, max < 16383 ? max : 16383);
+      distance = 0;
+      for (j = 0; j < (Sint32) (sizeof (distances) / sizeof (Sint32)); j++)
+        {
+          if (distances[j] > i)
+            {
+              break;
+            }
+          n = recorder_run (cur + i, cur + i - distances[j],
+                            max < 255 ? max : 255);
+          if (n > length)
+            {
+              length = n;
+              distance = distances[j];
+            }
+        }
+      if (length >= 2 && distance == 0)
+        {
+          /* copy from the previous frame */
+          if (length < 64)
+            {
+              wr = (i << 6) | length;
+              *w++ = wr >> 16;
+              *w++ = wr >> 8;
+              *w++ = wr;
+            }
+          else
+            {
+              wr = 0x40000000 | (i << 14) | length;
+              *w++ = wr >> 24;
+              *w++ = wr >> 16;
+              *w++ = wr >> 8;
+              *w++ = wr;
+            }
+        }
+      else if (length >= 2)
+        {
+          /* copy from the pixels just decoded */
+          if (distance < 128 && length < 64)
+            {
+              wr = 0x8000 | (distance << 6) | length;
+              *w++ = wr >> 8;
+              *w++ = wr;
+            }
+          else
+            {
+              wr = 0xa00000 | (distance << 8) | length;
+              *w++ = wr >> 16;
+              *w++ = wr >> 8;
+              *w++ = wr;
+            }
+        }
+      else
+        {
+          *w++ = 255;
+          *w++ = cur[i];
+          length = 1;
+        }
+      i += length;
+    }
+  return w - out;
+}
+
+/**
+ * Thread which converts and encodes the frames of the queue
+ * @param unused Not used
+ * @return Always 0
+ */
+static int
+recorder_encoder (void *unused)
+{
+  Uint32 tail, size;
+  unsigned char *frame;
+  (void) unused;
+  for (;;)
+    {
+      SDL_SemWait (queue_posted);
+      tail = SDL_AtomicGet (&queue_tail);
+      if (tail == (Uint32) SDL_AtomicGet (&queue_head))
+        {
+          /* posted by movie_recorder_close() once the queue is empty */
+          break;
+        }
+      recorder_convert (recorder_queue[tail & (RECORDER_QUEUE_SIZE - 1)],
+                        frame_current);
+      /* the game thread can fill the slot again */
+      SDL_AtomicSet (&queue_tail, tail + 1);
+      if (recorder_failed)
+        {
+          continue;
+        }
+      size = recorder_encode (frame_current, frame_previous, frame_encoded);
+      if (fwrite (frame_encoded, 1, size, recorder_file) != size)
+        {
+          LOG_ERR ("fwrite(%s) failed: %s", recorder_filename,
+                   strerror (errno));
+          recorder_failed = TRUE;
+          continue;
+        }
+      frames_recorded++;
+      frame = frame_previous;
+      frame_previous = frame_current;
+      frame_current = frame;
+    }
+  return 0;
+}
+
+/**
+ * Release the resources of the recorder
+ */
+static void
+recorder_free (void)
+{
+  Uint32 i;
+  if (queue_posted != NULL)
+    {
+      SDL_DestroySemaphore (queue_posted);
+      queue_posted = NULL;
+    }
+  if (recorder_file != NULL)
+    {
+      fclose (recorder_file);
+      recorder_file = NULL;
+    }
+  for (i = 0; i < RECORDER_QUEUE_SIZE; i++)
+    {
+      if (recorder_queue[i] != NULL)
+        {
+          free_memory (recorder_queue[i]);
+          recorder_queue[i] = NULL;
+        }
+    }
+  if (frame_previous != NULL)
+    {
+      free_memory ((char *) frame_previous);
+      frame_previous = NULL;
+    }
+  if (frame_current != NULL)
+    {
+      free_memory ((char *) frame_current);
+      frame_current = NULL;
+    }
+  if (frame_encoded != NULL)
+    {
+      free_memory ((char *) frame_encoded);
+      frame_encoded = NULL;
+    }
+}
+
+/**
+ * Start recording the frames into a movie file
+ * @param filename Filename of the movie file
+ * @param colors Pixel values of the 256 colors of the palette, in
+ *               the format of the frames, unused for 8-bit frames
+ * @param depth Number of bytes per pixel of the frames, 1 to 4
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+movie_recorder_open (const char *filename, const Uint32 * colors,
+                     Uint32 depth)
+{
+  Uint32 i, slot;
+  Sint32 num_of_frames = 0;
+  if (depth < 1 || depth > 4)
+    {
+      LOG_ERR ("%i bytes per pixel can't be recorded", depth);
+      return FALSE;
+    }
+  recorder_depth = depth;
+  recorder_filename = filename;
+  for (i = 0; i < RECORDER_COLORS_SIZE; i++)
+    {
+      colors_indexes[i] = -1;
+    }
+  if (depth > 1)
+    {
+      for (i = 0; i < 256; i++)
+        {
+          /* a pixel value shared by two colors gives the first one */
+          slot = recorder_color_slot (colors[i]);
+          if (colors_indexes[slot] < 0)
+            {
+              colors_pixels[slot] = colors[i];
+              colors_indexes[slot] = i;
+            }
+        }
+    }
+  for (i = 0; i < RECORDER_QUEUE_SIZE; i++)
+    {
+      recorder_queue[i] = memory_allocation (RECORDER_FRAME_SIZE * depth);
+      if (recorder_queue[i] == NULL)
+        {
+          LOG_ERR ("not enough memory to allocate %i bytes",
+                   RECORDER_FRAME_SIZE * depth);
+          recorder_free ();
+          return FALSE;
+        }
+    }
+  /* the movie player starts from a black frame */
+  frame_previous = (unsigned char *) memory_allocation (RECORDER_FRAME_SIZE);
+  frame_current = (unsigned char *) memory_allocation (RECORDER_FRAME_SIZE);
+  frame_encoded =
+    (unsigned char *) memory_allocation (RECORDER_FRAME_SIZE * 2);
+  if (frame_previous == NULL || frame_current == NULL
+      || frame_encoded == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate the frames");
+      recorder_free ();
+      return FALSE;
+    }
+  memset (frame_previous, 0, RECORDER_FRAME_SIZE);
+  recorder_file = fopen (filename, "wb");
+  if (recorder_file == NULL)
+    {
+      LOG_ERR ("fopen(%s) failed: %s", filename, strerror (errno));
+      recorder_free ();
+      return FALSE;
+    }
+  /* the number of frames is written once the recording is stopped */
+  if (fwrite (&num_of_frames, 1, 4, recorder_file) != 4
+      || fwrite (palette_24, 1, 768, recorder_file) != 768)
+    {
+      LOG_ERR ("fwrite(%s) failed: %s", filename, strerror (errno));
+      recorder_free ();
+      return FALSE;
+    }
+  frames_recorded = 0;
+  frames_dropped = 0;
+  /* the first frame is kept */
+  frames_phase = GAME_FRAME_RATE - MOVIE_FRAME_RATE;
+  pixels_unknown = 0;
+  recorder_failed = FALSE;
+  SDL_AtomicSet (&queue_head, 0);
+  SDL_AtomicSet (&queue_tail, 0);
+  queue_posted = SDL_CreateSemaphore (0);
+  if (queue_posted == NULL)
+    {
+      LOG_ERR ("SDL_CreateSemaphore() failed: %s", SDL_GetError ());
+      recorder_free ();
+      return FALSE;
+    }
+  recorder_thread = SDL_CreateThread (recorder_encoder, "recorder", NULL);
+  if (recorder_thread == NULL)
+    {
+      LOG_ERR ("SDL_CreateThread() failed: %s", SDL_GetError ());
+      recorder_free ();
+      return FALSE;
+    }
+  LOG_INF ("the game is recorded into \"%s\"", filename);
+  return TRUE;
+}
+
+/**
+ * Push a frame to the recorder thread, the game thread only copies it.
+ * The movies play slower than the game, 2 frames out of 5 are kept.
+ * The frame is dropped if the recorder thread is late
+ * @param pixels Pointer to the pixels of the frame
+ * @param pitch Size of a row of pixels in bytes
+ */
+void
+movie_recorder_frame (const char *pixels, Uint32 pitch)
+{
+  Uint32 head, y, row_size;
+  char *frame;
+  if (recorder_thread == NULL)
+    {
+      return;
+    }
+  frames_phase += MOVIE_FRAME_RATE;
+  if (frames_phase < GAME_FRAME_RATE)
+    {
+      return;
+    }
+  frames_phase -= GAME_FRAME_RATE;
+  head = SDL_AtomicGet (&queue_head);
+  if (head - (Uint32) SDL_AtomicGet (&queue_tail) >= RECORDER_QUEUE_SIZE)
+    {
+      frames_dropped++;
+      return;
+    }
+  frame = recorder_queue[head & (RECORDER_QUEUE_SIZE - 1)];
+  row_size = MOVIE_RECORDER_WIDTH * recorder_depth;
+  for (y = 0; y < MOVIE_RECORDER_HEIGHT; y++)
+    {
+      memcpy (frame + y * row_size, pixels + y * pitch, row_size);
+    }
+  /* the frame is published once copied */
+  SDL_AtomicSet (&queue_head, head + 1);
+  SDL_SemPost (queue_posted);
+}
+
+/**
+ * Encode the frames left in the queue, stop the recorder thread and
+ * complete the movie file
+ */
+void
+movie_recorder_close (void)
+{
+  Sint32 num_of_frames;
+  if (recorder_thread == NULL)
+    {
+      return;
+    }
+  SDL_SemPost (queue_posted);
+  SDL_WaitThread (recorder_thread, NULL);
+  recorder_thread = NULL;
+  /* the movie player shows the number of frames minus 2 */
+  int_to_little_endian (frames_recorded + 2, &num_of_frames);
+  if (!recorder_failed
+      && (fseek (recorder_file, 0, SEEK_SET) != 0
+          || fwrite (&num_of_frames, 1, 4, recorder_file) != 4))
+    {
+      LOG_ERR ("fwrite(%s) failed: %s", recorder_filename, strerror (errno));
+    }
+  LOG_INF ("%i frames recorded into \"%s\", %i dropped", frames_recorded,
+           recorder_filename, frames_dropped);
+  if (pixels_unknown > 0)
+    {
+      LOG_WARN ("%i pixels were not colors of the palette", pixels_unknown);
+    }
+  recorder_free ();
+}
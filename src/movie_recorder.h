@@ -0,0 +1,48 @@
+/**
+ * @file movie_recorder.h
+ * @brief Record the game into a movie file the movie player can play
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: movie_recorder.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __MOVIE_RECORDER__
+#define __MOVIE_RECORDER__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Width in pixels of the frames of the movies */
+#define MOVIE_RECORDER_WIDTH 320
+/** Height in pixels of the frames of the movies */
+#define MOVIE_RECORDER_HEIGHT 200
+
+  bool movie_recorder_open (const char *filename, const Uint32 * colors,
+                            Uint32 depth);
+  void movie_recorder_frame (const char *pixels, Uint32 pitch);
+  void movie_recorder_close (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
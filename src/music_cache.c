@@ -0,0 +1,480 @@
+/**
+ * @file music_cache.c
+ * @brief Render the musics modules once into loopable PCM files
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: music_cache.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "config_file.h"
+#include "log_recorder.h"
+#include "music_cache.h"
+#ifdef USE_SDLMIXER
+#ifdef HAVE_LIBXMP
+#include <xmp.h>
+#endif
+
+/*
+ * A cache file is a WAV file which SDL_mixer streams like any music:
+ *   "RIFF" chunk of type "WAVE"
+ *   "mdck" chunk: version, hash of the module and sampling rate
+ *   "fmt " chunk: signed 16-bit stereo PCM at the sampling rate
+ *   "data" chunk: the samples, from the start of the module to its end
+ *   "smpl" chunk: an infinite loop from the restart position of the
+ *                 module to the last sample
+ * The numbers are little-endian
+ */
+
+/** Version of the cache files, bumped when their content changes */
+#define MUSIC_CACHE_VERSION 1
+/** Size of the chunks which precede the samples */
+#define MUSIC_CACHE_HEADER_SIZE 64
+/** Size of the "smpl" chunk which follows the samples */
+#define MUSIC_CACHE_LOOP_SIZE 68
+/** Longest rendering in seconds, for a module which never loops */
+#define MUSIC_CACHE_MAX_SECONDS 600
+
+/** 1 once the game quits, a rendering is then abandoned */
+static SDL_atomic_t music_cache_stopped;
+
+/**
+ * Read a little-endian 32-bit integer
+ * @param bytes Pointer to the 4 bytes
+ * @return The integer value
+ */
+static Uint32
+music_cache_read_le32 (const Uint8 * bytes)
+{
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+    | ((Uint32) bytes[3] << 24);
+}
+
+/**
+ * Check if a cache file was rendered from a module at a sampling rate
+ * @param filename Filename of the cache file
+ * @param module_hash Hash of the module data
+ * @param rate Sampling rate in Hz
+ * @return TRUE if the cache file is complete and up to date
+ */
+static bool
+music_cache_is_valid (const char *filename, Uint32 module_hash, Sint32 rate)
+{
+  Uint8 header[MUSIC_CACHE_HEADER_SIZE];
+  size_t size;
+  FILE *in = fopen (filename, "rb");
+  if (in == NULL)
+    {
+      return FALSE;
+    }
+  size = fread (header, 1, MUSIC_CACHE_HEADER_SIZE, in);
+  if (size != MUSIC_CACHE_HEADER_SIZE
+      || memcmp (header, "RIFF", 4) || memcmp (header + 8, "WAVEmdck", 8)
+      || music_cache_read_le32 (header + 20) != MUSIC_CACHE_VERSION
+      || music_cache_read_le32 (header + 24) != module_hash
+      || music_cache_read_le32 (header + 28) != (Uint32) rate
+      || get_file_size (in) != music_cache_read_le32 (header + 4) + 8)
+    {
+      fclose (in);
+      return FALSE;
+    }
+  fclose (in);
+  return TRUE;
+}
+
+#ifdef HAVE_LIBXMP
+/**
+ * Write little-endian integers to a cache file
+ * @param out Stream of the cache file
+ * @param values Integers to write
+ * @param num_of_values Number of integers
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+music_cache_write_le32 (FILE * out, const Uint32 * values,
+                        Uint32 num_of_values)
+{
+  Uint32 i;
+  Uint8 bytes[4];
+  for (i = 0; i < num_of_values; i++)
+    {
+      bytes[0] = values[i] & 0xff;
+      bytes[1] = (values[i] >> 8) & 0xff;
+      bytes[2] = (values[i] >> 16) & 0xff;
+      bytes[3] = values[i] >> 24;
+      if (fwrite (bytes, 1, 4, out) != 4)
+        {
+          return FALSE;
+        }
+    }
+  return TRUE;
+}
+
+/**
+ * Write the identifier and the size of a chunk
+ * @param out Stream of the cache file
+ * @param id Four characters identifier
+ * @param size Size of the chunk content in bytes
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+music_cache_write_chunk (FILE * out, const char *id, Uint32 size)
+{
+  return fwrite (id, 1, 4, out) == 4
+    && music_cache_write_le32 (out, &size, 1);
+}
+
+/**
+ * Write the chunks which precede the samples, the sizes are written
+ * again once the module is rendered
+ * @param out Stream of the cache file
+ * @param module_hash Hash of the module data
+ * @param rate Sampling rate in Hz
+ * @param riff_size Size of the "RIFF" chunk content
+ * @param data_size Size of the samples in bytes
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+music_cache_write_header (FILE * out, Uint32 module_hash, Sint32 rate,
+                          Uint32 riff_size, Uint32 data_size)
+{
+  Uint32 check[3], format[4];
+  check[0] = MUSIC_CACHE_VERSION;
+  check[1] = module_hash;
+  check[2] = rate;
+  /* PCM format, 2 channels, rate, bytes per second,
+   * 4 bytes per frame and 16 bits per sample */
+  format[0] = 1 | (2 << 16);
+  format[1] = rate;
+  format[2] = rate * 4;
+  format[3] = 4 | (16 << 16);
+  return fseek (out, 0, SEEK_SET) == 0
+    && music_cache_write_chunk (out, "RIFF", riff_size)
+    && fwrite ("WAVE", 1, 4, out) == 4
+    && music_cache_write_chunk (out, "mdck", sizeof (check))
+    && music_cache_write_le32 (out, check, 3)
+    && music_cache_write_chunk (out, "fmt ", sizeof (format))
+    && music_cache_write_le32 (out, format, 4)
+    && music_cache_write_chunk (out, "data", data_size);
+}
+
+/**
+ * Write the loop of the music after the samples
+ * @param out Stream of the cache file
+ * @param rate Sampling rate in Hz
+ * @param loop_start First frame of the loop
+ * @param loop_end Last frame of the loop
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+music_cache_write_loop (FILE * out, Sint32 rate, Uint32 loop_start,
+                        Uint32 loop_end)
+{
+  Uint32 sampler[15];
+  memset (sampler, 0, sizeof (sampler));
+  /* sample period in nanoseconds, MIDI unity note and one loop */
+  sampler[2] = 1000000000 / rate;
+  sampler[3] = 60;
+  sampler[7] = 1;
+  /* forward loop played forever */
+  sampler[11] = loop_start;
+  sampler[12] = loop_end;
+  return music_cache_write_chunk (out, "smpl", sizeof (sampler))
+    && music_cache_write_le32 (out, sampler, 15);
+}
+
+/**
+ * Play a module until it loops and write its samples to a file
+ * @param out Stream of the cache file, the samples are written after
+ *            the header
+ * @param module_name Filename of the module, used in the messages
+ * @param ctx Context of the player, the module is loaded
+ * @param rate Sampling rate in Hz
+ * @param data_size Pointer to the size of the samples in bytes
+ * @param loop_start Pointer to the first frame of the loop
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+music_cache_play (FILE * out, const char *module_name, xmp_context ctx,
+                  Sint32 rate, Uint32 * data_size, Uint32 * loop_start)
+{
+  struct xmp_module_info module_info;
+  struct xmp_frame_info frame_info;
+  Uint32 *row_frames, num_of_rows, row_index, max_size;
+  Sint16 *samples;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+  Sint32 i;
+#endif
+  if (xmp_start_player (ctx, rate, 0) < 0)
+    {
+      LOG_ERR ("xmp_start_player(%s) failed", module_name);
+      return FALSE;
+    }
+  /* first frame of each row of each position, the loop starts
+   * at the row where the player restarts once the module ended */
+  xmp_get_module_info (ctx, &module_info);
+  num_of_rows = module_info.mod->len * 256;
+  row_frames = (Uint32 *) memory_allocation (num_of_rows * sizeof (Uint32));
+  if (row_frames == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes",
+               (Uint32) (num_of_rows * sizeof (Uint32)));
+      xmp_end_player (ctx);
+      return FALSE;
+    }
+  memset (row_frames, 0xff, num_of_rows * sizeof (Uint32));
+  max_size = rate * 4 * MUSIC_CACHE_MAX_SECONDS;
+  *data_size = 0;
+  *loop_start = 0;
+  while (xmp_play_frame (ctx) == 0)
+    {
+      if (SDL_AtomicGet (&music_cache_stopped))
+        {
+          *data_size = 0;
+          break;
+        }
+      xmp_get_frame_info (ctx, &frame_info);
+      row_index = frame_info.pos * 256 + frame_info.row;
+      if (frame_info.loop_count > 0)
+        {
+          if (row_index < num_of_rows && row_frames[row_index] != 0xffffffff)
+            {
+              *loop_start = row_frames[row_index];
+            }
+          break;
+        }
+      if (frame_info.frame == 0 && row_index < num_of_rows
+          && row_frames[row_index] == 0xffffffff)
+        {
+          row_frames[row_index] = *data_size / 4;
+        }
+      samples = (Sint16 *) frame_info.buffer;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+      for (i = 0; i < frame_info.buffer_size / 2; i++)
+        {
+          samples[i] = SDL_SwapLE16 (samples[i]);
+        }
+#endif
+      if (fwrite (samples, 1, frame_info.buffer_size, out) !=
+          (size_t) frame_info.buffer_size)
+        {
+          LOG_ERR ("fwrite() failed: %s", strerror (errno));
+          free_memory ((char *) row_frames);
+          xmp_end_player (ctx);
+          return FALSE;
+        }
+      *data_size += frame_info.buffer_size;
+      if (*data_size >= max_size)
+        {
+          LOG_WARN ("\"%s\" module doesn't loop after %i seconds",
+                    module_name, MUSIC_CACHE_MAX_SECONDS);
+          break;
+        }
+    }
+  free_memory ((char *) row_frames);
+  xmp_end_player (ctx);
+  return *data_size > 0;
+}
+
+/**
+ * Render a module into a cache file, the file is written under a
+ * temporary name then renamed once complete so that a game never
+ * streams an unfinished file
+ * @param filename Filename of the cache file
+ * @param module_name Filename of the module, used in the messages
+ * @param module_data Pointer to the module data
+ * @param module_size Size of the module data in bytes
+ * @param module_hash Hash of the module data
+ * @param rate Sampling rate in Hz
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+music_cache_render (const char *filename, const char *module_name,
+                    const char *module_data, Uint32 module_size,
+                    Uint32 module_hash, Sint32 rate)
+{
+  xmp_context ctx;
+  char *build_filename;
+  FILE *out;
+  int fd;
+  Uint32 data_size, loop_start;
+  bool is_rendered;
+  ctx = xmp_create_context ();
+  if (ctx == NULL)
+    {
+      LOG_ERR ("xmp_create_context() failed");
+      return FALSE;
+    }
+  if (xmp_load_module_from_memory (ctx, (void *) module_data, module_size) <
+      0)
+    {
+      LOG_ERR ("xmp_load_module_from_memory(%s) failed", module_name);
+      xmp_free_context (ctx);
+      return FALSE;
+    }
+  build_filename = memory_allocation (strlen (filename) + 8);
+  if (build_filename == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes",
+               (Uint32) (strlen (filename) + 8));
+      xmp_release_module (ctx);
+      xmp_free_context (ctx);
+      return FALSE;
+    }
+  sprintf (build_filename, "%s.XXXXXX", filename);
+  fd = mkstemp (build_filename);
+  if (fd < 0)
+    {
+      LOG_ERR ("mkstemp(%s) failed: %s", build_filename, strerror (errno));
+      free_memory (build_filename);
+      xmp_release_module (ctx);
+      xmp_free_context (ctx);
+      return FALSE;
+    }
+  fchmod (fd, 0644);
+  out = fdopen (fd, "wb");
+  if (out == NULL)
+    {
+      LOG_ERR ("fdopen(%s) failed: %s", build_filename, strerror (errno));
+      close (fd);
+      is_rendered = FALSE;
+    }
+  else
+    {
+      is_rendered = music_cache_write_header (out, module_hash, rate, 0, 0)
+        && music_cache_play (out, module_name, ctx, rate, &data_size,
+                             &loop_start)
+        && music_cache_write_loop (out, rate, loop_start,
+                                   data_size / 4 - 1)
+        && music_cache_write_header (out, module_hash, rate,
+                                     MUSIC_CACHE_HEADER_SIZE - 8 +
+                                     data_size + MUSIC_CACHE_LOOP_SIZE,
+                                     data_size);
+      if (fclose (out) != 0)
+        {
+          is_rendered = FALSE;
+        }
+      if (!is_rendered && !SDL_AtomicGet (&music_cache_stopped))
+        {
+          LOG_ERR ("\"%s\" module could not be rendered into \"%s\"",
+                   module_name, build_filename);
+        }
+    }
+  xmp_release_module (ctx);
+  xmp_free_context (ctx);
+  if (is_rendered && rename (build_filename, filename))
+    {
+      LOG_ERR ("rename(%s, %s) failed: %s", build_filename, filename,
+               strerror (errno));
+      is_rendered = FALSE;
+    }
+  if (!is_rendered)
+    {
+      unlink (build_filename);
+    }
+  free_memory (build_filename);
+  return is_rendered;
+}
+#endif
+
+/**
+ * Return the cache file of a module, render it if the cache file
+ * doesn't exist or if it was rendered from another version of the
+ * module or at another sampling rate
+ * @param module_name Filename of the module, ie "sounds/music_game.zik"
+ * @param module_data Pointer to the module data
+ * @param module_size Size of the module data in bytes
+ * @param rate Sampling rate in Hz of the audio output
+ * @return Filename of the cache file which must be released with
+ *         free_memory(), NULL if the module must be played
+ */
+char *
+music_cache_get (const char *module_name, const char *module_data,
+                 Uint32 module_size, Sint32 rate)
+{
+  const char *dir, *basename;
+  char *filename, *extension;
+  Uint32 module_hash;
+#ifdef HAVE_LIBXMP
+  Uint32 start_time;
+#endif
+  dir = configfile_get_dir ();
+  if (dir == NULL)
+    {
+      return NULL;
+    }
+  basename = strrchr (module_name, '/');
+  basename = basename != NULL ? basename + 1 : module_name;
+  filename = memory_allocation (strlen (dir) + strlen (basename) + 8);
+  if (filename == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes",
+               (Uint32) (strlen (dir) + strlen (basename) + 8));
+      return NULL;
+    }
+  /* "sounds/music_game.zik" is cached as "music_game.wav" */
+  sprintf (filename, "%s/%s", dir, basename);
+  extension = strrchr (filename + strlen (dir) + 1, '.');
+  if (extension == NULL)
+    {
+      extension = filename + strlen (filename);
+    }
+  strcpy (extension, ".wav");
+  module_hash = hash_fnv1a (HASH_FNV1A_INIT, module_data, module_size);
+  if (music_cache_is_valid (filename, module_hash, rate))
+    {
+      LOG_DBG ("\"%s\" module is played from \"%s\"", module_name,
+               filename);
+      return filename;
+    }
+#ifdef HAVE_LIBXMP
+  if (SDL_AtomicGet (&music_cache_stopped))
+    {
+      free_memory (filename);
+      return NULL;
+    }
+  start_time = SDL_GetTicks ();
+  if (music_cache_render
+      (filename, module_name, module_data, module_size, module_hash, rate))
+    {
+      LOG_INF ("\"%s\" module rendered into \"%s\" in %i ms", module_name,
+               filename, SDL_GetTicks () - start_time);
+      return filename;
+    }
+#else
+  LOG_WARN ("built without libxmp, \"%s\" module can't be rendered",
+            module_name);
+#endif
+  free_memory (filename);
+  return NULL;
+}
+
+/**
+ * Abandon the rendering in progress and the next ones, the game
+ * quits and doesn't wait for them
+ */
+void
+music_cache_stop (void)
+{
+  SDL_AtomicSet (&music_cache_stopped, 1);
+}
+#endif
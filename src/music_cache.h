@@ -0,0 +1,44 @@
+/**
+ * @file music_cache.h
+ * @brief Render the musics modules once into loopable PCM files
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: music_cache.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __MUSIC_CACHE__
+#define __MUSIC_CACHE__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef USE_SDLMIXER
+  char *music_cache_get (const char *module_name, const char *module_data,
+                         Uint32 module_size, Sint32 rate);
+  void music_cache_stop (void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,6 +29,7 @@
 #include "config_file.h"
 #include "tools.h"
 #include "images.h"
+#include "assets_segment.h"
 #include "display.h"
 #include "electrical_shock.h"
 #include "enemies.h"
@@ -182,19 +183,17 @@ options_load (void)
   Uint32 size;
   Uint32 *repeats;
   bitmap *bmp;
+  bool is_loaded;
 
   /* extract box options animations  bitmap images (387,761 bytes) */
-  if (!bitmap_load ("graphics/bitmap/options_panel_anims.spr",
-                    &options[0][0], OPTIONS_MAX_OF_TYPES,
-                    OPTION_BOX_MAX_IMAGES))
-    {
-      return FALSE;
-    }
-
+  is_loaded = bitmap_load ("graphics/bitmap/options_panel_anims.spr",
+                           &options[0][0], OPTIONS_MAX_OF_TYPES,
+                           OPTION_BOX_MAX_IMAGES);
   /* extract score multipliers bitmap images (760 bytes) */
-  if (!bitmap_load
-      ("graphics/bitmap/scores_multiplier.spr", &multiplier_bmp[0], 1,
-       MULTIPLIERS_NUM_OF_IMAGES))
+  is_loaded = is_loaded
+    && bitmap_load ("graphics/bitmap/scores_multiplier.spr",
+                    &multiplier_bmp[0], 1, MULTIPLIERS_NUM_OF_IMAGES);
+  if (!is_loaded)
     {
       return FALSE;
     }
@@ -210,6 +209,11 @@ options_load (void)
       for (j = 0; j < OPTION_BOX_MAX_IMAGES; j++)
         {
           bmp = &options[i][j];
+          /* the display offsets can't be modified in the shared segment */
+          if (!assets_make_private (&bmp->compress, bmp->nbr_data_comp * 2))
+            {
+              return FALSE;
+            }
           repeats = (Uint32 *) bmp->compress;
           size = bmp->nbr_data_comp >> 2;
           do
@@ -233,6 +237,10 @@ options_load (void)
   for (j = 0; j < MULTIPLIERS_NUM_OF_IMAGES; j++)
     {
       bmp = &multiplier_bmp[j];
+      if (!assets_make_private (&bmp->compress, bmp->nbr_data_comp * 2))
+        {
+          return FALSE;
+        }
       repeats = (Uint32 *) bmp->compress;
       size = bmp->nbr_data_comp >> 2;
       do
@@ -0,0 +1,184 @@
+/**
+ * @file perf_counters.c
+ * @brief Hardware performance counters of the game thread
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: perf_counters.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "log_recorder.h"
+#include "perf_counters.h"
+
+#if defined (USE_PROFILER)
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/** File descriptors of the counters, -1 if not available. The
+ * cycles counter leads the group, all of them are read at once */
+static int counters_fd[PERF_NUMOF] = { -1, -1, -1, -1, -1 };
+/** Position of each counter in the values of the group */
+static Uint32 counters_index[PERF_NUMOF];
+static Uint32 numof_counters = 0;
+
+static const char *counters_names[PERF_NUMOF] = {
+  "cycles",
+  "instructions",
+  "L1D misses",
+  "LLC misses",
+  "branch misses"
+};
+
+#if defined(__linux__)
+/** Types and configurations of the events counted */
+static const struct
+{
+  Uint32 type;
+  Uint64 config;
+} counters_events[PERF_NUMOF] = {
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+#endif
+
+/**
+ * Open the counters of the calling thread, the ones the processor
+ * or the kernel don't allow are not available
+ * @return TRUE if the cycles are counted or FALSE otherwise
+ */
+bool
+perf_counters_open (void)
+{
+#if defined(__linux__)
+  struct perf_event_attr attr;
+  Uint32 i;
+  numof_counters = 0;
+  for (i = 0; i < PERF_NUMOF; i++)
+    {
+      memset (&attr, 0, sizeof (attr));
+      attr.size = sizeof (attr);
+      attr.type = counters_events[i].type;
+      attr.config = counters_events[i].config;
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.disabled = (i == PERF_CYCLES);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      counters_fd[i] =
+        syscall (__NR_perf_event_open, &attr, 0, -1, counters_fd[PERF_CYCLES],
+                 0);
+      if (counters_fd[i] < 0)
+        {
+          LOG_WARN ("perf_event_open(%s) failed (%s)",
+                    counters_names[i], strerror (errno));
+          if (i == PERF_CYCLES)
+            {
+              return FALSE;
+            }
+          continue;
+        }
+      counters_index[i] = numof_counters++;
+    }
+  ioctl (counters_fd[PERF_CYCLES], PERF_EVENT_IOC_ENABLE,
+         PERF_IOC_FLAG_GROUP);
+  return TRUE;
+#else
+  LOG_WARN ("the performance counters are only available under Linux");
+  return FALSE;
+#endif
+}
+
+/**
+ * Close the counters
+ */
+void
+perf_counters_close (void)
+{
+  Uint32 i;
+  for (i = 0; i < PERF_NUMOF; i++)
+    {
+      if (counters_fd[i] >= 0)
+        {
+          close (counters_fd[i]);
+          counters_fd[i] = -1;
+        }
+    }
+  numof_counters = 0;
+}
+
+/**
+ * Return the name of an event
+ * @param counter An event
+ * @return The name of the event
+ */
+const char *
+perf_counters_name (PERF_COUNTERS counter)
+{
+  return counters_names[counter];
+}
+
+/**
+ * Check if an event is counted
+ * @param counter An event
+ * @return TRUE if the event is counted
+ */
+bool
+perf_counters_available (PERF_COUNTERS counter)
+{
+  return counters_fd[counter] >= 0;
+}
+
+/**
+ * Read the counters
+ * @param values Array of PERF_NUMOF values to fill, the values of
+ *               the counters not available are 0
+ */
+void
+perf_counters_read (Uint64 * values)
+{
+  /* number of counters followed by their values */
+  Uint64 group[PERF_NUMOF + 1];
+  Uint32 i;
+  if (numof_counters == 0
+      || read (counters_fd[PERF_CYCLES], group,
+               sizeof (Uint64) * (numof_counters + 1)) <= 0)
+    {
+      for (i = 0; i < PERF_NUMOF; i++)
+        {
+          values[i] = 0;
+        }
+      return;
+    }
+  for (i = 0; i < PERF_NUMOF; i++)
+    {
+      values[i] = counters_fd[i] >= 0 ? group[counters_index[i] + 1] : 0;
+    }
+}
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters of the game thread
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: perf_counters.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __PERF_COUNTERS__
+#define __PERF_COUNTERS__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Events counted by the processor */
+  typedef enum
+  {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_NUMOF
+  } PERF_COUNTERS;
+
+  bool perf_counters_open (void);
+  void perf_counters_close (void);
+  const char *perf_counters_name (PERF_COUNTERS counter);
+  bool perf_counters_available (PERF_COUNTERS counter);
+  void perf_counters_read (Uint64 * values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,469 @@
+/**
+ * @file profiler.c
+ * @brief Scoped timers of the subsystems called each frame
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: profiler.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "config_file.h"
+#include "log_recorder.h"
+#include "perf_counters.h"
+#include "profiler.h"
+
+#if defined (USE_PROFILER)
+#include <time.h>
+
+/** Maximum number of timed regions in a frame */
+#define PROFILER_MAX_EVENTS 64
+/** Maximum number of nested regions */
+#define PROFILER_MAX_DEPTH 8
+
+/** A region timed during a frame */
+typedef struct profiler_event
+{
+  /** Time of the beginning in nanoseconds */
+  Uint64 start;
+  /** Duration in nanoseconds */
+  Uint32 duration;
+  Uint32 region;
+} profiler_event;
+
+/** The regions timed during a frame */
+typedef struct profiler_frame
+{
+  /** Time of the beginning in nanoseconds */
+  Uint64 start;
+  /** Duration in nanoseconds, 0 while the frame is running */
+  Uint32 duration;
+  Uint32 numof_events;
+  profiler_event events[PROFILER_MAX_EVENTS];
+  /** Sum of the durations of each region in nanoseconds */
+  Uint64 durations[PROFILER_NUMOF];
+} profiler_frame;
+
+/** A region not ended */
+typedef struct profiler_open
+{
+  /** Time of the beginning in nanoseconds */
+  Uint64 start;
+  /** Performance counters at the beginning */
+  Uint64 counters[PERF_NUMOF];
+  Uint32 region;
+  /** Event of the region, PROFILER_MAX_EVENTS if the region is
+   * not written into the trace */
+  Uint32 event;
+} profiler_open;
+
+/** The last frames, the oldest one is overwritten */
+static profiler_frame *frames = NULL;
+/** Number of frames begun */
+static Uint32 numof_frames = 0;
+static profiler_frame *current_frame = NULL;
+static profiler_open open_regions[PROFILER_MAX_DEPTH];
+static Uint32 depth = 0;
+/** Number of regions begun beyond PROFILER_MAX_DEPTH */
+static Uint32 depth_overflow = 0;
+/** TRUE if the performance counters are read */
+static bool is_counting = FALSE;
+static Uint64 frame_counters[PERF_NUMOF];
+/** Sums of the performance counters of each region */
+static Uint64 regions_counters[PROFILER_NUMOF][PERF_NUMOF];
+/** Number of times each region ran */
+static Uint32 regions_calls[PROFILER_NUMOF];
+/** Number of regions enclosing each region, the frame included */
+static Uint32 regions_depth[PROFILER_NUMOF];
+
+static const char *regions_names[PROFILER_NUMOF] = {
+  "frame",
+  "wait",
+  "update",
+  "phases",
+  "stars",
+  "bonus",
+  "guns",
+  "enemies",
+  "ship",
+  "blasts",
+  "shots",
+  "section",
+  "menu",
+  "events",
+  "display",
+  "blits",
+  "record",
+  "present",
+  "sound",
+  "decomp",
+  "collide",
+  "sprites"
+};
+
+/**
+ * Return the monotonic time
+ * @return Time in nanoseconds
+ */
+static Uint64
+profiler_time (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (Uint64) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Allocate the frames of the profiler
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+profiler_initialize (void)
+{
+  Uint32 i;
+  frames =
+    (profiler_frame *) memory_allocation (PROFILER_NUMOF_FRAMES *
+                                          sizeof (profiler_frame));
+  if (frames == NULL)
+    {
+      LOG_ERR ("not enough memory to allocate %i bytes",
+               (Sint32) (PROFILER_NUMOF_FRAMES * sizeof (profiler_frame)));
+      return FALSE;
+    }
+  numof_frames = 0;
+  current_frame = NULL;
+  depth = 0;
+  depth_overflow = 0;
+  for (i = 0; i < PROFILER_NUMOF; i++)
+    {
+      regions_depth[i] = 1;
+      regions_calls[i] = 0;
+      memset (regions_counters[i], 0, sizeof (regions_counters[i]));
+    }
+  regions_depth[PROFILER_FRAME] = 0;
+  if (power_conf->perf_counters)
+    {
+      is_counting = perf_counters_open ();
+      perf_counters_read (frame_counters);
+    }
+  return TRUE;
+}
+
+/**
+ * Release the frames of the profiler
+ */
+void
+profiler_release (void)
+{
+  if (frames != NULL)
+    {
+      free_memory ((char *) frames);
+      frames = NULL;
+    }
+  current_frame = NULL;
+  if (is_counting)
+    {
+      perf_counters_close ();
+      is_counting = FALSE;
+    }
+}
+
+/**
+ * End the current frame and begin the next one, the regions not
+ * ended are dropped
+ */
+void
+profiler_frame_begin (void)
+{
+  Uint64 now;
+  Uint64 counters[PERF_NUMOF];
+  Uint32 i;
+  if (frames == NULL)
+    {
+      return;
+    }
+  now = profiler_time ();
+  if (is_counting)
+    {
+      perf_counters_read (counters);
+      for (i = 0; i < PERF_NUMOF; i++)
+        {
+          regions_counters[PROFILER_FRAME][i] +=
+            counters[i] - frame_counters[i];
+          frame_counters[i] = counters[i];
+        }
+    }
+  if (current_frame != NULL)
+    {
+      current_frame->duration = (Uint32) (now - current_frame->start);
+      current_frame->durations[PROFILER_FRAME] = current_frame->duration;
+      regions_calls[PROFILER_FRAME]++;
+    }
+  current_frame = &frames[numof_frames % PROFILER_NUMOF_FRAMES];
+  numof_frames++;
+  current_frame->start = now;
+  current_frame->duration = 0;
+  current_frame->numof_events = 0;
+  memset (current_frame->durations, 0, sizeof (current_frame->durations));
+  depth = 0;
+  depth_overflow = 0;
+}
+
+/**
+ * Begin to time a region, it's ended by profiler_end()
+ * @param region The region beginning
+ */
+void
+profiler_begin (PROFILER_REGIONS region)
+{
+  profiler_open *open;
+  if (current_frame == NULL)
+    {
+      return;
+    }
+  if (depth >= PROFILER_MAX_DEPTH)
+    {
+      depth_overflow++;
+      return;
+    }
+  open = &open_regions[depth];
+  open->region = region;
+  open->event = PROFILER_MAX_EVENTS;
+  if (region < PROFILER_FIRST_SUMMED
+      && current_frame->numof_events < PROFILER_MAX_EVENTS)
+    {
+      open->event = current_frame->numof_events++;
+      current_frame->events[open->event].region = region;
+      current_frame->events[open->event].duration = 0;
+    }
+  regions_depth[region] = depth + 1;
+  depth++;
+  if (is_counting)
+    {
+      perf_counters_read (open->counters);
+    }
+  open->start = profiler_time ();
+  if (open->event < PROFILER_MAX_EVENTS)
+    {
+      current_frame->events[open->event].start = open->start;
+    }
+}
+
+/**
+ * End the region begun last
+ */
+void
+profiler_end (void)
+{
+  profiler_open *open;
+  profiler_event *event;
+  Uint64 counters[PERF_NUMOF];
+  Uint64 now = profiler_time ();
+  Uint32 i;
+  if (is_counting)
+    {
+      perf_counters_read (counters);
+    }
+  if (current_frame == NULL || depth == 0)
+    {
+      return;
+    }
+  if (depth_overflow > 0)
+    {
+      depth_overflow--;
+      return;
+    }
+  open = &open_regions[--depth];
+  current_frame->durations[open->region] += now - open->start;
+  regions_calls[open->region]++;
+  if (is_counting)
+    {
+      for (i = 0; i < PERF_NUMOF; i++)
+        {
+          regions_counters[open->region][i] += counters[i] - open->counters[i];
+        }
+    }
+  if (open->event < PROFILER_MAX_EVENTS)
+    {
+      event = &current_frame->events[open->event];
+      event->duration = (Uint32) (now - open->start);
+    }
+}
+
+/**
+ * Return the name of a region
+ * @param region A region
+ * @return The name of the region
+ */
+const char *
+profiler_region_name (PROFILER_REGIONS region)
+{
+  return regions_names[region];
+}
+
+/**
+ * Compute the averages and the maximums of the durations of the
+ * regions over the last PROFILER_WINDOW frames
+ * @param stats Array of PROFILER_NUMOF durations to fill
+ */
+void
+profiler_summary (profiler_stats * stats)
+{
+  Uint64 sums[PROFILER_NUMOF];
+  Uint32 i, j, numof;
+  profiler_frame *frame;
+  for (i = 0; i < PROFILER_NUMOF; i++)
+    {
+      sums[i] = 0;
+      stats[i].maximum = 0;
+      stats[i].depth = regions_depth[i];
+    }
+  /* the running frame is not complete */
+  numof = numof_frames > 0 ? numof_frames - 1 : 0;
+  if (numof > PROFILER_WINDOW)
+    {
+      numof = PROFILER_WINDOW;
+    }
+  for (i = 0; i < numof; i++)
+    {
+      frame = &frames[(numof_frames - 2 - i) % PROFILER_NUMOF_FRAMES];
+      for (j = 0; j < PROFILER_NUMOF; j++)
+        {
+          sums[j] += frame->durations[j];
+          if (frame->durations[j] / 1000 > stats[j].maximum)
+            {
+              stats[j].maximum = (Uint32) (frame->durations[j] / 1000);
+            }
+        }
+    }
+  for (i = 0; i < PROFILER_NUMOF; i++)
+    {
+      stats[i].average = numof > 0 ? (Uint32) (sums[i] / numof / 1000) : 0;
+    }
+}
+
+/**
+ * Write the regions of the last frames in the trace event format
+ * of the Chrome trace viewer
+ * @param filename Filename of the trace file
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+bool
+profiler_write_trace (const char *filename)
+{
+  FILE *file;
+  Uint32 i, j, first, numof;
+  Uint64 origin;
+  profiler_frame *frame;
+  profiler_event *event;
+  const char *separator = "";
+  if (frames == NULL || numof_frames < 2)
+    {
+      LOG_WARN ("no frame was profiled");
+      return FALSE;
+    }
+  file = fopen (filename, "w");
+  if (file == NULL)
+    {
+      LOG_ERR ("fopen(%s) failed (%s)", filename, strerror (errno));
+      return FALSE;
+    }
+  /* the running frame is not complete */
+  numof = numof_frames - 1;
+  if (numof > PROFILER_NUMOF_FRAMES - 1)
+    {
+      numof = PROFILER_NUMOF_FRAMES - 1;
+    }
+  first = numof_frames - 1 - numof;
+  origin = frames[first % PROFILER_NUMOF_FRAMES].start;
+  fprintf (file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (i = first; i < first + numof; i++)
+    {
+      frame = &frames[i % PROFILER_NUMOF_FRAMES];
+      fprintf (file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+               "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+               separator, regions_names[PROFILER_FRAME],
+               (frame->start - origin) / 1000.0, frame->duration / 1000.0,
+               i);
+      separator = ",\n";
+      for (j = 0; j < frame->numof_events; j++)
+        {
+          event = &frame->events[j];
+          fprintf (file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                   "\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                   regions_names[event->region],
+                   (event->start - origin) / 1000.0,
+                   event->duration / 1000.0);
+        }
+    }
+  fprintf (file, "\n]}\n");
+  if (fclose (file) != 0)
+    {
+      LOG_ERR ("fclose(%s) failed (%s)", filename, strerror (errno));
+      return FALSE;
+    }
+  LOG_INF ("%u frames written into %s", numof, filename);
+  return TRUE;
+}
+/**
+ * Write the performance counters of each region: the instructions
+ * per cycle and the misses per thousand instructions
+ */
+void
+profiler_print_counters (void)
+{
+  Uint32 i;
+  Uint64 *counters;
+  double kilo_instructions;
+  if (!is_counting)
+    {
+      return;
+    }
+  LOG_INF ("%-8s %8s %12s %5s %9s %9s %9s", "region", "calls", "cycles",
+           "IPC", "L1D/kI", "LLC/kI", "branch/kI");
+  for (i = 0; i < PROFILER_NUMOF; i++)
+    {
+      counters = regions_counters[i];
+      if (regions_calls[i] == 0 || counters[PERF_CYCLES] == 0)
+        {
+          continue;
+        }
+      kilo_instructions = counters[PERF_INSTRUCTIONS] / 1000.0;
+      if (kilo_instructions == 0.0)
+        {
+          kilo_instructions = 1.0;
+        }
+      LOG_INF ("%-8s %8u %12llu %5.2f %9.2f %9.2f %9.2f", regions_names[i],
+               regions_calls[i], (unsigned long long) counters[PERF_CYCLES],
+               (double) counters[PERF_INSTRUCTIONS] / counters[PERF_CYCLES],
+               counters[PERF_L1D_MISSES] / kilo_instructions,
+               counters[PERF_LLC_MISSES] / kilo_instructions,
+               counters[PERF_BRANCH_MISSES] / kilo_instructions);
+    }
+  for (i = 0; i < PERF_NUMOF; i++)
+    {
+      if (!perf_counters_available ((PERF_COUNTERS) i))
+        {
+          LOG_INF ("%s are not counted", perf_counters_name ((PERF_COUNTERS) i));
+        }
+    }
+}
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file profiler.h
+ * @brief Scoped timers of the subsystems called each frame
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: profiler.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __PROFILER__
+#define __PROFILER__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined (USE_PROFILER)
+
+/** Number of frames kept by the profiler */
+#define PROFILER_NUMOF_FRAMES 256
+/** Number of frames of the averages and the maximums */
+#define PROFILER_WINDOW 70
+/** Duration of a frame at 70 Hz in nanoseconds */
+#define PROFILER_FRAME_BUDGET 14285714
+/** Trace file written from the text overlay if none was given */
+#define PROFILER_TRACE_FILENAME "/tmp/mangadualist-trace.json"
+
+/** Timed regions, the nested ones follow the region which encloses
+ * them */
+  typedef enum
+  {
+    /* whole iteration of the main loop */
+    PROFILER_FRAME,
+    PROFILER_WAIT,
+    PROFILER_UPDATE,
+    PROFILER_PHASES,
+    PROFILER_STARFIELD,
+    PROFILER_BONUS,
+    PROFILER_SATELLITES,
+    PROFILER_ENEMIES,
+    PROFILER_SPACESHIP,
+    PROFILER_EXPLOSIONS,
+    PROFILER_SHOTS,
+    PROFILER_SECTIONS,
+    PROFILER_MENU,
+    PROFILER_EVENTS,
+    PROFILER_DISPLAY,
+    PROFILER_BLITS,
+    PROFILER_RECORD,
+    PROFILER_PRESENT,
+    PROFILER_SOUND,
+    PROFILER_DECOMPRESS,
+    /* the next regions run many times a frame, they are only summed
+     * and not written into the trace */
+    PROFILER_COLLISIONS,
+    PROFILER_SPRITES,
+    PROFILER_NUMOF
+  } PROFILER_REGIONS;
+
+/** First region which is not written into the trace */
+#define PROFILER_FIRST_SUMMED PROFILER_COLLISIONS
+
+/** Durations of a region over the last frames */
+  typedef struct profiler_stats
+  {
+    /** Average duration per frame in microseconds */
+    Uint32 average;
+    /** Maximum duration in a frame in microseconds */
+    Uint32 maximum;
+    /** Number of enclosing regions */
+    Uint32 depth;
+  } profiler_stats;
+
+  bool profiler_initialize (void);
+  void profiler_release (void);
+  void profiler_frame_begin (void);
+  void profiler_begin (PROFILER_REGIONS region);
+  void profiler_end (void);
+  const char *profiler_region_name (PROFILER_REGIONS region);
+  void profiler_summary (profiler_stats * stats);
+  bool profiler_write_trace (const char *filename);
+  void profiler_print_counters (void);
+
+#define PROFILER_BEGIN(region) profiler_begin (region)
+#define PROFILER_END() profiler_end ()
+
+#else
+
+#define PROFILER_BEGIN(region) ((void) 0)
+#define PROFILER_END() ((void) 0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,303 @@
+/**
+ * @file render_list.c
+ * @brief Sprites drawn by a tick, redrawn at interpolated positions
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: render_list.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "images.h"
+#include "display.h"
+#include "electrical_shock.h"
+#include "gfx_wrapper.h"
+#include "render_list.h"
+
+/** Score of two sprites which are not the same object */
+#define RENDER_LIST_UNMATCHED (RENDER_LIST_MAX_MOVE * 3 + 1)
+
+/** A sprite drawn into the game offscreen */
+typedef struct render_sprite
+{
+  RENDER_KIND kind;
+  /** Pointer to the 'image' or 'bitmap' structure */
+  void *gfx;
+  Sint32 xcoord;
+  Sint32 ycoord;
+  /** Size of the image, 0 for a bitmap */
+  Sint32 width;
+  Sint32 height;
+  /** Color of a sprite mask */
+  Uint32 color;
+  /** Index of the same sprite in the previous tick, -1 if none */
+  Sint32 previous;
+} render_sprite;
+
+/** The sprites drawn by a tick, in the order they were drawn */
+typedef struct render_tick
+{
+  render_sprite sprites[RENDER_LIST_MAXOF];
+  Uint32 numof_sprites;
+  /** FALSE if the tick drew pixels which are not in the list */
+  bool is_complete;
+} render_tick;
+
+/** The last two ticks */
+static render_tick ticks[2];
+/** Index of the current tick, the other one is the previous tick */
+static Uint32 current = 0;
+/** TRUE if the sprites drawn are added to the current tick */
+static bool is_recording = FALSE;
+/** TRUE if the frames are presented between the ticks */
+static bool is_enabled = FALSE;
+
+/**
+ * Enable or disable the recording of the sprites of the ticks
+ * @param enable TRUE if the frames are presented between the ticks
+ */
+void
+render_list_enable (bool enable)
+{
+  is_enabled = enable;
+  is_recording = FALSE;
+  ticks[0].numof_sprites = 0;
+  ticks[0].is_complete = FALSE;
+  ticks[1].numof_sprites = 0;
+  ticks[1].is_complete = FALSE;
+}
+
+/**
+ * Begin a tick: its sprites are recorded until render_list_end(),
+ * the current tick becomes the previous one
+ */
+void
+render_list_begin (void)
+{
+  render_tick *tick;
+  if (!is_enabled || render_disabled)
+    {
+      return;
+    }
+  current ^= 1;
+  tick = &ticks[current];
+  tick->numof_sprites = 0;
+  tick->is_complete = TRUE;
+  is_recording = TRUE;
+}
+
+/**
+ * Add a sprite drawn into the game offscreen to the current tick
+ * @param kind Drawing function of the sprite
+ * @param gfx Pointer to the 'image' or 'bitmap' structure
+ * @param xcoord X-coordinate in game offscreen
+ * @param ycoord Y-coordinate in game offscreen
+ * @param color Color of a sprite mask
+ */
+void
+render_list_add (RENDER_KIND kind, void *gfx, Uint32 xcoord,
+                 Uint32 ycoord, Uint32 color)
+{
+  render_tick *tick = &ticks[current];
+  render_sprite *sprite;
+  if (!is_recording)
+    {
+      return;
+    }
+  if (tick->numof_sprites >= RENDER_LIST_MAXOF)
+    {
+      tick->is_complete = FALSE;
+      return;
+    }
+  sprite = &tick->sprites[tick->numof_sprites++];
+  sprite->kind = kind;
+  sprite->gfx = gfx;
+  sprite->xcoord = (Sint32) xcoord;
+  sprite->ycoord = (Sint32) ycoord;
+  sprite->color = color;
+  sprite->previous = -1;
+  if (kind == RENDER_BITMAP)
+    {
+      sprite->width = 0;
+      sprite->height = 0;
+    }
+  else
+    {
+      sprite->width = ((image *) gfx)->w;
+      sprite->height = ((image *) gfx)->h;
+    }
+}
+
+/**
+ * The current tick can't be drawn again from the list: it drew pixels
+ * which are not sprites or it released images
+ */
+void
+render_list_invalidate (void)
+{
+  if (is_recording)
+    {
+      ticks[current].is_complete = FALSE;
+    }
+}
+
+/**
+ * Compare a sprite of the current tick with a sprite of the previous
+ * tick, the sprites have no identity: the closest sprite with the same
+ * image or with an image of the same size is the same object
+ * @param sprite A sprite of the current tick
+ * @param from A sprite of the previous tick
+ * @return Distance between the sprites, RENDER_LIST_UNMATCHED if
+ *         they are not the same object
+ */
+static Sint32
+sprite_distance (const render_sprite * sprite, const render_sprite * from)
+{
+  Sint32 dx, dy, distance = 0;
+  if (sprite->gfx != from->gfx)
+    {
+      /* the bitmaps are texts, their images don't change */
+      if (sprite->kind == RENDER_BITMAP || from->kind == RENDER_BITMAP)
+        {
+          return RENDER_LIST_UNMATCHED;
+        }
+      /* an animation or a sprite mask, the images of the previous
+       * tick may have been released */
+      if (sprite->width != from->width || sprite->height != from->height)
+        {
+          return RENDER_LIST_UNMATCHED;
+        }
+      distance = RENDER_LIST_MAX_MOVE;
+    }
+  dx = abs (sprite->xcoord - from->xcoord);
+  dy = abs (sprite->ycoord - from->ycoord);
+  if (dx > RENDER_LIST_MAX_MOVE || dy > RENDER_LIST_MAX_MOVE)
+    {
+      return RENDER_LIST_UNMATCHED;
+    }
+  return distance + dx + dy;
+}
+
+/**
+ * End the current tick: search the sprites of the previous tick.
+ * The objects are drawn in about the same order at each tick, so only
+ * the sprites around the same rank are compared
+ */
+void
+render_list_end (void)
+{
+  render_tick *tick = &ticks[current];
+  render_tick *previous = &ticks[current ^ 1];
+  bool is_taken[RENDER_LIST_MAXOF];
+  render_sprite *sprite;
+  Uint32 i, j, first, last;
+  Sint32 distance, best;
+  if (!is_recording)
+    {
+      return;
+    }
+  is_recording = FALSE;
+  memset (is_taken, 0, previous->numof_sprites * sizeof (bool));
+  for (i = 0; i < tick->numof_sprites; i++)
+    {
+      sprite = &tick->sprites[i];
+      best = RENDER_LIST_UNMATCHED;
+      first = i > RENDER_LIST_SEARCH ? i - RENDER_LIST_SEARCH : 0;
+      last = i + RENDER_LIST_SEARCH;
+      if (last > previous->numof_sprites)
+        {
+          last = previous->numof_sprites;
+        }
+      for (j = first; j < last; j++)
+        {
+          if (is_taken[j])
+            {
+              continue;
+            }
+          distance = sprite_distance (sprite, &previous->sprites[j]);
+          if (distance < best)
+            {
+              best = distance;
+              sprite->previous = (Sint32) j;
+            }
+        }
+      if (sprite->previous >= 0)
+        {
+          is_taken[sprite->previous] = TRUE;
+        }
+    }
+}
+
+/**
+ * Draw again the sprites of the current tick into the game offscreen,
+ * each one between its positions in the previous and the current tick
+ * @param alpha Interpolation factor from 0 (previous tick) to
+ *              RENDER_LIST_ONE (current tick)
+ * @return TRUE if the offscreen was drawn again, or FALSE if it keeps
+ *         the frame drawn by the current tick
+ */
+bool
+render_list_draw (Uint32 alpha)
+{
+  render_tick *tick = &ticks[current];
+  render_tick *previous = &ticks[current ^ 1];
+  render_sprite *sprite, *from;
+  Sint32 xcoord, ycoord;
+  Uint32 i;
+  if (!is_enabled || render_disabled || !tick->is_complete
+      || alpha >= RENDER_LIST_ONE)
+    {
+      return FALSE;
+    }
+  display_clear_offscreen ();
+  for (i = 0; i < tick->numof_sprites; i++)
+    {
+      sprite = &tick->sprites[i];
+      xcoord = sprite->xcoord;
+      ycoord = sprite->ycoord;
+      if (sprite->previous >= 0)
+        {
+          from = &previous->sprites[sprite->previous];
+          xcoord =
+            from->xcoord + (xcoord - from->xcoord) * (Sint32) alpha /
+            RENDER_LIST_ONE;
+          ycoord =
+            from->ycoord + (ycoord - from->ycoord) * (Sint32) alpha /
+            RENDER_LIST_ONE;
+        }
+      switch (sprite->kind)
+        {
+        case RENDER_SPRITE:
+          draw_sprite ((image *) sprite->gfx, (Uint32) xcoord,
+                       (Uint32) ycoord);
+          break;
+        case RENDER_SPRITE_MASK:
+          draw_sprite_mask (sprite->color, (image *) sprite->gfx,
+                            (Uint32) xcoord, (Uint32) ycoord);
+          break;
+        case RENDER_BITMAP:
+          draw_bitmap ((bitmap *) sprite->gfx, (Uint32) xcoord,
+                       (Uint32) ycoord);
+          break;
+        }
+    }
+  return TRUE;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file render_list.h
+ * @brief Sprites drawn by a tick, redrawn at interpolated positions
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: render_list.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __RENDER_LIST__
+#define __RENDER_LIST__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Maximum number of sprites drawn by a tick */
+#define RENDER_LIST_MAXOF 1024
+/** Interpolation factor of the current tick, 0 is the previous one */
+#define RENDER_LIST_ONE 256
+/** Maximum distance in pixels a sprite moves between two ticks */
+#define RENDER_LIST_MAX_MOVE 16
+/** Number of sprites of the previous tick searched around the rank
+ * of a sprite of the current tick */
+#define RENDER_LIST_SEARCH 32
+
+  typedef enum
+  {
+    RENDER_SPRITE,
+    RENDER_SPRITE_MASK,
+    RENDER_BITMAP
+  } RENDER_KIND;
+
+  void render_list_enable (bool enable);
+  void render_list_begin (void);
+  void render_list_add (RENDER_KIND kind, void *gfx, Uint32 xcoord,
+                        Uint32 ycoord, Uint32 color);
+  void render_list_invalidate (void);
+  void render_list_end (void);
+  bool render_list_draw (Uint32 alpha);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
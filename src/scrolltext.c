@@ -213,7 +213,7 @@ scrolltext_load (void)
   scrolltext_menu = memory_allocation (filesize);
   if (scrolltext_menu == NULL)
     {
-      free_memory (filedata);
+      free_file (filedata);
       return FALSE;
     }
 
@@ -225,7 +225,7 @@ scrolltext_load (void)
           scrolltext_menu[j++] = filedata[i];
         }
     }
-  free_memory (filedata);
+  free_file (filedata);
   return TRUE;
 }
 
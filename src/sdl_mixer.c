@@ -27,22 +27,38 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "tools.h"
+#include "archive.h"
 #include "config_file.h"
+#include "effects_mixer.h"
 #include "display.h"
 #include "log_recorder.h"
 #include "menu.h"
 #include "menu_sections.h"
+#include "music_cache.h"
 #ifdef USE_SDLMIXER
 #include "sdl_mixer.h"
 
-static Mix_Music *music_chunk = NULL;
+/** Musics modules loaded by the background thread, NULL if not yet */
+static Mix_Music *music_cache[MUSIC_NUMOF];
+/** TRUE if a music module could not be loaded */
+static bool music_failed[MUSIC_NUMOF];
+/** Protects the cache and the selected module from the loader thread */
+static SDL_mutex *music_mutex = NULL;
+static SDL_Thread *music_loader = NULL;
+/** 1 once the music loader must stop before the next module */
+static SDL_atomic_t music_loader_stop;
 /** List of flags of requested sounds */
 bool sounds_play[SOUND_NUMOF];
+/** TRUE if there is neither sound nor music: --nosound, the
+ * fork-server or a failure of the audio; it is not saved */
+bool sound_disabled = FALSE;
 static bool music_enabled = TRUE;
-/** Module number loaded in memory */
-static Sint32 module_num_loaded = -1;
 /** Module number requested */
 static Sint32 module_num_selected = 0;
+/** TRUE if the requested module starts once the current one faded out */
+static bool music_switch_pending = FALSE;
+/** Duration in milliseconds of the fade out and fade in of the musics */
+static const Sint32 MUSIC_FADE_DELAY = 400;
 /** If TRUE enable or disable the music */
 static bool start_stop_music = FALSE;
 static const Uint32 VOLUME_INC = MIX_MAX_VOLUME / 16;
@@ -86,8 +102,36 @@ static const char *sounds_filenames[SOUND_NUMOF] = {
   "sounds/sound_guardian_fire_3.wav"
 };
 
+/** Priorities of the waves sounds, a sound can only replace a sound
+ * of lower or equal priority when all the voices are in use */
+static const Uint8 sounds_priorities[SOUND_NUMOF] = {
+  /* upgrade and downgrade spaceship */
+  6, 6,
+  /* select option and select closed option */
+  5, 5,
+  /* purple, yellow, green and red gems */
+  4, 4, 4, 4,
+  /* lonely foe */
+  3,
+  /* circular shock */
+  7,
+  /* spaceship fire and guardian fire 2 */
+  1, 2,
+  /* big explosions */
+  6, 6, 6, 6,
+  /* medium explosions */
+  4, 4, 4, 4,
+  /* small explosions */
+  2, 2, 2, 2,
+  /* enemy fires and guardian fires */
+  1, 1, 2, 2
+};
+
+/** TRUE if the waves sounds are mixed by the effects mixer */
+static bool effects_mixed = FALSE;
+
 /** Filenames of the musics modules */
-static const char *musics_filenames[] = {
+static const char *musics_filenames[MUSIC_NUMOF] = {
   "sounds/music_menu.zik",
   "sounds/music_game.zik",
   "sounds/music_congratulations.zik"
@@ -95,7 +139,7 @@ static const char *musics_filenames[] = {
 
 /** Internal format of the waves sounds */
 static Mix_Chunk *sounds_chunck[SOUND_NUMOF];
-static bool sound_load_module (Sint32 module_num);
+static int sound_music_loader (void *unused);
 /** 
  * First initializations of SDL_mixer and load waves sounds files 
  * @return TRUE if successful
@@ -107,11 +151,12 @@ sound_once_init (void)
   Sint32 audio_rate, audio_buffers;
   Uint16 audio_format;
   const char *filename;
-  char *pathname;
+  char *pathname, *filedata;
+  Uint32 filesize;
   Mix_Chunk *sample;
 
   /* force no sound */
-  if (power_conf->nosound)
+  if (sound_disabled)
     {
       LOG_INF ("sound has been disabled");
       return TRUE;
@@ -120,26 +165,48 @@ sound_once_init (void)
   music_volume = MIX_MAX_VOLUME;
   start_stop_music = FALSE;
   music_enabled = TRUE;
-  module_num_loaded = -1;
   module_num_selected = MUSIC_INTRO;
+  music_switch_pending = FALSE;
+  for (i = 0; i < MUSIC_NUMOF; i++)
+    {
+      music_cache[i] = NULL;
+      music_failed[i] = FALSE;
+    }
   if (SDL_Init (SDL_INIT_AUDIO | SDL_INIT_NOPARACHUTE) < 0)
     {
       LOG_ERR ("SDL_Init() failed: %s", SDL_GetError ());
-      power_conf->nosound = 1;
+      sound_disabled = TRUE;
       return 1;
     }
-  audio_rate = 44100;
-  audio_buffers = 4096;
+  /* a small buffer lowers the delay between a request and its sound */
+  audio_rate = power_conf->audio_rate;
+  audio_buffers = power_conf->audio_buffer;
 
   audio_format = AUDIO_S16;
   if (Mix_OpenAudio (audio_rate, audio_format, 2, audio_buffers))
     {
       LOG_ERR ("Mix_OpenAudio() return %s", SDL_GetError ());
-      power_conf->nosound = 1;
+      sound_disabled = TRUE;
       SDL_Quit ();
       return TRUE;
     }
   Mix_AllocateChannels (MAX_OF_CHANNELS);
+  LOG_INF ("audio output: %i Hz; buffer of %i samples (%i ms)",
+           audio_rate, audio_buffers, audio_buffers * 1000 / audio_rate);
+
+  /* the musics modules are loaded in the background, the intro first */
+  music_mutex = SDL_CreateMutex ();
+  if (music_mutex == NULL)
+    {
+      LOG_ERR ("SDL_CreateMutex() failed: %s", SDL_GetError ());
+      return FALSE;
+    }
+  music_loader = SDL_CreateThread (sound_music_loader, "music", NULL);
+  if (music_loader == NULL)
+    {
+      LOG_ERR ("SDL_CreateThread() failed: %s", SDL_GetError ());
+      return FALSE;
+    }
   if (!sound_music_play (MUSIC_INTRO))
     {
       return FALSE;
@@ -152,106 +219,228 @@ sound_once_init (void)
   for (i = 0; i < SOUND_NUMOF; i++)
     {
       filename = sounds_filenames[i];
-      pathname = locate_data_file (filename);
-      if (pathname == NULL)
+      filedata = archive_find (filename, &filesize);
+      if (filedata != NULL)
         {
-          LOG_ERR ("error locating data \"%s\" file", filename);
-          return FALSE;
+          sample =
+            Mix_LoadWAV_RW (SDL_RWFromConstMem (filedata, filesize), 1);
         }
-      sample = Mix_LoadWAV (pathname);
-      if (sample == NULL)
+      else
         {
+          pathname = locate_data_file (filename);
+          if (pathname == NULL)
+            {
+              LOG_ERR ("error locating data \"%s\" file", filename);
+              return FALSE;
+            }
+          sample = Mix_LoadWAV (pathname);
           free_memory (pathname);
+        }
+      if (sample == NULL)
+        {
           LOG_ERR ("Mix_LoadWAV() return: %s", Mix_GetError ());
           return FALSE;
         }
-      free_memory (pathname);
       sounds_chunck[i] = sample;
       /* calculate the size in bytes of the waves samples */
       sound_samples_len += sample->alen;
     }
+  effects_mixed =
+    effects_mixer_open (sounds_chunck, sounds_priorities, SOUND_NUMOF,
+                        MAX_OF_CHANNELS);
   LOG_INF ("sound has been successfully initialized");
   return TRUE;
 }
 
-static void
-sound_free_current_music (void)
+/**
+ * Load the PCM file rendered from a music module, it is streamed
+ * with much less CPU than the module itself
+ * @param filename Filename of the module
+ * @return Pointer to the music, NULL if the module must be played
+ */
+static Mix_Music *
+sound_load_cached_module (const char *filename)
 {
-  if (module_num_loaded >= 0 && music_chunk != NULL)
+  char *cachename, *filedata;
+  Uint32 filesize;
+  Mix_Music *music;
+  filedata = loadfile (filename, &filesize);
+  if (filedata == NULL)
     {
-      LOG_INF ("Free music %i, module_num_loaded");
-      Mix_HaltMusic ();
-      Mix_FreeMusic (music_chunk);
-      module_num_loaded = -1;
-      music_chunk = NULL;
+      return NULL;
     }
+  cachename =
+    music_cache_get (filename, filedata, filesize, power_conf->audio_rate);
+  free_file (filedata);
+  if (cachename == NULL)
+    {
+      return NULL;
+    }
+  music = Mix_LoadMUS (cachename);
+  if (music == NULL)
+    {
+      LOG_ERR ("Mix_LoadMUS(%s) return: %s", cachename, SDL_GetError ());
+    }
+  free_memory (cachename);
+  return music;
 }
 
 /**
- * Load a music module
+ * Load a music module, called by the loader thread
  * @param module_num Music module number
- * @return TRUE if success
+ * @return Pointer to the music, NULL if it could not be loaded
  */
-static bool
+static Mix_Music *
 sound_load_module (Sint32 module_num)
 {
   const char *filename;
-  char *pathname;
-  if (power_conf->nosound)
+  char *pathname, *filedata;
+  Uint32 filesize;
+  Mix_Music *music;
+  filename = musics_filenames[module_num];
+  if (power_conf->music_cache)
     {
-      return TRUE;
+      music = sound_load_cached_module (filename);
+      if (music != NULL)
+        {
+          return music;
+        }
     }
-  if (!music_enabled)
+  /* the module is read from the mapping as long as it is played */
+  filedata = archive_find (filename, &filesize);
+  if (filedata != NULL)
     {
-      return TRUE;
+      music = Mix_LoadMUS_RW (SDL_RWFromConstMem (filedata, filesize), 1);
+      if (music == NULL)
+        {
+          LOG_ERR ("Mix_LoadMUS_RW(%s) return: %s", filename,
+                   SDL_GetError ());
+        }
+      return music;
     }
-  sound_free_current_music ();
-  filename = musics_filenames[module_num];
   pathname = locate_data_file (filename);
   if (pathname == NULL)
     {
       LOG_ERR ("error locating data \"%s\" file", filename);
-      return FALSE;
+      return NULL;
     }
   LOG_DBG ("try to load \"%s\" file", filename);
-  music_chunk = Mix_LoadMUS (pathname);
-  if (NULL == music_chunk)
+  music = Mix_LoadMUS (pathname);
+  if (music == NULL)
     {
       LOG_ERR ("Mix_LoadMUS(%s) return: %s", pathname, SDL_GetError ());
-      free_memory (pathname);
-      return FALSE;
+    }
+  else
+    {
+      LOG_DBG ("\"%s\" module has been loaded", filename);
     }
   free_memory (pathname);
-  LOG_DBG ("\"%s\" module has been loaded", filename);
-  module_num_loaded = module_num;
-  return TRUE;
+  return music;
 }
 
 /**
- * Load and play a music module
+ * Thread which loads the musics modules once, the module requested
+ * by the game first, so that a music change never waits for a file
+ * @param unused Not used
+ * @return Always 0
+ */
+static int
+sound_music_loader (void *unused)
+{
+  Sint32 i, module_num;
+  Mix_Music *music;
+  (void) unused;
+  while (!SDL_AtomicGet (&music_loader_stop))
+    {
+      SDL_LockMutex (music_mutex);
+      module_num = module_num_selected;
+      if (music_cache[module_num] != NULL || music_failed[module_num])
+        {
+          module_num = -1;
+          for (i = 0; i < MUSIC_NUMOF; i++)
+            {
+              if (music_cache[i] == NULL && !music_failed[i])
+                {
+                  module_num = i;
+                  break;
+                }
+            }
+        }
+      SDL_UnlockMutex (music_mutex);
+      if (module_num < 0)
+        {
+          break;
+        }
+      music = sound_load_module (module_num);
+      SDL_LockMutex (music_mutex);
+      music_cache[module_num] = music;
+      music_failed[module_num] = (music == NULL);
+      SDL_UnlockMutex (music_mutex);
+    }
+  return 0;
+}
+
+/**
+ * Start the requested music once the previous one faded out and
+ * the module is loaded
+ */
+static void
+sound_music_update (void)
+{
+  Mix_Music *music;
+  bool is_failed;
+  if (!music_switch_pending || Mix_PlayingMusic ())
+    {
+      return;
+    }
+  SDL_LockMutex (music_mutex);
+  music = music_cache[module_num_selected];
+  is_failed = music_failed[module_num_selected];
+  SDL_UnlockMutex (music_mutex);
+  if (is_failed)
+    {
+      /* the game continues without this music */
+      music_switch_pending = FALSE;
+      return;
+    }
+  if (music == NULL)
+    {
+      /* still being loaded */
+      return;
+    }
+  music_switch_pending = FALSE;
+  if (Mix_FadeInMusic (music, -1, MUSIC_FADE_DELAY) == -1)
+    {
+      LOG_ERR ("Mix_FadeInMusic() return %s", SDL_GetError ());
+    }
+}
+
+/**
+ * Request to play a music module, the current music fades out then
+ * the new one fades in, without waiting for the module to be loaded
  * @param module_num Music module number
  * @return TRUE if success
  */
 bool
 sound_music_play (Sint32 module_num)
 {
-  if (power_conf->nosound)
+  if (sound_disabled)
     {
       return TRUE;
     }
+  SDL_LockMutex (music_mutex);
   module_num_selected = module_num;
+  SDL_UnlockMutex (music_mutex);
   if (!music_enabled)
     {
       return TRUE;
     }
-  if (!sound_load_module (module_num))
+  music_switch_pending = TRUE;
+  if (Mix_PlayingMusic ())
     {
-      return FALSE;
-    }
-  if (Mix_PlayMusic (music_chunk, -1) == -1)
-    {
-      LOG_ERR ("Mix_PlayMusic() return %s", SDL_GetError ());
+      Mix_FadeOutMusic (MUSIC_FADE_DELAY);
     }
+  sound_music_update ();
   return TRUE;
 }
 
@@ -288,6 +477,7 @@ sound_volume_ctrl (void)
 
   /* set the volume of all channels */
   Mix_Volume (-1, music_volume_selected);
+  effects_mixer_volume (music_volume_selected);
 }
 
 /**
@@ -297,7 +487,7 @@ void
 sound_handle (void)
 {
   Uint32 i;
-  if (power_conf->nosound)
+  if (sound_disabled)
     {
       return;
     }
@@ -323,7 +513,12 @@ sound_handle (void)
     }
   for (i = 0; i < SOUND_NUMOF; i++)
     {
-      if (sounds_play[i])
+      if (sounds_play[i] && effects_mixed)
+        {
+          effects_mixer_play (i);
+          sounds_play[i] = FALSE;
+        }
+      else if (sounds_play[i])
         {
           if (Mix_PlayChannel (-1, sounds_chunck[i], 0) == -1)
             {
@@ -334,6 +529,7 @@ sound_handle (void)
           sounds_play[i] = FALSE;
         }
     }
+  sound_music_update ();
 
   /* [CTRL] + [S] released */
   if (start_stop_music && !keys_down[K_CTRL] && !keys_down[K_F5])
@@ -343,21 +539,14 @@ sound_handle (void)
         {
           /* disable the music, sound only! */
           music_enabled = FALSE;
-          if (!sound_load_module (module_num_selected))
-            {
-              quit_game = TRUE;
-            }
+          music_switch_pending = FALSE;
           Mix_VolumeMusic (0);
         }
       else
         {
           /* enable the music, sound and music ! */
           music_enabled = TRUE;
-          if (!sound_load_module (module_num_selected))
-            {
-              quit_game = TRUE;
-            }
-          Mix_PlayMusic (music_chunk, -1);
+          sound_music_play (module_num_selected);
           Mix_VolumeMusic (music_volume_selected);
         }
     }
@@ -377,11 +566,34 @@ void
 sound_free (void)
 {
   Uint32 i;
-  if (power_conf->nosound)
+  if (sound_disabled)
     {
       return;
     }
-  sound_free_current_music ();
+  if (music_loader != NULL)
+    {
+      /* don't wait for the modules which are not rendered yet */
+      SDL_AtomicSet (&music_loader_stop, 1);
+      music_cache_stop ();
+      SDL_WaitThread (music_loader, NULL);
+      music_loader = NULL;
+    }
+  effects_mixer_close ();
+  effects_mixed = FALSE;
+  Mix_HaltMusic ();
+  for (i = 0; i < MUSIC_NUMOF; i++)
+    {
+      if (music_cache[i] != NULL)
+        {
+          Mix_FreeMusic (music_cache[i]);
+          music_cache[i] = NULL;
+        }
+    }
+  if (music_mutex != NULL)
+    {
+      SDL_DestroyMutex (music_mutex);
+      music_mutex = NULL;
+    }
   for (i = 0; i < SOUND_NUMOF; i++)
     {
       /* sound was loaded? */
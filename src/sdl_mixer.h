@@ -45,7 +45,9 @@ extern "C"
   {
     MUSIC_INTRO,
     MUSIC_GAME,
-    MUSIC_CONGRATULATIONS
+    MUSIC_CONGRATULATIONS,
+
+    MUSIC_NUMOF
   }
   MUSIC_LIST;
 
@@ -90,6 +92,7 @@ extern "C"
 
   extern Uint32 sound_samples_len;
   extern bool sounds_play[SOUND_NUMOF];
+  extern bool sound_disabled;
 
 #ifdef __cplusplus
 }
@@ -36,6 +36,7 @@
 #include "enemies.h"
 #include "bonus.h"
 #include "log_recorder.h"
+#include "render_list.h"
 #include "shots.h"
 #include "sdl_mixer.h"
 #include "shockwave.h"
@@ -589,6 +590,11 @@ draw_polygon (char *addr, Sint32 * coords, Sint32 numofpts, Uint32 color)
   Sint32 numofpixels;
   char *drawaddr;
   char *linestart;
+  if (render_disabled)
+    {
+      return;
+    }
+  render_list_invalidate ();
   switch (bytes_per_pixel)
     {
     case 2:
@@ -43,6 +43,7 @@
 #include "menu.h"
 #include "menu_sections.h"
 #include "options_panel.h"
+#include "profiler.h"
 #include "satellite_protections.h"
 #include "sdl_mixer.h"
 #include "spaceship.h"
@@ -283,6 +284,7 @@ shot_moving (shot_struct * bullet)
   Uint32 i;
   float a;
   enemy *foe;
+  const curve_point *point;
   sprite *spr = &bullet->spr;
 
   switch (spr->trajectory)
@@ -356,12 +358,10 @@ shot_moving (shot_struct * bullet)
                 return FALSE;
               }
             /* change x and y coordinates */
-            spr->xcoord +=
-              (float) initial_curve[bullet->curve_num].delta_x[bullet->
-                                                               curve_index];
-            spr->ycoord +=
-              (float) initial_curve[bullet->curve_num].delta_y[bullet->
-                                                               curve_index];
+            point =
+              &initial_curve[bullet->curve_num].points[bullet->curve_index];
+            spr->xcoord += (float) point->delta_x;
+            spr->ycoord += (float) point->delta_y;
           }
       }
       break;
@@ -420,10 +420,13 @@ shot_display (shot_struct * bullet)
         /* fixed trajectory: collisions spaceship shots and enemies */
         if (bullet->spr.type == FRIEND)
           {
+            PROFILER_BEGIN (PROFILER_COLLISIONS);
             if (!shot_enemies_collisions (bullet))
               {
+                PROFILER_END ();
                 return FALSE;
               }
+            PROFILER_END ();
           }
 
         /*
@@ -507,10 +510,13 @@ shot_display (shot_struct * bullet)
         /* trajectory calculated: collisions spaceship shots and enemies */
         if (bullet->spr.type == FRIEND)
           {
+            PROFILER_BEGIN (PROFILER_COLLISIONS);
             if (!shot_enemies_collisions (bullet))
               {
+                PROFILER_END ();
                 return FALSE;
               }
+            PROFILER_END ();
           }
         if (!player_pause && menu_status == MENU_OFF)
           {
@@ -728,6 +734,29 @@ shot_check_chained_list (void)
 }
 #endif
 
+/**
+ * Fold the state of all active shots into a hash
+ * @param hash Current hash value
+ * @return The updated hash value
+ */
+Uint32
+shots_hash (Uint32 hash)
+{
+  Sint32 i;
+  shot_struct *bullet = shot_first;
+  for (i = 0; i < num_of_shots && bullet != NULL; i++, bullet = bullet->next)
+    {
+      hash = sprite_hash (hash, &bullet->spr);
+      hash = hash_fnv1a (hash, &bullet->curve_index,
+                         sizeof (bullet->curve_index));
+      hash = hash_fnv1a (hash, &bullet->timelife, sizeof (bullet->timelife));
+      hash = hash_fnv1a (hash, &bullet->angle, sizeof (bullet->angle));
+      hash = hash_fnv1a (hash, &bullet->img_angle,
+                         sizeof (bullet->img_angle));
+    }
+  return hash;
+}
+
 /** 
  * Return a free shot element 
  * @return Pointer to a shot structure 
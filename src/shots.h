@@ -75,6 +75,7 @@ extern "C"
   void shots_init (void);
   void shots_handle (void);
   shot_struct *shot_get (void);
+  Uint32 shots_hash (Uint32 hash);
   void shot_enemy_add (const enemy * const ev, Sint32 k);
   shot_struct *shot_guardian_add (const enemy * const guard, Uint32 cannon,
                                   Sint16 power, float speed);
@@ -68,6 +68,12 @@ static unsigned char cycling_table[] = {
 static Uint32 cycling_delay = 0;
 static Uint32 cycling_index = 0;
 
+static sprite_string_struct *sprites_string_alloc (const char *string,
+                                                   Uint32 size, Uint32 type,
+                                                   float coordx,
+                                                   float coordy,
+                                                   bool copy_string);
+
 /**
  * Color cycling, return new color
  * @return: color index
@@ -251,20 +257,15 @@ sprites_font_extract (void)
 void
 sprites_string_free (void)
 {
-  Uint32 i;
   LOG_DBG ("deallocates the memory used by the bitmap");
   if (strings_list == NULL)
     {
       return;
     }
-  for (i = 0; i < MAX_OF_STRINGS; i++)
+  /* sprites_string_delete() moves the next strings down the list */
+  while (num_of_sprites_strings > 0)
     {
-      if (strings_list[i] == NULL)
-        {
-          continue;
-        }
-      sprites_string_delete (strings_list[i]);
-      strings_list[i] = NULL;
+      sprites_string_delete (strings_list[0]);
     }
   free_memory ((char *) strings_list);
   strings_list = NULL;
@@ -289,9 +290,7 @@ sprite_string_struct *
 sprites_string_new (const char *const string, Uint32 more_chars, Uint32 type,
                     float coordx, float coordy)
 {
-  Uint32 i;
   sprite_string_struct *sprite_str;
-  char *string_allocated;
   Uint32 numof_chars, maxof_chars;
 
   if (string != NULL)
@@ -309,32 +308,12 @@ sprites_string_new (const char *const string, Uint32 more_chars, Uint32 type,
       return NULL;
     }
 
-  /* allocate the string */
-  string_allocated = memory_allocation (maxof_chars + 1);
-  if (string_allocated == NULL)
-    {
-      LOG_ERR ("not enough memory to allocate a string!");
-      return NULL;
-    }
-  if (string != NULL)
-    {
-      strcpy (string_allocated, string);
-    }
-  else
-    {
-      for (i = 0; i < maxof_chars; i++)
-        {
-          string_allocated[i] = ' ';
-        }
-    }
-
+  /* the string is allocated with the structure */
   sprite_str =
-    sprites_string_create (string_allocated, maxof_chars, type, coordx,
-                           coordy);
+    sprites_string_alloc (string, maxof_chars, type, coordx, coordy, TRUE);
   if (sprite_str == NULL)
     {
-      free_memory (string_allocated);
-      LOG_ERR ("sprites_string_create() failed!");
+      LOG_ERR ("sprites_string_alloc() failed!");
       return NULL;
     }
   sprite_str->num_of_chars = numof_chars;
@@ -356,7 +335,25 @@ sprite_string_struct *
 sprites_string_create (char *string, Uint32 size, Uint32 type, float coordx,
                        float coordy)
 {
-  Uint32 i;
+  return sprites_string_alloc (string, size, type, coordx, coordy, FALSE);
+}
+
+/**
+ * Allocate a string of sprites characters, the structure, the sprites
+ * chars and the copy of the string take a single memory zone
+ * @param string A simple string or NULL for a string of spaces
+ * @param size Length of the string
+ * @param type Type of font (FONT_BIG, FONT_SCROLL, FONT_SCROLL, or FONT_SCORE)
+ * @param coordx X coordinate in pixels
+ * @param coordy Y coordinate in pixels
+ * @param copy_string TRUE to copy the string after the sprites chars
+ * @return Pointer to a sprites string structure
+ */
+static sprite_string_struct *
+sprites_string_alloc (const char *string, Uint32 size, Uint32 type,
+                      float coordx, float coordy, bool copy_string)
+{
+  Uint32 i, memsize;
   sprite_char_struct *sprite_char;
   sprite_string_struct *sprite_str;
   if (num_of_sprites_strings >= MAX_OF_STRINGS)
@@ -365,17 +362,36 @@ sprites_string_create (char *string, Uint32 size, Uint32 type, float coordx,
       return NULL;
     }
 
-  /* allocate the sprite string structure */
-  sprite_str =
-    (sprite_string_struct *)
-    memory_allocation (sizeof (sprite_string_struct));
+  /* allocate the sprite string structure and its chars */
+  memsize = sizeof (sprite_string_struct) + size * sizeof (sprite_char_struct);
+  if (copy_string)
+    {
+      memsize += size + 1;
+    }
+  sprite_str = (sprite_string_struct *) memory_allocation (memsize);
   if (sprite_str == NULL)
     {
       LOG_ERR ("not enough memory to allocate 'sprite_string_struct'!");
       return NULL;
     }
-  sprite_str->string = string;
-  sprite_str->is_string_allocated = FALSE;
+  sprite_str->sprites_chars = (sprite_char_struct *) (sprite_str + 1);
+  if (copy_string)
+    {
+      sprite_str->string = (char *) (sprite_str->sprites_chars + size);
+      if (string != NULL)
+        {
+          strcpy (sprite_str->string, string);
+        }
+      else
+        {
+          memset (sprite_str->string, ' ', size);
+        }
+    }
+  else
+    {
+      sprite_str->string = (char *) string;
+    }
+  sprite_str->is_string_allocated = copy_string;
   sprite_str->num_of_chars = size;
   sprite_str->max_of_chars = size;
   sprite_str->coord_x = coordx;
@@ -390,16 +406,6 @@ sprites_string_create (char *string, Uint32 size, Uint32 type, float coordx,
   sprite_str->cursor_pos = 0;
   sprite_str->cursor_status = 0;
 
-  /* allocate sprites chars structures */
-  sprite_str->sprites_chars =
-    (sprite_char_struct *) memory_allocation (sprite_str->max_of_chars *
-                                              sizeof (sprite_char_struct));
-  if (sprite_str->sprites_chars == NULL)
-    {
-      free_memory ((char *) sprite_str);
-      LOG_ERR ("not enough memory to allocate 'sprite_char_struct'!");
-      return NULL;
-    }
   for (i = 0; i < sprite_str->max_of_chars; i++)
     {
       sprite_char = &sprite_str->sprites_chars[i];
@@ -429,23 +435,14 @@ sprites_string_delete (sprite_string_struct * sprite_str)
         {
           continue;
         }
-      if (sprite_str->sprites_chars != NULL)
-        {
-          free_memory ((char *) sprite_str->sprites_chars);
-          sprite_str->sprites_chars = NULL;
-        }
-      if (sprite_str->string != NULL && sprite_str->is_string_allocated)
-        {
-          free_memory (sprite_str->string);
-          sprite_str->string = NULL;
-          sprite_str->is_string_allocated = FALSE;
-        }
+      /* the chars and the string are in the memory zone */
       free_memory ((char *) sprite_str);
       for (j = i; j < MAX_OF_STRINGS - 1; j++)
         {
           strings_list[j] = strings_list[j + 1];
         }
       strings_list[j] = NULL;
+      num_of_sprites_strings--;
       return;
     }
   LOG_ERR ("sprite_string_struct not found");
@@ -134,7 +134,7 @@ extern "C"
     Sint32 radius_y;
     /** ASCII string */
     char *string;
-    /** True if the string was allocated */
+    /** True if the string is a copy stored after the sprites chars */
     bool is_string_allocated;
     sprite_char_struct *sprites_chars;
     Sint32 cursor_pos;
@@ -0,0 +1,199 @@
+/**
+ * @file task_graph.c
+ * @brief Run initialization tasks in parallel according to their
+ *        dependencies
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: task_graph.c,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#include "config.h"
+#include "mangadualist.h"
+#include "tools.h"
+#include "log_recorder.h"
+#include "task_graph.h"
+
+/** Tasks of the graph being run */
+static const task_desc *graph_tasks = NULL;
+static Uint32 graph_num_of_tasks = 0;
+/** Tasks already taken by a thread */
+static Uint32 graph_started = 0;
+/** Tasks completed successfully */
+static Uint32 graph_completed = 0;
+/** TRUE if a task failed, the remaining tasks are not started */
+static bool graph_failed = FALSE;
+static SDL_mutex *graph_mutex = NULL;
+/** Signaled each time a task is completed */
+static SDL_cond *graph_cond = NULL;
+
+/**
+ * Take the tasks whose dependencies are completed and run them, until
+ * all the tasks are started or one of them failed
+ * @param unused Not used
+ * @return Always 0
+ */
+static int
+task_graph_worker (void *unused)
+{
+  Uint32 i, all;
+  const task_desc *task;
+  bool is_done;
+  (void) unused;
+  all = (graph_num_of_tasks == 32) ? 0xffffffff
+    : TASK_AFTER (graph_num_of_tasks) - 1;
+  SDL_LockMutex (graph_mutex);
+  while (!graph_failed && graph_started != all)
+    {
+      task = NULL;
+      for (i = 0; i < graph_num_of_tasks; i++)
+        {
+          if (!(graph_started & TASK_AFTER (i))
+              && (graph_tasks[i].depends & ~graph_completed) == 0)
+            {
+              task = &graph_tasks[i];
+              graph_started |= TASK_AFTER (i);
+              break;
+            }
+        }
+      if (task == NULL)
+        {
+          /* wait for a running task to complete */
+          SDL_CondWait (graph_cond, graph_mutex);
+          continue;
+        }
+      SDL_UnlockMutex (graph_mutex);
+      is_done = task->run ();
+      SDL_LockMutex (graph_mutex);
+      if (is_done)
+        {
+          graph_completed |= TASK_AFTER (i);
+        }
+      else
+        {
+          LOG_ERR ("initialization task \"%s\" failed", task->name);
+          graph_failed = TRUE;
+        }
+      SDL_CondBroadcast (graph_cond);
+    }
+  SDL_UnlockMutex (graph_mutex);
+  return 0;
+}
+
+/**
+ * Run all the tasks of a graph, a task is started as soon as all the
+ * tasks it depends on are completed. The calling thread runs tasks too
+ * @param tasks Array of tasks, a task can only depend on the
+ *              tasks which precede it in the array
+ * @param num_of_tasks Number of tasks, up to TASK_GRAPH_MAX_OF_TASKS
+ * @param num_of_threads Number of threads, including the calling one
+ * @return TRUE if all the tasks completed successfully, otherwise FALSE
+ */
+bool
+task_graph_run (const task_desc * tasks, Uint32 num_of_tasks,
+                Uint32 num_of_threads)
+{
+  Uint32 i, num_of_workers, start_time;
+  SDL_Thread *workers[TASK_GRAPH_MAX_OF_TASKS];
+  if (num_of_tasks > TASK_GRAPH_MAX_OF_TASKS)
+    {
+      LOG_ERR ("%i tasks, the maximum is %i", num_of_tasks,
+               TASK_GRAPH_MAX_OF_TASKS);
+      return FALSE;
+    }
+  /* a task which depends on a following one would never start */
+  for (i = 0; i < num_of_tasks; i++)
+    {
+      if (tasks[i].depends & ~(TASK_AFTER (i) - 1))
+        {
+          LOG_ERR ("task \"%s\" depends on a following task",
+                   tasks[i].name);
+          return FALSE;
+        }
+    }
+  start_time = SDL_GetTicks ();
+  graph_tasks = tasks;
+  graph_num_of_tasks = num_of_tasks;
+  graph_started = 0;
+  graph_completed = 0;
+  graph_failed = FALSE;
+  graph_mutex = SDL_CreateMutex ();
+  graph_cond = SDL_CreateCond ();
+  if (graph_mutex == NULL || graph_cond == NULL)
+    {
+      LOG_ERR ("SDL_CreateMutex() or SDL_CreateCond() failed: %s",
+               SDL_GetError ());
+      num_of_threads = 0;
+    }
+  if (num_of_threads > num_of_tasks)
+    {
+      num_of_threads = num_of_tasks;
+    }
+  num_of_workers = 0;
+  for (i = 1; i < num_of_threads; i++)
+    {
+      workers[num_of_workers] =
+        SDL_CreateThread (task_graph_worker, "init", NULL);
+      if (workers[num_of_workers] == NULL)
+        {
+          /* the threads already created do the work */
+          LOG_WARN ("SDL_CreateThread() failed: %s", SDL_GetError ());
+          break;
+        }
+      num_of_workers++;
+    }
+  if (graph_mutex != NULL && graph_cond != NULL)
+    {
+      task_graph_worker (NULL);
+    }
+  else
+    {
+      /* no synchronization available, run the tasks in order */
+      for (i = 0; i < num_of_tasks && !graph_failed; i++)
+        {
+          if (!tasks[i].run ())
+            {
+              LOG_ERR ("initialization task \"%s\" failed", tasks[i].name);
+              graph_failed = TRUE;
+            }
+        }
+    }
+  for (i = 0; i < num_of_workers; i++)
+    {
+      SDL_WaitThread (workers[i], NULL);
+    }
+  if (graph_cond != NULL)
+    {
+      SDL_DestroyCond (graph_cond);
+      graph_cond = NULL;
+    }
+  if (graph_mutex != NULL)
+    {
+      SDL_DestroyMutex (graph_mutex);
+      graph_mutex = NULL;
+    }
+  graph_tasks = NULL;
+  if (graph_failed)
+    {
+      return FALSE;
+    }
+  LOG_INF ("%i initialization tasks run by %i threads in %i ms",
+           num_of_tasks, num_of_workers + 1, SDL_GetTicks () - start_time);
+  return TRUE;
+}
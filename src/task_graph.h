@@ -0,0 +1,57 @@
+/**
+ * @file task_graph.h
+ * @brief Run initialization tasks in parallel according to their
+ *        dependencies
+ * @created 2026-10-18
+ * @date 2026-10-18
+ */
+/*
+ * copyright (c) 1998-2015 TLK Games all rights reserved
+ * $Id: task_graph.h,v 1.1 2026/10/18 10:00:00 gurumeditation Exp $
+ *
+ * Powermanga is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Powermanga is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+#ifndef __TASK_GRAPH__
+#define __TASK_GRAPH__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Maximum number of tasks in a graph */
+#define TASK_GRAPH_MAX_OF_TASKS 32
+/** Dependency bit of a task, from its index in the graph */
+#define TASK_AFTER(index) (1U << (index))
+
+  typedef struct task_desc
+  {
+    /** Name of the task, used in the log messages */
+    const char *name;
+    /** Function which performs the task */
+    bool (*run) (void);
+    /** Tasks which must be completed before, ORed TASK_AFTER() bits */
+    Uint32 depends;
+  } task_desc;
+
+  bool task_graph_run (const task_desc * tasks, Uint32 num_of_tasks,
+                       Uint32 num_of_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
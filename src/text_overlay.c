@@ -45,9 +45,11 @@
 #include "menu_sections.h"
 #include "meteors_phase.h"
 #include "options_panel.h"
+#include "profiler.h"
 #include "satellite_protections.h"
 #include "shockwave.h"
 #include "sdl_mixer.h"
+#include "effects_mixer.h"
 #include "spaceship.h"
 #include "texts.h"
 #include "text_overlay.h"
@@ -79,7 +81,8 @@ typedef enum
   SECTION_CREDITS,
   SECTION_VAR1,
   SECTION_CHEATS_MENU,
-  SECTION_VAR2
+  SECTION_VAR2,
+  SECTION_PROFILER
 } SECTIONS;
 
 static void draw_text (Sint32 xcoord, Sint32 ycoord, const char *string);
@@ -92,6 +95,9 @@ static void cheats_menu_check ();
 static void jump_to_level (void);
 static void jump_to_guardian (void);
 #endif
+#if defined (USE_PROFILER)
+static void draw_profiler (void);
+#endif
 static Uint32 decode (unsigned char character);
 
 static unsigned char *bitmap_font = NULL;
@@ -199,6 +205,11 @@ text_overlay_draw (void)
     case SECTION_VAR2:
       draw_variables_2 ();
       break;
+#endif
+#if defined (USE_PROFILER)
+    case SECTION_PROFILER:
+      draw_profiler ();
+      break;
 #endif
     }
 
@@ -228,6 +239,20 @@ text_overlay_draw (void)
                   text_overlay_section = SECTION_CREDITS;
                 }
             }
+#if defined (USE_PROFILER)
+          if (keys_down[K_F])
+            {
+              last_key_down = K_F;
+              if (text_overlay_section == SECTION_PROFILER)
+                {
+                  text_overlay_section = NO_SECTION;
+                }
+              else if (text_overlay_section == NO_SECTION)
+                {
+                  text_overlay_section = SECTION_PROFILER;
+                }
+            }
+#endif
 #ifdef UNDER_DEVELOPMENT
           if (keys_down[K_V])
             {
@@ -288,6 +313,15 @@ text_overlay_draw (void)
                 }
             }
         }
+#endif
+#if defined (USE_PROFILER)
+      if (text_overlay_section == SECTION_PROFILER && keys_down[K_RETURN])
+        {
+          last_key_down = K_RETURN;
+          profiler_write_trace (power_conf->profiler_trace != NULL ?
+                                power_conf->profiler_trace :
+                                PROFILER_TRACE_FILENAME);
+        }
 #endif
     }
 }
@@ -581,8 +615,8 @@ static char variables_text_1[] = {
     "  ship->fire_rate:             *@"
     "* mem-numof_zones:?????         @"
     "  mem-total-size:???????? ?????*@"
-    "* taille-mem-glob:????????      @"
-    "                               *@"
+    "* frame-alloc-max:???? ???????? @"
+    "  frames-allocating:????????   *@"
     "*  > PRESS CTRL-V TO CANCEL <   @" " * * * * * * * * * * * * * * * *@"
 };
 #endif
@@ -619,8 +653,10 @@ draw_variables_1 (void)
   integer_to_ascii (mem_numof_zones, 5, str + (33 * 17) + 17);
   integer_to_ascii (mem_total_size, 8, str + (33 * 18) + 17);
   integer_to_ascii (mem_total_size / 1024, 5, str + (33 * 18) + 26);
+  integer_to_ascii (memory_frame_max_zones, 4, str + (33 * 19) + 18);
+  integer_to_ascii (memory_frame_max_size, 8, str + (33 * 19) + 23);
+  integer_to_ascii (memory_numof_frames_allocating, 8, str + (33 * 20) + 20);
 #endif
-  /* integer_to_ascii (taille_mem_glob, 8, str + (33 * 19) + 18); */
   draw_text (0, 0, str);
 }
 #endif
@@ -635,10 +671,10 @@ static char variables_text_2[] = {
     "*                               @"
     "  sound-samples-len:           *@"
     "* difficulty:                   @"
-    "                               *@"
-    "*                               @"
-    "                               *@"
-    "*                               @"
+    "  effect-latency:          us  *@"
+    "* latency-max:             us   @"
+    "  audio-buffer:            us  *@"
+    "* late-callbacks:               @"
     "                               *@"
     "*                               @"
     "                               *@"
@@ -665,11 +701,12 @@ draw_variables_2 (void)
   bool is_sound_played;
   Sint32 offset;
   Sint32 status = 0;
+  Uint32 latency, latency_max, buffer_duration, underruns;
   char *text = variables_text_2;
   char *str = text + (33 * 2) + 2;
   for (i = 0; i < MAX_OF_CHANNELS; i++)
     {
-      if (!power_conf->nosound)
+      if (!sound_disabled)
         {
           status = Mix_Playing (i);
         }
@@ -678,6 +715,12 @@ draw_variables_2 (void)
     }
   integer_to_ascii (current_sound, 2, text + (33 * 3) + 17);
   integer_to_ascii (sound_samples_len, 8, text + (33 * 6) + 21);
+  effects_mixer_latency (&latency, &latency_max, &buffer_duration,
+                         &underruns);
+  integer_to_ascii (latency, 6, text + (33 * 8) + 20);
+  integer_to_ascii (latency_max, 6, text + (33 * 9) + 20);
+  integer_to_ascii (buffer_duration, 6, text + (33 * 10) + 20);
+  integer_to_ascii (underruns, 6, text + (33 * 11) + 20);
   is_sound_played = FALSE;
   offset = 0;
   if (keys_down[K_SHIFT])
@@ -742,7 +785,7 @@ draw_variables_2 (void)
         }
     }
   current_sound = current_sound % SOUND_NUMOF;
-  if (is_sound_played && !power_conf->nosound)
+  if (is_sound_played && !sound_disabled)
     {
       sound_play (current_sound);
     }
@@ -754,6 +797,51 @@ draw_variables_2 (void)
 }
 #endif
 
+#if defined (USE_PROFILER)
+/** Number of chars of the bars of the frame profiler */
+#define PROFILER_BAR_LENGTH 10
+/** Rows of the frame profiler: a title and the regions */
+static char profiler_text[(PROFILER_NUMOF + 1) * 33 + 1];
+
+/**
+ * Display the durations of the regions timed by the profiler with
+ * a bar graph, a full bar is the duration of a frame
+ */
+static void
+draw_profiler (void)
+{
+  profiler_stats stats[PROFILER_NUMOF];
+  char name[16];
+  char bar[PROFILER_BAR_LENGTH + 1];
+  char *row = profiler_text;
+  Uint32 i, j, average, maximum;
+  profiler_summary (stats);
+  snprintf (row, 33, "%-20s %5s %5s", "RETURN: TRACE FILE", "avg", "max");
+  row[32] = '@';
+  row += 33;
+  for (i = 0; i < PROFILER_NUMOF; i++)
+    {
+      snprintf (name, sizeof (name), "%*s%s", (Sint32) stats[i].depth, "",
+                profiler_region_name ((PROFILER_REGIONS) i));
+      average = stats[i].average * PROFILER_BAR_LENGTH /
+        (PROFILER_FRAME_BUDGET / 1000);
+      maximum = stats[i].maximum * PROFILER_BAR_LENGTH /
+        (PROFILER_FRAME_BUDGET / 1000);
+      for (j = 0; j < PROFILER_BAR_LENGTH; j++)
+        {
+          bar[j] = j < average ? '#' : j < maximum ? '-' : ' ';
+        }
+      bar[PROFILER_BAR_LENGTH] = 0;
+      snprintf (row, 33, "%-9.9s %s %5u %5u", name, bar,
+                stats[i].average > 99999 ? 99999 : stats[i].average,
+                stats[i].maximum > 99999 ? 99999 : stats[i].maximum);
+      row[32] = '@';
+      row += 33;
+    }
+  draw_text (0, 0, profiler_text);
+}
+#endif
+
 /**
  * Draw text overlay
  * @param xcoord top-left x coordinate of the text
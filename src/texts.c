@@ -549,6 +549,6 @@ texts_load (void)
             }
         }
     }
-  free_memory (filedata);
+  free_file (filedata);
   return TRUE;
 }
@@ -26,26 +26,88 @@
 #include "config.h"
 #include "mangadualist.h"
 #include "log_recorder.h"
+#include "profiler.h"
 #include "tools.h"
 #include "config_file.h"
+#include "archive.h"
+#include "arena.h"
+#include "assets_segment.h"
+#include "frame_times.h"
 #include <stdio.h>
 
+/** Maximum length of the pathnames of the data files */
+#define PATHNAME_MAXLEN 1024
 #if defined (USE_MALLOC_WRAPPER)
+/** Value of the header of an allocated memory zone */
+#define MEMORY_MAGIC 0x4d454d5a
+/** Maximum number of tags, the source files which allocate memory */
+#define MEMORY_MAX_TAGS 64
+/** Tag shared by the source files which exceed MEMORY_MAX_TAGS */
+#define MEMORY_TAG_OTHERS MEMORY_MAX_TAGS
+/** Maximum number of call sites which allocated after a level started */
+#define MEMORY_MAX_SITES 32
+/** Call site shared by the ones which exceed MEMORY_MAX_SITES */
+#define MEMORY_SITE_OTHERS MEMORY_MAX_SITES
+/** Maximum number of allocations of a frame whose call sites are kept */
+#define MEMORY_FRAME_MAX_ZONES 16
 /**
- * memory-block description structure
+ * Header stored before each memory zone, the zones being
+ * allocated are linked to report the leaks
  */
-typedef struct
+typedef struct mem_header
 {
-  /** Pointer to memory zone */
-  char *addr;
+  struct mem_header *previous;
+  struct mem_header *next;
   /** Size of memory zone in bytes */
-  Sint32 size;
-}
-mem_struct;
-mem_struct *memory_list_base = NULL;
-mem_struct *memory_list = NULL;
-/** Size of memory table */
-static Uint32 memory_list_size;
+  Uint32 size;
+  /** Index of the tag in memory_tags[] */
+  Uint32 tag;
+  /** MEMORY_MAGIC while the zone is allocated */
+  Uint32 magic;
+  /** Line of the call site in the source file */
+  Uint32 line;
+} mem_header;
+/**
+ * Size in bytes reserved for the header: 32 bytes hold it with 4 or
+ * 8 bytes pointers, the zones keep the 16 bytes alignment of calloc()
+ */
+#define MEMORY_HEADER_SIZE 32
+/** Fail to compile if the header outgrows MEMORY_HEADER_SIZE */
+typedef char mem_header_size_check[sizeof (mem_header) <=
+                                   MEMORY_HEADER_SIZE ? 1 : -1];
+/**
+ * Allocations made by a call site
+ */
+typedef struct
+{
+  /** Filename of the source file which allocates */
+  const char *name;
+  /** Line of the call site in the source file */
+  Uint32 line;
+  /** Number of memory zones allocated */
+  Uint32 numof_zones;
+  /** Size in bytes allocated */
+  Uint32 size;
+} mem_site;
+/**
+ * Memory used by a tag
+ */
+typedef struct
+{
+  /** Filename of the source file which allocates */
+  const char *name;
+  /** Number of memory zones currently allocated */
+  Uint32 numof_zones;
+  /** Size in bytes currently allocated */
+  Uint32 size;
+  /** Maximum size in bytes reached */
+  Uint32 max_size;
+} mem_tag;
+/** The memory zones being allocated */
+static mem_header *memory_list = NULL;
+/** The tags, followed by MEMORY_TAG_OTHERS once it is used */
+static mem_tag memory_tags[MEMORY_MAX_TAGS + 1];
+static Uint32 memory_numof_tags;
 /** Maximum number of memory zones being able to be allocated */
 static Uint32 mem_maxnumof_zones;
 /** Number of currently memory zones */
@@ -54,16 +116,41 @@ Uint32 mem_numof_zones;
 Uint32 mem_total_size;
 /** Maximum number of memory zones reached */
 static Uint32 mem_maxreached_zones;
+/** Serializes the accesses to the memory list */
+static SDL_mutex *memory_mutex = NULL;
+/** Thread which runs the game, the one which called memory_init() */
+static SDL_threadID memory_game_thread;
+/** TRUE while the game thread runs a frame */
+static bool memory_in_frame = FALSE;
+/** The allocations of the frame being run */
+static mem_site memory_frame_zones[MEMORY_FRAME_MAX_ZONES];
+/** The call sites which allocated after a level started */
+/** The call sites, followed by MEMORY_SITE_OTHERS once it is used */
+static mem_site memory_sites[MEMORY_MAX_SITES + 1];
+static Uint32 memory_numof_sites = 0;
+/** Number of frames run, and of the ones which allocated */
+static Uint32 memory_numof_frames = 0;
+Uint32 memory_numof_frames_allocating = 0;
+static Uint32 memory_numof_steady_allocating = 0;
+/** Number of memory zones and bytes allocated by the current frame */
+static Uint32 memory_frame_numof_zones = 0;
+static Uint32 memory_frame_size = 0;
+/** Maximum number of memory zones and bytes allocated by a frame */
+Uint32 memory_frame_max_zones = 0;
+Uint32 memory_frame_max_size = 0;
 #endif
 Uint32 loops_counter;
 #ifdef MANGADUALIST_SDL
 static Uint32 time_begin;
-static Uint32 ticks_previous;
 #else
 static struct timeval time_begin;
-static struct timeval ticks_previous;
 #endif
 static Uint16 little_endian_to_ushort (Uint16 * _pMem);
+static char *loadfile_into (arena * scope, const char *const filename,
+                            Uint32 * const fsize);
+static char *load_absolute_file_into (arena * scope,
+                                      const char *const filename,
+                                      Uint32 * const filesize);
 /** Prefixe where the data files are localised */
 static const char prefix_dir[] = PREFIX;
 float *precalc_sin = NULL;
@@ -76,7 +163,7 @@ float depix[13][32];
 float depiy[13][32];
 
 /**
- * Initialize the memory table for our malloc() wrapper
+ * Initialize our malloc() wrapper
  * @param numofzones Maximum number of memory zones
  * @return Boolean value on success or failure
  */
@@ -84,78 +171,271 @@ float depiy[13][32];
 bool
 memory_init (Uint32 numofzones)
 {
-  Uint32 i;
-  mem_struct *memlst = memory_list_base;
   /* clear number of memory zones reserved */
   mem_numof_zones = 0;
+  mem_total_size = 0;
   /* maximum number of memory zones being able to be allocated */
   mem_maxnumof_zones = numofzones;
   mem_maxreached_zones = 0;
-  memory_list_size = mem_maxnumof_zones * sizeof (mem_struct);
-  mem_total_size = memory_list_size;
-  memory_list_base = (mem_struct *) malloc (memory_list_size);
-  if (memory_list_base == NULL)
-    {
-      LOG_ERR ("malloc() failed");
+  memory_list = NULL;
+  memory_numof_tags = 0;
+  memory_game_thread = SDL_ThreadID ();
+  memory_in_frame = FALSE;
+  memory_numof_sites = 0;
+  memory_mutex = SDL_CreateMutex ();
+  if (memory_mutex == NULL)
+    {
+      LOG_ERR ("SDL_CreateMutex() failed: %s", SDL_GetError ());
       return FALSE;
     }
-  memory_list = memory_list_base;
+  return TRUE;
+}
 
-  /* clear memory table */
-  memlst = memory_list_base;
-  for (i = 0; i < mem_maxnumof_zones; i++, memlst++)
+/**
+ * Return the index of a tag, the memory mutex is locked
+ * @param name Filename of the source file which allocates
+ * @return Index of the tag, MEMORY_TAG_OTHERS for the source
+ *         files which exceed MEMORY_MAX_TAGS
+ */
+static Uint32
+memory_tag_index (const char *name)
+{
+  Uint32 i;
+  for (i = 0; i < memory_numof_tags; i++)
     {
-      memlst->addr = NULL;
-      memlst->size = 0;
+      if (memory_tags[i].name == name || !strcmp (memory_tags[i].name, name))
+        {
+          return i;
+        }
     }
-  return TRUE;
+  if (memory_numof_tags > MEMORY_MAX_TAGS)
+    {
+      return MEMORY_TAG_OTHERS;
+    }
+  if (memory_numof_tags == MEMORY_MAX_TAGS)
+    {
+      /* the shared tag follows the last one, the reports list it */
+      i = MEMORY_TAG_OTHERS;
+      name = "others";
+    }
+  memory_tags[i].name = name;
+  memory_tags[i].numof_zones = 0;
+  memory_tags[i].size = 0;
+  memory_tags[i].max_size = 0;
+  memory_numof_tags++;
+  return i;
 }
-#endif
 
 /**
- * Allocate memory, malloc() wrapper
+ * Allocate memory, malloc() wrapper, the memory is cleared
  * @param memsize Size in bytes to alloc
+ * @param tag Filename of the source file which allocates
+ * @param line Line of the call site in the source file
  * @return Pointer to the allocated memory or NULL if an error occurred
  */
 char *
-memory_allocation (Uint32 memsize)
+memory_allocation_tag (Uint32 memsize, const char *tag, Uint32 line)
 {
-  char *addr = NULL;
-#if defined (USE_MALLOC_WRAPPER)
-  if (mem_numof_zones >= mem_maxnumof_zones)
+  mem_site *site;
+  mem_header *header;
+  mem_tag *memtag;
+  header = (mem_header *) calloc (1, MEMORY_HEADER_SIZE + memsize);
+  if (header == NULL)
     {
-      LOG_ERR (" table overflow; size request %i bytes;"
+      LOG_ERR ("calloc() return NULL; size request %i bytes;"
                " total allocate: %i in %i zones",
                memsize, mem_total_size, mem_numof_zones);
       return NULL;
     }
-#endif
-  addr = (char *) malloc (memsize);
-  if (addr == NULL)
+  SDL_LockMutex (memory_mutex);
+  if (mem_numof_zones >= mem_maxnumof_zones)
     {
-#if defined (USE_MALLOC_WRAPPER)
-      LOG_ERR ("malloc() return NULL; size request %i bytes;"
+      SDL_UnlockMutex (memory_mutex);
+      free (header);
+      LOG_ERR (" table overflow; size request %i bytes;"
                " total allocate: %i in %i zones",
                memsize, mem_total_size, mem_numof_zones);
-#else
-      LOG_ERR ("malloc() return NULL; size request %i bytes", memsize);
-#endif
       return NULL;
     }
-  memset (addr, 0, sizeof (char) * memsize);
-#if defined (USE_MALLOC_WRAPPER)
+  header->size = memsize;
+  header->tag = memory_tag_index (tag);
+  header->magic = MEMORY_MAGIC;
+  header->line = line;
+  header->previous = NULL;
+  header->next = memory_list;
+  if (memory_list != NULL)
+    {
+      memory_list->previous = header;
+    }
+  memory_list = header;
+  memtag = &memory_tags[header->tag];
+  memtag->numof_zones++;
+  memtag->size += memsize;
+  if (memtag->size > memtag->max_size)
+    {
+      memtag->max_size = memtag->size;
+    }
   mem_total_size += memsize;
-  memory_list->addr = addr;
-  memory_list->size = memsize;
-  memory_list += 1;
   mem_numof_zones++;
   if (mem_numof_zones > mem_maxreached_zones)
     {
       mem_maxreached_zones = mem_numof_zones;
     }
-#endif
+  SDL_UnlockMutex (memory_mutex);
+  /* the frames are run by the game thread, only it is counted */
+  if (SDL_ThreadID () == memory_game_thread && memory_in_frame)
+    {
+      if (memory_frame_numof_zones < MEMORY_FRAME_MAX_ZONES)
+        {
+          site = &memory_frame_zones[memory_frame_numof_zones];
+          site->name = tag;
+          site->line = line;
+          site->numof_zones = 1;
+          site->size = memsize;
+        }
+      memory_frame_numof_zones++;
+      memory_frame_size += memsize;
+    }
+  return (char *) header + MEMORY_HEADER_SIZE;
+}
+
+/**
+ * Start to count the allocations of a frame
+ */
+void
+memory_frame_begin (void)
+{
+  memory_frame_numof_zones = 0;
+  memory_frame_size = 0;
+  memory_in_frame = TRUE;
+}
+
+/**
+ * Add an allocation made after a level started to its call site
+ * @param zone Allocation made during a frame
+ */
+static void
+memory_site_add (const mem_site * zone)
+{
+  Uint32 i;
+  mem_site *site;
+  for (i = 0; i < memory_numof_sites; i++)
+    {
+      site = &memory_sites[i];
+      if (site->line == zone->line && !strcmp (site->name, zone->name))
+        {
+          break;
+        }
+    }
+  if (i == memory_numof_sites)
+    {
+      if (memory_numof_sites > MEMORY_MAX_SITES)
+        {
+          i = MEMORY_SITE_OTHERS;
+        }
+      else
+        {
+          memory_sites[i] = *zone;
+          memory_sites[i].numof_zones = 0;
+          memory_sites[i].size = 0;
+          /* the shared call site follows the last one */
+          if (memory_numof_sites == MEMORY_MAX_SITES)
+            {
+              memory_sites[i].name = "others";
+              memory_sites[i].line = 0;
+            }
+          memory_numof_sites++;
+        }
+    }
+  memory_sites[i].numof_zones++;
+  memory_sites[i].size += zone->size;
+}
+
+/**
+ * Stop to count the allocations of a frame. The call sites which
+ * allocated after the level started are logged, the game is
+ * aborted if the strict mode is enabled
+ * @param is_steady TRUE if the level had started before the frame
+ *        and is still running, the frame should not allocate
+ */
+void
+memory_frame_end (bool is_steady)
+{
+  Uint32 i;
+  memory_in_frame = FALSE;
+  memory_numof_frames++;
+  if (memory_frame_numof_zones == 0)
+    {
+      return;
+    }
+  memory_numof_frames_allocating++;
+  if (memory_frame_numof_zones > memory_frame_max_zones)
+    {
+      memory_frame_max_zones = memory_frame_numof_zones;
+    }
+  if (memory_frame_size > memory_frame_max_size)
+    {
+      memory_frame_max_size = memory_frame_size;
+    }
+  if (!is_steady)
+    {
+      return;
+    }
+  memory_numof_steady_allocating++;
+  LOG_ERR_ALL ("frame %i: %i zones and %i bytes allocated after the"
+               " level started", loops_counter, memory_frame_numof_zones,
+               memory_frame_size);
+  for (i = 0; i < memory_frame_numof_zones && i < MEMORY_FRAME_MAX_ZONES;
+       i++)
+    {
+      LOG_ERR_ALL ("-> %s:%i: %i bytes", memory_frame_zones[i].name,
+                   memory_frame_zones[i].line, memory_frame_zones[i].size);
+      memory_site_add (&memory_frame_zones[i]);
+    }
+  if (power_conf->strict_allocations)
+    {
+      LOG_ERR ("strict allocation mode: the game is aborted");
+      abort ();
+    }
+}
+
+/**
+ * Report the allocations made by the frames
+ */
+void
+memory_frames_report (void)
+{
+  Uint32 i;
+  LOG_INF ("frames allocating: %i of %i; %i after the level started",
+           memory_numof_frames_allocating, memory_numof_frames,
+           memory_numof_steady_allocating);
+  LOG_INF ("maximum allocated by a frame: %i zones; %i bytes",
+           memory_frame_max_zones, memory_frame_max_size);
+  for (i = 0; i < memory_numof_sites; i++)
+    {
+      LOG_INF ("%s:%i: %i zones; %i bytes after the level started",
+               memory_sites[i].name, memory_sites[i].line,
+               memory_sites[i].numof_zones, memory_sites[i].size);
+    }
+}
+#else
+
+/**
+ * Allocate memory, malloc() wrapper, the memory is cleared
+ * @param memsize Size in bytes to alloc
+ * @return Pointer to the allocated memory or NULL if an error occurred
+ */
+char *
+memory_allocation (Uint32 memsize)
+{
+  char *addr = (char *) calloc (1, memsize);
+  if (addr == NULL)
+    {
+      LOG_ERR ("calloc() return NULL; size request %i bytes", memsize);
+    }
   return addr;
 }
+#endif
 
 /**
  * Deallocates the memory, free() wrapper
@@ -165,9 +445,8 @@ void
 free_memory (char *addr)
 {
 #if defined (USE_MALLOC_WRAPPER)
-  mem_struct *memlist;
-  mem_struct *memlist_src;
-  Uint32 i;
+  mem_header *header;
+  mem_tag *memtag;
 #endif
   if (addr == NULL)
     {
@@ -175,158 +454,282 @@ free_memory (char *addr)
       return;
     }
 #if defined (USE_MALLOC_WRAPPER)
-  memlist = memory_list_base;
-  for (i = 0; i < mem_numof_zones; i++, memlist++)
+  header = (mem_header *) (addr - MEMORY_HEADER_SIZE);
+  SDL_LockMutex (memory_mutex);
+  if (header->magic != MEMORY_MAGIC)
     {
-      /* search address */
-      if (memlist->addr == addr)
-        {
-          free (addr);
-          memlist_src = memlist + 1;
-          mem_total_size -= memlist->size;
-          mem_numof_zones--;
-          memory_list--;
-          while (i < mem_numof_zones)
-            {
-              memlist->addr = memlist_src->addr;
-              memlist->size = memlist_src->size;
-              i++;
-              memlist++;
-              memlist_src++;
-            }
-          memlist->addr = NULL;
-          memlist->size = 0;
-          addr = NULL;
-          break;
-        }
+      SDL_UnlockMutex (memory_mutex);
+      LOG_ERR ("can't release the address %p", addr);
+      return;
     }
-  if (addr != NULL)
+  header->magic = 0;
+  if (header->previous != NULL)
     {
-      LOG_ERR ("can't release the address %p", addr);
+      header->previous->next = header->next;
+    }
+  else
+    {
+      memory_list = header->next;
+    }
+  if (header->next != NULL)
+    {
+      header->next->previous = header->previous;
     }
+  memtag = &memory_tags[header->tag];
+  memtag->numof_zones--;
+  memtag->size -= header->size;
+  mem_total_size -= header->size;
+  mem_numof_zones--;
+  SDL_UnlockMutex (memory_mutex);
+  free (header);
 #else
   free (addr);
 #endif
 }
 
+#if defined (USE_MALLOC_WRAPPER)
 /**
- * Releases all memory allocated
- * @param verbose Verbose level
+ * Report the memory used by each source file and the memory zones
+ * still allocated, before the log recorder releases its own ones
  */
-#if defined (USE_MALLOC_WRAPPER)
 void
-memory_releases_all (void)
+memory_report (void)
 {
   Uint32 i;
-  char *addr;
-  mem_struct *memlist = memory_list_base;
+  SDL_LockMutex (memory_mutex);
   LOG_INF ("maximum of memory which were allocated during the game: %i",
            mem_maxreached_zones);
-  if (mem_numof_zones > 0)
+  for (i = 0; i < memory_numof_tags; i++)
     {
-      LOG_WARN ("%i zones were not released", mem_numof_zones);
-      for (i = 0; i < mem_numof_zones; i++, memlist++)
+      LOG_INF ("%s: maximum %i bytes", memory_tags[i].name,
+               memory_tags[i].max_size);
+    }
+  for (i = 0; i < memory_numof_tags; i++)
+    {
+      if (memory_tags[i].numof_zones > 0)
         {
-          addr = memlist->addr;
-          if (addr != NULL)
-            {
-              LOG_WARN ("-> free(%p); size=%i", memlist->addr, memlist->size);
-              free (addr);
-              memlist->addr = NULL;
-              memlist->size = 0;
-            }
+          LOG_INF ("%s: %i zones, %i bytes still allocated",
+                   memory_tags[i].name, memory_tags[i].numof_zones,
+                   memory_tags[i].size);
         }
     }
-  if (memory_list_base != NULL)
+  SDL_UnlockMutex (memory_mutex);
+}
+
+/**
+ * Releases all memory allocated
+ */
+void
+memory_releases_all (void)
+{
+  mem_header *header;
+  if (mem_numof_zones > 0)
+    {
+      LOG_WARN ("%i zones were not released", mem_numof_zones);
+    }
+  while (memory_list != NULL)
     {
-      free (memory_list_base);
-      memory_list_base = NULL;
+      header = memory_list;
+      memory_list = header->next;
+      LOG_WARN_ALL ("-> free(%p); size=%i; %s:%i",
+                    (char *) header + MEMORY_HEADER_SIZE, header->size,
+                    memory_tags[header->tag].name, header->line);
+      free (header);
     }
   mem_numof_zones = 0;
+  mem_total_size = 0;
+  memory_numof_tags = 0;
+  if (memory_mutex != NULL)
+    {
+      SDL_DestroyMutex (memory_mutex);
+      memory_mutex = NULL;
+    }
 }
 #endif
 
 /**
- * Load and decompress a PCX file
+ * Fill pixels with a color
+ * @param dest Pointer to the first pixel
+ * @param val Index of the color
+ * @param count Number of pixels to fill
+ * @param depth Number of bytes per pixel, 1 to 4
+ * @param colors Pixel values of the 256 colors, see pcx_decode()
+ * @return Pointer to the pixel following the last one filled
+ */
+static char *
+pcx_fill (char *dest, unsigned char val, Uint32 count, Uint32 depth,
+          const void *colors)
+{
+  Uint16 pixel16, *dest16;
+  Uint32 pixel32, *dest32;
+  const char *pixel24;
+  switch (depth)
+    {
+    case 1:
+      memset (dest, val, count);
+      return dest + count;
+    case 2:
+      pixel16 = ((const Uint16 *) colors)[val];
+      dest16 = (Uint16 *) dest;
+      while (count--)
+        {
+          *dest16++ = pixel16;
+        }
+      return (char *) dest16;
+    case 3:
+      /* the first 3 bytes of the 32-bit pixel, as conv8_24() */
+      pixel24 = (const char *) ((const Uint32 *) colors + val);
+      while (count--)
+        {
+          *dest++ = pixel24[0];
+          *dest++ = pixel24[1];
+          *dest++ = pixel24[2];
+        }
+      return dest;
+    default:
+      pixel32 = ((const Uint32 *) colors)[val];
+      dest32 = (Uint32 *) dest;
+      while (count--)
+        {
+          *dest32++ = pixel32;
+        }
+      return (char *) dest32;
+    }
+}
+
+/**
+ * Decompress the RLE pixels of a PCX file, each run is written at
+ * once with the pixel value of its color
+ * @param data Pointer to the compressed pixels
+ * @param end Pointer to the end of the compressed pixels
+ * @param dest Pointer to the destination buffer
+ * @param num_of_pixels Number of pixels of the image
+ * @param depth Number of bytes per pixel of the destination, 1 to 4
+ * @param colors Pixel values of the 256 colors: Uint16 for 2 bytes
+ *               per pixel, Uint32 for 3 or 4, unused for 1
+ */
+static void
+pcx_decode (const unsigned char *data, const unsigned char *end,
+            char *dest, Uint32 num_of_pixels, Uint32 depth,
+            const void *colors)
+{
+  Uint32 count;
+  unsigned char val;
+  while (num_of_pixels > 0 && data < end)
+    {
+      if ((*data & 0xC0) == 0xC0)
+        {
+          count = *data++ & 0x3F;
+          if (data >= end)
+            {
+              break;
+            }
+        }
+      else
+        {
+          count = 1;
+        }
+      val = *data++;
+      /* the bounds are checked once per run */
+      if (count > num_of_pixels)
+        {
+          count = num_of_pixels;
+        }
+      dest = pcx_fill (dest, val, count, depth, colors);
+      num_of_pixels -= count;
+    }
+  /* the pixels missing from a truncated file get the color 0 */
+  pcx_fill (dest, 0, num_of_pixels, depth, colors);
+}
+
+/**
+ * Load and decompress a 8-bit PCX file, the pixels are converted to
+ * the destination depth while decompressing
  * @param filename Filename specified by path
- * @return Pointer to a bitmap_desc structure or null if an error occurred 
+ * @param dest Pointer to the buffer which receives the pixels, large
+ *             enough for the image, or NULL to allocate it
+ * @param depth Number of bytes per pixel of the destination, 1 to 4
+ * @param colors Pixel values of the 256 colors: Uint16 for 2 bytes
+ *               per pixel, Uint32 for 3 or 4, unused for 1
+ * @param width Pointer to the width of the image, or NULL
+ * @param height Pointer to the height of the image, or NULL
+ * @return Pointer to the pixels or NULL if an error occurred
  */
-bitmap_desc *
-load_pcx (const char *filename)
+char *
+load_pcx_pixels (const char *filename, char *dest, Uint32 depth,
+                 const void *colors, Uint32 * width, Uint32 * height)
 {
-  Uint32 width, height, depth, size, ptr;
+  Uint32 w, h, size;
   Uint16 *ptr16;
-  unsigned char numof_bytes;
-  unsigned char val;
-  Uint32 i, j, total;
-  unsigned char *filedata, *pixel;
-  bitmap_desc *bmp;
+  unsigned char *filedata;
+  char *pixels;
   filedata = (unsigned char *) loadfile (filename, &size);
   if (filedata == NULL)
     {
       return NULL;
     }
+  if (size < 128 + 768 || filedata[3] != 8)
+    {
+      LOG_ERR ("%s is not a 8-bit PCX file", filename);
+      free_file ((char *) filedata);
+      return NULL;
+    }
   ptr16 = (Uint16 *) filedata;
-  width = (little_endian_to_ushort (ptr16 + 4)
-           - little_endian_to_ushort (ptr16 + 2)) + 1;
-  height = (little_endian_to_ushort (ptr16 + 5)
-            - little_endian_to_ushort (ptr16 + 3)) + 1;
-  /* bits per pixel */
-  depth = filedata[3];
+  w = (little_endian_to_ushort (ptr16 + 4)
+       - little_endian_to_ushort (ptr16 + 2)) + 1;
+  h = (little_endian_to_ushort (ptr16 + 5)
+       - little_endian_to_ushort (ptr16 + 3)) + 1;
+  pixels = dest;
+  if (pixels == NULL)
+    {
+      pixels = memory_allocation (w * h * depth);
+      if (pixels == NULL)
+        {
+          LOG_ERR ("not enough memory to allocate %i bytes", w * h * depth);
+          free_file ((char *) filedata);
+          return NULL;
+        }
+    }
+  pcx_decode (filedata + 128, filedata + size - 768, pixels, w * h, depth,
+              colors);
+  free_file ((char *) filedata);
+  if (width != NULL)
+    {
+      *width = w;
+    }
+  if (height != NULL)
+    {
+      *height = h;
+    }
+  LOG_DBG ("filename: \"%s\"; height:%i; width:%i; depth:%i", filename,
+           h, w, depth);
+  return pixels;
+}
 
-  /* allocate bitmap description structure memory */
+/**
+ * Load and decompress a PCX file
+ * @param filename Filename specified by path
+ * @return Pointer to a bitmap_desc structure or null if an error occurred 
+ */
+bitmap_desc *
+load_pcx (const char *filename)
+{
+  bitmap_desc *bmp;
   bmp = (bitmap_desc *) memory_allocation (sizeof (bitmap_desc));
   if (bmp == NULL)
     {
       LOG_ERR ("not enough memory to allocate 'bmp'");
       return NULL;
     }
-  bmp->width = width;
-  bmp->height = height;
-  bmp->depth = depth;
-  bmp->size = width * height * (depth >> 3);
-  /* allocate bitmap memory */
-  bmp->pixel = memory_allocation (bmp->size);
+  bmp->pixel =
+    load_pcx_pixels (filename, NULL, 1, NULL, &bmp->width, &bmp->height);
   if (bmp->pixel == NULL)
     {
-      LOG_ERR ("height=%i / width=%i", filename, width, height);
-      LOG_ERR ("not enough memory to allocate %i bytes", bmp->size);
       free_memory ((char *) bmp);
       return NULL;
     }
-  /* decompress rle */
-  pixel = (unsigned char *) bmp->pixel;
-  total = 0;
-  i = size - 768;
-  ptr = 128;
-  while (ptr < i)
-    {
-      if ((filedata[ptr] & 0xC0) == 0xC0)
-        {
-          numof_bytes = filedata[ptr] & 0x3F;
-          ptr++;
-        }
-      else
-        {
-          numof_bytes = 1;
-        }
-      val = filedata[ptr];
-      /* bug fixed by Samuel Hocevar */
-      total += numof_bytes;
-      if (total >= bmp->size)
-        {
-          break;
-        }
-      for (j = 0; j < numof_bytes; j++)
-        {
-          *pixel = val;
-          pixel++;
-        }
-      ptr++;
-    }
-  free_memory ((char *) filedata);
-  LOG_DBG ("filename: \"%s\"; height:%i; width:%i; size:%i bytes", filename,
-           width, height, bmp->size);
+  bmp->depth = 8;
+  bmp->size = bmp->width * bmp->height;
   return bmp;
 }
 
@@ -475,105 +878,102 @@ static const char *data_directories[] = {
 };
 
 /**
- * Locate a file under one of the data directories
+ * Build the pathname of a file under one of the data directories
  * @param name Name of file relative to data directory
- * @return Pointer to a malloc'd buffer containing the name under which the
- * file was found (free()-ing the buffer is the responsibility of the caller.)
- * or NULL if could not locate file (not found, or not enough memory, or the
- * name given was absolute)
+ * @param pathname Buffer of PATHNAME_MAXLEN bytes where the name under
+ *        which the file was found is written, an absolute name is copied
+ * @return TRUE if the file was found or FALSE otherwise
  * @author Andre Majorel
  */
-char *
-locate_data_file (const char *const name)
+static bool
+data_file_pathname (const char *const name, char *pathname)
 {
-  static const char bogus = '\0';
-  static const char *home_dir;
   const char **p;
-  char *pathname;
+  const char *home_dir;
   struct stat s;
+  Sint32 len;
   const char *subdir = "/share/games/mangadualist/";
 
   if (name == NULL)
     {
       LOG_ERR ("NULL pointer was passed as an argument!");
-      return NULL;
+      return FALSE;
     }
-  /* if absolute path, return a pointer to a duplicate string */
   if (*name == '/')
     {
-      return string_duplicate (name);
+      len = snprintf (pathname, PATHNAME_MAXLEN, "%s", name);
+      return len >= 0 && len < PATHNAME_MAXLEN;
     }
   /* process each folder of the list */
   for (p = data_directories;; p++)
     {
       if (*p == 0)
         {
-          pathname =
-            memory_allocation (strlen (prefix_dir) + strlen (subdir) +
-                               strlen (name) + 1);
-          if (pathname == NULL)
-            {
-              fflush (stdout);
-              LOG_ERR ("not enough memory");
-              return NULL;
-            }
-          strcpy (pathname, prefix_dir);
-          strcat (pathname, subdir);
-          strcat (pathname, name);
+          len = snprintf (pathname, PATHNAME_MAXLEN, "%s%s%s", prefix_dir,
+                          subdir, name);
         }
       /* not user anymore */
       else if (**p == '~')
         {
-          home_dir = &bogus;
-          if (home_dir == &bogus)
-            {
-              home_dir = getenv ("HOME");
-            }
+          home_dir = getenv ("HOME");
           if (home_dir == 0)
             {
               /* $HOME not set. Skip this directory */
               continue;
             }
-          pathname = memory_allocation (strlen (home_dir)
-                                        + 1 + strlen (*p + 1) + 1 +
-                                        strlen (name) + 1);
-          if (pathname == NULL)
-            {
-              fflush (stdout);
-              LOG_ERR ("not enough memory");
-              return NULL;
-            }
-          strcpy (pathname, home_dir);
-          strcat (pathname, *p + 1);
-          strcat (pathname, "/");
-          strcat (pathname, name);
+          len = snprintf (pathname, PATHNAME_MAXLEN, "%s%s/%s", home_dir,
+                          *p + 1, name);
         }
       else
         {
           /* check if the file is located in current directory */
-          pathname = memory_allocation (strlen (*p) + 1 + strlen (name) + 1);
-          if (pathname == NULL)
-            {
-              fflush (stdout);
-              LOG_ERR ("not enough memory");
-              return NULL;
-            }
-          strcpy (pathname, *p);
-          strcat (pathname, "/");
-          strcat (pathname, name);
+          len = snprintf (pathname, PATHNAME_MAXLEN, "%s/%s", *p, name);
+        }
+      if (len < 0 || len >= PATHNAME_MAXLEN)
+        {
+          LOG_ERR ("pathname of %s is too long", name);
         }
-      if (stat (pathname, &s) == 0 && !S_ISDIR (s.st_mode))
+      else if (stat (pathname, &s) == 0 && !S_ISDIR (s.st_mode))
         {
-          return pathname;
+          return TRUE;
         }
-      free_memory (pathname);
       if (*p == 0)
         {
           break;
         }
     }
   /* not found */
-  return NULL;
+  return FALSE;
+}
+
+/**
+ * Locate a file under one of the data directories
+ * @param name Name of file relative to data directory
+ * @return Pointer to a malloc'd buffer containing the name under which the
+ * file was found (free()-ing the buffer is the responsibility of the caller.)
+ * or NULL if could not locate file (not found, or not enough memory, or the
+ * name given was absolute)
+ * @author Andre Majorel
+ */
+char *
+locate_data_file (const char *const name)
+{
+  char pathname[PATHNAME_MAXLEN];
+  if (name == NULL)
+    {
+      LOG_ERR ("NULL pointer was passed as an argument!");
+      return NULL;
+    }
+  /* if absolute path, return a pointer to a duplicate string */
+  if (*name == '/')
+    {
+      return string_duplicate (name);
+    }
+  if (!data_file_pathname (name, pathname))
+    {
+      return NULL;
+    }
+  return string_duplicate (pathname);
 }
 
 
@@ -598,29 +998,46 @@ load_file (const char *const filename)
 char *
 loadfile_with_lang (const char *const filename, Uint32 * const fsize)
 {
-  const char *lang;
-  char *data, *fname;
+  char fname[PATHNAME_MAXLEN];
+  Sint32 len;
   if (filename == NULL || strlen (filename) == 0)
     {
       LOG_ERR ("filename is a NULL string");
       return NULL;
     }
-
-  fname = memory_allocation (strlen (filename) + 1);
-  if (fname == NULL)
+  len = snprintf (fname, PATHNAME_MAXLEN, filename, configfile_get_lang ());
+  if (len < 0 || len >= PATHNAME_MAXLEN)
     {
-      LOG_ERR ("filename: \"%s\" not enough memory"
-               " to allocate %i bytes", filename,
-               (Uint32) (strlen (filename) + 1));
+      LOG_ERR ("filename: \"%s\" is too long", filename);
       return NULL;
     }
-  strcpy (fname, filename);
-  lang = configfile_get_lang ();
-  sprintf (fname, filename, lang);
   LOG_DBG ("file \"%s\" was loaded in memory", fname);
-  data = loadfile (fname, fsize);
-  free_memory (fname);
-  return data;
+  return loadfile (fname, fsize);
+}
+
+/**
+ * Write a filename with a number into a buffer
+ * @param filename Filename specified by path
+ * @param num Interger to convert in string
+ * @param fname Buffer of PATHNAME_MAXLEN bytes
+ * @return TRUE if it completed successfully or FALSE otherwise
+ */
+static bool
+filename_with_num (const char *const filename, Sint32 num, char *fname)
+{
+  Sint32 len;
+  if (filename == NULL || strlen (filename) == 0)
+    {
+      LOG_ERR ("filename is a NULL string");
+      return FALSE;
+    }
+  len = snprintf (fname, PATHNAME_MAXLEN, filename, num);
+  if (len < 0 || len >= PATHNAME_MAXLEN)
+    {
+      LOG_ERR ("filename: \"%s\"; num: %i; is too long", filename, num);
+      return FALSE;
+    }
+  return TRUE;
 }
 
 /**
@@ -632,55 +1049,98 @@ loadfile_with_lang (const char *const filename, Uint32 * const fsize)
 char *
 loadfile_num (const char *const filename, Sint32 num)
 {
-  char *data, *fname;
-
-  if (filename == NULL || strlen (filename) == 0)
+  char fname[PATHNAME_MAXLEN];
+  if (!filename_with_num (filename, num, fname))
     {
-      LOG_ERR ("filename is a NULL string");
       return NULL;
     }
+  LOG_DBG ("file \"%s\" was loaded in memory", fname);
+  return load_file (fname);
+}
 
-  fname = memory_allocation (strlen (filename) + 1);
-  if (fname == NULL)
+/**
+ * Load a file (filename with a number) into an arena, the data are
+ * released with arena_release() instead of free_file()
+ * @param scope Arena where the file is loaded
+ * @param filename Filename specified by path
+ * @param num Interger to convert in string
+ * @return Pointer to the file data
+ */
+char *
+loadfile_num_into_arena (struct arena *scope, const char *const filename,
+                         Sint32 num)
+{
+  char fname[PATHNAME_MAXLEN];
+  Uint32 fsize;
+  if (!filename_with_num (filename, num, fname))
     {
-      LOG_ERR ("filename: \"%s\"; num: %i; "
-               "not enough memory to allocate %i bytes",
-               filename, num, (Uint32) (strlen (filename) + 1));
       return NULL;
     }
-  sprintf (fname, filename, num);
-  LOG_DBG ("file \"%s\" was loaded in memory", fname);
-  data = load_file (fname);
-  free_memory (fname);
-  return data;
+  return loadfile_into (scope, fname, &fsize);
 }
 
 /**
- * Allocate memory and load a file there
+ * Allocate memory and load a file there, or return the file read-only
+ * from the archive if one is mapped. The buffer must be released with
+ * free_file()
  * @param filename the file which should be loaded
  * @param fsize pointer on the size of file which will be loaded
  * @return file data buffer pointer
  */
 char *
 loadfile (const char *const filename, Uint32 * const fsize)
+{
+  return loadfile_into (NULL, filename, fsize);
+}
+
+/**
+ * Load a file into an arena or into an allocated memory, or return
+ * the file read-only from the archive if one is mapped
+ * @param scope Arena where the file is loaded, NULL to allocate memory
+ * @param filename the file which should be loaded
+ * @param fsize pointer on the size of file which will be loaded
+ * @return file data buffer pointer
+ */
+static char *
+loadfile_into (arena * scope, const char *const filename,
+               Uint32 * const fsize)
 {
   char *buffer;
-  char *pathname = locate_data_file (filename);
-  if (pathname == NULL)
+  char pathname[PATHNAME_MAXLEN];
+  buffer = archive_find (filename, fsize);
+  if (buffer != NULL)
+    {
+      assets_segment_source (filename, NULL, buffer, *fsize);
+      return buffer;
+    }
+  if (!data_file_pathname (filename, pathname))
     {
       LOG_ERR ("can't locate file %s", filename);
       return NULL;
     }
-  buffer = load_absolute_file (pathname, fsize);
-  if (buffer == NULL)
+  buffer = load_absolute_file_into (scope, pathname, fsize);
+  if (buffer != NULL)
     {
-      free_memory (pathname);
-      return NULL;
+      assets_segment_source (filename, pathname, buffer, *fsize);
     }
-  free_memory (pathname);
   return buffer;
 }
 
+/**
+ * Release a file loaded by loadfile(), the files
+ * read from the archive mapping are left in place
+ * @param filedata file data buffer pointer
+ */
+void
+free_file (char *filedata)
+{
+  if (archive_contains (filedata))
+    {
+      return;
+    }
+  free_memory (filedata);
+}
+
 
 /**
  * Getting size of a file
@@ -709,10 +1169,25 @@ get_file_size (FILE * fstream)
  */
 char *
 load_absolute_file (const char *const filename, Uint32 * const filesize)
+{
+  return load_absolute_file_into (NULL, filename, filesize);
+}
+
+/**
+ * Load a file into an arena or into an allocated memory
+ * @param scope Arena where the file is loaded, NULL to allocate memory
+ * @param filename the file which should be loaded
+ * @param fsize pointer on the size of file which will be loaded
+ * @return file data buffer pointer
+ */
+static char *
+load_absolute_file_into (arena * scope, const char *const filename,
+                         Uint32 * const filesize)
 {
   size_t fsize;
   FILE *fstream;
   char *buffer;
+  Uint32 mark = 0;
   fstream = fopen (filename, "r");
   if (fstream == NULL)
     {
@@ -727,7 +1202,15 @@ load_absolute_file (const char *const filename, Uint32 * const filesize)
       LOG_ERR ("file %s is empty!", filename);
       return NULL;
     }
-  buffer = memory_allocation (fsize);
+  if (scope != NULL)
+    {
+      mark = arena_mark (scope);
+      buffer = arena_alloc (scope, fsize);
+    }
+  else
+    {
+      buffer = memory_allocation (fsize);
+    }
   if (buffer == NULL)
     {
       LOG_ERR ("not enough memory to allocate %i bytes!",
@@ -737,7 +1220,14 @@ load_absolute_file (const char *const filename, Uint32 * const filesize)
     }
   if (fread (buffer, sizeof (char), fsize, fstream) != fsize)
     {
-      free_memory (buffer);
+      if (scope != NULL)
+        {
+          arena_release (scope, mark);
+        }
+      else
+        {
+          free_memory (buffer);
+        }
       LOG_ERR ("can't read file \"%s\" (%s)", filename, strerror (errno));
       fclose (fstream);
       return NULL;
@@ -758,8 +1248,15 @@ loadfile_into_buffer (const char *const filename, char *const buffer)
 {
   size_t fsize;
   FILE *fstream;
-  char *pathname = locate_data_file (filename);
-  if (pathname == NULL)
+  Uint32 size;
+  char pathname[PATHNAME_MAXLEN];
+  const char *filedata = archive_find (filename, &size);
+  if (filedata != NULL)
+    {
+      memcpy (buffer, filedata, size);
+      return TRUE;
+    }
+  if (!data_file_pathname (filename, pathname))
     {
       LOG_ERR ("can't locate file: '%s'", filename);
       return FALSE;
@@ -768,7 +1265,6 @@ loadfile_into_buffer (const char *const filename, char *const buffer)
   if (fstream == NULL)
     {
       LOG_ERR ("can't open \"%s\" file (%s)", pathname, strerror (errno));
-      free_memory (pathname);
       return FALSE;
     }
   fsize = get_file_size (fstream);
@@ -782,12 +1278,10 @@ loadfile_into_buffer (const char *const filename, char *const buffer)
     {
       LOG_ERR ("can't read \"%s\" file (%s)", pathname, strerror (errno));
       fclose (fstream);
-      free_memory (pathname);
       return FALSE;
     }
   fclose (fstream);
   LOG_DBG ("\"%s\" file was loaded in memory", pathname);
-  free_memory (pathname);
   return TRUE;
 }
 
@@ -820,23 +1314,23 @@ file_write (const char *filename, const char *filedata, const size_t filesize)
 }
 
 /**
- * Initialize ticks counters
+ * Initialize ticks counters and the histograms of the frames
  */
 void
 fps_init (void)
 {
+  frame_times_reset ();
 #ifdef MANGADUALIST_SDL
   time_begin = SDL_GetTicks ();
-  ticks_previous = SDL_GetTicks ();
 #else
   gettimeofday (&time_begin, NULL);
-  gettimeofday (&ticks_previous, NULL);
 #endif
   loops_counter = 0;
 }
 
 /**
- * Draw informations on framerate and Linux system
+ * Draw informations on framerate and Linux system, and the
+ * percentiles of the durations of the frames
  */
 void
 fps_print (void)
@@ -921,75 +1415,18 @@ fps_print (void)
   LOG_INF ("running time     : %li", duration);
   LOG_INF ("frames per second: %g", fps);
 #endif
-}
-
-/**
- * Sleep for a time interval
- * @input delay
- * @return
- */
-Sint32
-wait_next_frame (Sint32 delay, Sint32 max)
-{
-#ifdef MANGADUALIST_SDL
-  if (delay > max)
-    {
-      delay = max;
-    }
-  if (delay > 0)
-    {
-      SDL_Delay (delay);
-    }
-  return (delay > 0 ? delay : 0);
-#else
-  struct timeval temps;
-  if (delay > max)
-    {
-      delay = max;
-    }
-  if (delay > 0)
+  frame_times_print ();
+  if (power_conf->frame_times != NULL)
     {
-      temps.tv_usec = delay % (unsigned long) 1000000;
-      temps.tv_sec = delay / (unsigned long) 1000000;
-      select (0, NULL, NULL, NULL, &temps);
+      frame_times_write (power_conf->frame_times);
     }
-  return (delay > 0 ? delay : 0);
+#if defined (USE_MALLOC_WRAPPER)
+  memory_frames_report ();
 #endif
-}
-
-#ifdef MANGADUALIST_SDL
-/**
- * Calculate diffence between 2 times
- * @return difference
- */
-Sint32
-get_time_difference ()
-{
-  Sint32 diff;
-  Uint32 current_ticks;
-  current_ticks = SDL_GetTicks ();
-  diff = current_ticks - ticks_previous;
-  ticks_previous = current_ticks;
-  return diff;
-}
-#else
-/**
- * Calculate diffence between 2 times
- * @return difference
- */
-Sint32
-get_time_difference ()
-{
-  struct timeval current_ticks;
-  Sint32 diff;
-  gettimeofday (&current_ticks, NULL);
-  diff =
-    (1000000 * (current_ticks.tv_sec - ticks_previous.tv_sec)) +
-    (current_ticks.tv_usec - ticks_previous.tv_usec);
-  ticks_previous = current_ticks;
-  return diff;
-}
+#if defined (USE_PROFILER)
+  profiler_print_counters ();
 #endif
+}
 
 /**
  * Check if a value is null, signed or unsigned
@@ -1093,6 +1530,25 @@ string_duplicate (register const char *str)
   return new_str;
 }
 
+/**
+ * Fold a memory block into a 32-bit FNV-1a hash
+ * @param hash Current hash value, HASH_FNV1A_INIT for a new hash
+ * @param data Pointer to the data to fold
+ * @param size Size of the data in bytes
+ * @return The updated hash value
+ */
+Uint32
+hash_fnv1a (Uint32 hash, const void *data, Uint32 size)
+{
+  const unsigned char *ptr = (const unsigned char *) data;
+  while (size-- > 0)
+    {
+      hash ^= *(ptr++);
+      hash *= 16777619U;
+    }
+  return hash;
+}
+
 /**
  * Allocate and precalculate sinus and cosinus curves 
  * @return TRUE if it completed successfully or FALSE otherwise
@@ -33,6 +33,8 @@ extern "C"
 
 #define TRUE                   1
 #define FALSE                  0
+/** Initial value of a FNV-1a hash */
+#define HASH_FNV1A_INIT        2166136261U
 
   /** Data structure of a graphic image */
   typedef struct
@@ -53,13 +55,26 @@ extern "C"
 
 #if defined (USE_MALLOC_WRAPPER)
   bool memory_init (Uint32 numofzones);
-#endif
+  char *memory_allocation_tag (Uint32 size, const char *tag, Uint32 line);
+/** The memory used is counted for each source file, and the
+ * allocations of the frames for each call site */
+#define memory_allocation(size) \
+  memory_allocation_tag ((size), __FILE__, __LINE__)
+#else
   char *memory_allocation (Uint32 size);
+#endif
   void free_memory (char *addr);
 #if defined (USE_MALLOC_WRAPPER)
+  void memory_frame_begin (void);
+  void memory_frame_end (bool is_steady);
+  void memory_frames_report (void);
+  void memory_report (void);
   void memory_releases_all (void);
 #endif
   bitmap_desc *load_pcx (const char *);
+  char *load_pcx_pixels (const char *filename, char *dest, Uint32 depth,
+                         const void *colors, Uint32 * width,
+                         Uint32 * height);
   Sint16 little_endian_to_short (Sint16 * addr);
   Sint32 little_endian_to_int (Sint32 * addr);
   void int_to_little_endian (Sint32 value, Sint32 * addr);
@@ -69,7 +84,11 @@ extern "C"
   char *load_file (const char *const filename);
   char *loadfile_with_lang (const char *const filename, Uint32 * const fsize);
   char *loadfile_num (const char *const filename, Sint32 num);
+  struct arena;
+  char *loadfile_num_into_arena (struct arena *scope,
+                                 const char *const filename, Sint32 num);
   char *loadfile (const char *const filename, Uint32 * const size);
+  void free_file (char *filedata);
   size_t get_file_size (FILE * fstream);
   char *load_absolute_file (const char *const filename, Uint32 * const fsize);
   bool loadfile_into_buffer (const char *const filename, char *const buffer);
@@ -77,13 +96,12 @@ extern "C"
                    const size_t filesize);
   void fps_init (void);
   void fps_print (void);
-  Sint32 wait_next_frame (Sint32 delay, Sint32 max);
-  Sint32 get_time_difference (void);
   Sint16 sign (float);
   float calc_target_angle (Sint16 pxs, Sint16 pys, Sint16 pxd, Sint16 pyd);
   float get_new_angle (float old_angle, float new_angle, float agilite);
   bool create_dir (const char *dirname);
   char *string_duplicate (register const char *str);
+  Uint32 hash_fnv1a (Uint32 hash, const void *data, Uint32 size);
   bool alloc_precalulate_sinus (void);
   void free_precalulate_sinus (void);
   FILE *fopen_data (const char *fname, const char *fmode);
@@ -97,6 +115,9 @@ extern "C"
 #if defined (USE_MALLOC_WRAPPER)
   extern Uint32 mem_numof_zones;
   extern Uint32 mem_total_size;
+  extern Uint32 memory_frame_max_zones;
+  extern Uint32 memory_frame_max_size;
+  extern Uint32 memory_numof_frames_allocating;
 #endif
 
 #ifdef __cplusplus